@@ -1,8 +1,11 @@
 
 #pragma once
 
+#include <optional>
 #include <vector>
 #include "CLUEstering/CLUEstering.hpp"
+#include "CLUEstering/CLUEsteringDynamic.hpp"
+#include "CLUEstering/AlpakaCore/getQueue.hpp"
 
 namespace ALPAKA_ACCELERATOR_NAMESPACE_CLUE {
 
@@ -25,4 +28,40 @@ namespace ALPAKA_ACCELERATOR_NAMESPACE_CLUE {
     algo.make_clusters(h_points, d_points, kernel, queue_, block_size);
   }
 
+  // number of leading coordinates used for tiling the points when their
+  // dimensionality is only known at runtime
+  constexpr uint8_t dynamic_tiling_dims{2};
+
+  template <typename Kernel>
+  void run_dynamic(float dc,
+                   float rhoc,
+                   float dm,
+                   int pPBin,
+                   std::tuple<float*, int*>&& pData,
+                   int32_t ndim,
+                   uint32_t n_points,
+                   clue::Projection projection,
+                   const std::optional<clue::LSHParameters>& lsh,
+                   const Kernel& kernel,
+                   Queue queue_,
+                   size_t block_size) {
+    CLUEAlgoAlpakaDynamic<dynamic_tiling_dims> algo(dc, rhoc, dm, pPBin);
+    // the points can be tiled on a projection, like the principal components, which
+    // usually separates them better than the leading coordinates but costs a pass
+    // over all the coordinates
+    algo.setProjection(projection);
+    // or the neighbours can be searched approximately with locality-sensitive hashing
+    if (lsh.has_value()) {
+      algo.useLSH(*lsh);
+    }
+
+    algo.make_clusters(std::get<0>(pData),
+                       std::get<1>(pData),
+                       ndim,
+                       n_points,
+                       kernel,
+                       queue_,
+                       block_size);
+  }
+
 };  // namespace ALPAKA_ACCELERATOR_NAMESPACE_CLUE
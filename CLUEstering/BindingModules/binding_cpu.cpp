@@ -1,5 +1,7 @@
 
 #include <alpaka/alpaka.hpp>
+#include <optional>
+#include <stdexcept>
 #include <tuple>
 #include <vector>
 
@@ -15,7 +17,7 @@ namespace py = pybind11;
 namespace alpaka_serial_sync {
   void listDevices(const std::string& backend) {
     const char tab = '\t';
-    const std::vector<Device> devices = alpaka::getDevs(alpaka::Platform<Acc1D>());
+    const auto& devices = clue::devices<Platform>();
     if (devices.empty()) {
       std::cout << "No devices found for the " << backend << " backend." << std::endl;
       return;
@@ -27,16 +29,21 @@ namespace alpaka_serial_sync {
     }
   }
 
-  template <typename Kernel>
+  // All the kernels are passed as a RuntimeKernel, so that the algorithm is
+  // instantiated once for each dimensionality
   void mainRun(float dc,
                float rhoc,
                float dm,
                int pPBin,
                py::array_t<float> data,
                py::array_t<int> results,
-               const Kernel& kernel,
+               const RuntimeKernel& kernel,
                int Ndim,
                uint32_t n_points,
+               int projection,
+               int lsh_tables,
+               int lsh_hashes,
+               float lsh_bucket_width,
                size_t block_size,
                size_t device_id) {
     auto rData = data.request();
@@ -44,125 +51,156 @@ namespace alpaka_serial_sync {
     auto rResults = results.request();
     int* pResults = static_cast<int*>(rResults.ptr);
 
-    const auto dev_acc = alpaka::getDevByIdx(alpaka::Platform<Acc1D>{}, device_id);
+    auto queue_ = clue::getQueue<Platform, Queue>(device_id);
 
-    // Create the queue
-    Queue queue_(dev_acc);
+    // the neighbours can only be searched with locality-sensitive hashing by the
+    // algorithm with a runtime number of dimensions
+    if (lsh_tables > 0) {
+      const clue::LSHParameters lsh{lsh_tables, lsh_hashes, lsh_bucket_width};
+      run_dynamic<RuntimeKernel>(dc,
+                                 rhoc,
+                                 dm,
+                                 pPBin,
+                                 std::make_tuple(pData, pResults),
+                                 Ndim,
+                                 n_points,
+                                 static_cast<clue::Projection>(projection),
+                                 lsh,
+                                 kernel,
+                                 queue_,
+                                 block_size);
+      return;
+    }
 
     // Running the clustering algorithm //
     switch (Ndim) {
       [[unlikely]] case (1):
-        run<1, Kernel>(dc,
-                       rhoc,
-                       dm,
-                       pPBin,
-                       std::make_tuple(pData, pResults),
-                       PointInfo<1>{n_points},
-                       kernel,
-                       queue_,
-                       block_size);
+        run<1, RuntimeKernel>(dc,
+                              rhoc,
+                              dm,
+                              pPBin,
+                              std::make_tuple(pData, pResults),
+                              PointInfo<1>{n_points},
+                              kernel,
+                              queue_,
+                              block_size);
         return;
       [[likely]] case (2):
-        run<2, Kernel>(dc,
-                       rhoc,
-                       dm,
-                       pPBin,
-                       std::make_tuple(pData, pResults),
-                       PointInfo<2>{n_points},
-                       kernel,
-                       queue_,
-                       block_size);
+        run<2, RuntimeKernel>(dc,
+                              rhoc,
+                              dm,
+                              pPBin,
+                              std::make_tuple(pData, pResults),
+                              PointInfo<2>{n_points},
+                              kernel,
+                              queue_,
+                              block_size);
         return;
       [[likely]] case (3):
-        run<3, Kernel>(dc,
-                       rhoc,
-                       dm,
-                       pPBin,
-                       std::make_tuple(pData, pResults),
-                       PointInfo<3>{n_points},
-                       kernel,
-                       queue_,
-                       block_size);
+        run<3, RuntimeKernel>(dc,
+                              rhoc,
+                              dm,
+                              pPBin,
+                              std::make_tuple(pData, pResults),
+                              PointInfo<3>{n_points},
+                              kernel,
+                              queue_,
+                              block_size);
         return;
       [[unlikely]] case (4):
-        run<4, Kernel>(dc,
-                       rhoc,
-                       dm,
-                       pPBin,
-                       std::make_tuple(pData, pResults),
-                       PointInfo<4>{n_points},
-                       kernel,
-                       queue_,
-                       block_size);
+        run<4, RuntimeKernel>(dc,
+                              rhoc,
+                              dm,
+                              pPBin,
+                              std::make_tuple(pData, pResults),
+                              PointInfo<4>{n_points},
+                              kernel,
+                              queue_,
+                              block_size);
         return;
       [[unlikely]] case (5):
-        run<5, Kernel>(dc,
-                       rhoc,
-                       dm,
-                       pPBin,
-                       std::make_tuple(pData, pResults),
-                       PointInfo<5>{n_points},
-                       kernel,
-                       queue_,
-                       block_size);
+        run<5, RuntimeKernel>(dc,
+                              rhoc,
+                              dm,
+                              pPBin,
+                              std::make_tuple(pData, pResults),
+                              PointInfo<5>{n_points},
+                              kernel,
+                              queue_,
+                              block_size);
         return;
       [[unlikely]] case (6):
-        run<6, Kernel>(dc,
-                       rhoc,
-                       dm,
-                       pPBin,
-                       std::make_tuple(pData, pResults),
-                       PointInfo<6>{n_points},
-                       kernel,
-                       queue_,
-                       block_size);
+        run<6, RuntimeKernel>(dc,
+                              rhoc,
+                              dm,
+                              pPBin,
+                              std::make_tuple(pData, pResults),
+                              PointInfo<6>{n_points},
+                              kernel,
+                              queue_,
+                              block_size);
         return;
       [[unlikely]] case (7):
-        run<7, Kernel>(dc,
-                       rhoc,
-                       dm,
-                       pPBin,
-                       std::make_tuple(pData, pResults),
-                       PointInfo<7>{n_points},
-                       kernel,
-                       queue_,
-                       block_size);
+        run<7, RuntimeKernel>(dc,
+                              rhoc,
+                              dm,
+                              pPBin,
+                              std::make_tuple(pData, pResults),
+                              PointInfo<7>{n_points},
+                              kernel,
+                              queue_,
+                              block_size);
         return;
       [[unlikely]] case (8):
-        run<8, Kernel>(dc,
-                       rhoc,
-                       dm,
-                       pPBin,
-                       std::make_tuple(pData, pResults),
-                       PointInfo<8>{n_points},
-                       kernel,
-                       queue_,
-                       block_size);
+        run<8, RuntimeKernel>(dc,
+                              rhoc,
+                              dm,
+                              pPBin,
+                              std::make_tuple(pData, pResults),
+                              PointInfo<8>{n_points},
+                              kernel,
+                              queue_,
+                              block_size);
         return;
       [[unlikely]] case (9):
-        run<9, Kernel>(dc,
-                       rhoc,
-                       dm,
-                       pPBin,
-                       std::make_tuple(pData, pResults),
-                       PointInfo<9>{n_points},
-                       kernel,
-                       queue_,
-                       block_size);
+        run<9, RuntimeKernel>(dc,
+                              rhoc,
+                              dm,
+                              pPBin,
+                              std::make_tuple(pData, pResults),
+                              PointInfo<9>{n_points},
+                              kernel,
+                              queue_,
+                              block_size);
         return;
       [[unlikely]] case (10):
-        run<10, Kernel>(dc,
-                        rhoc,
-                        dm,
-                        pPBin,
-                        std::make_tuple(pData, pResults),
-                        PointInfo<10>{n_points},
-                        kernel,
-                        queue_,
-                        block_size);
+        run<10, RuntimeKernel>(dc,
+                               rhoc,
+                               dm,
+                               pPBin,
+                               std::make_tuple(pData, pResults),
+                               PointInfo<10>{n_points},
+                               kernel,
+                               queue_,
+                               block_size);
         return;
       [[unlikely]] default:
-        std::cout << "This library only works up to 10 dimensions\n";
+        if (Ndim < 1) {
+          throw std::invalid_argument("The number of dimensions must be positive");
+        }
+        // the dimensionality of the points is not known at compile time
+        run_dynamic<RuntimeKernel>(dc,
+                                   rhoc,
+                                   dm,
+                                   pPBin,
+                                   std::make_tuple(pData, pResults),
+                                   Ndim,
+                                   n_points,
+                                   static_cast<clue::Projection>(projection),
+                                   std::nullopt,
+                                   kernel,
+                                   queue_,
+                                   block_size);
     }
   }
 
@@ -172,44 +210,6 @@ namespace alpaka_serial_sync {
     m.def("listDevices",
           &listDevices,
           "List the available devices for the CPU serial backend");
-    m.def("mainRun",
-          pybind11::overload_cast<float,
-                                  float,
-                                  float,
-                                  int,
-                                  py::array_t<float>,
-                                  py::array_t<int>,
-                                  const FlatKernel&,
-                                  int,
-                                  uint32_t,
-                                  size_t,
-                                  size_t>(&mainRun<FlatKernel>),
-          "mainRun");
-    m.def("mainRun",
-          pybind11::overload_cast<float,
-                                  float,
-                                  float,
-                                  int,
-                                  py::array_t<float>,
-                                  py::array_t<int>,
-                                  const ExponentialKernel&,
-                                  int,
-                                  uint32_t,
-                                  size_t,
-                                  size_t>(&mainRun<ExponentialKernel>),
-          "mainRun");
-    m.def("mainRun",
-          pybind11::overload_cast<float,
-                                  float,
-                                  float,
-                                  int,
-                                  py::array_t<float>,
-                                  py::array_t<int>,
-                                  const GaussianKernel&,
-                                  int,
-                                  uint32_t,
-                                  size_t,
-                                  size_t>(&mainRun<GaussianKernel>),
-          "mainRun");
+    m.def("mainRun", &mainRun, "mainRun");
   }
 };  // namespace alpaka_serial_sync
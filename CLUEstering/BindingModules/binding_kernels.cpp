@@ -13,4 +13,16 @@ PYBIND11_MODULE(CLUE_Convolutional_Kernels, m) {
       .def(pybind11::init<float, float>());
   pybind11::class_<GaussianKernel>(m, "GaussianKernel")
       .def(pybind11::init<float, float, float>());
+  // the backends take all the kernels as a RuntimeKernel, so the others are converted
+  // implicitly, and combinations of kernels are obtained by adding them
+  pybind11::class_<RuntimeKernel>(m, "RuntimeKernel")
+      .def(pybind11::init<const FlatKernel&>())
+      .def(pybind11::init<const ExponentialKernel&>())
+      .def(pybind11::init<const GaussianKernel&>())
+      .def("__add__",
+           [](const RuntimeKernel& lhs, const RuntimeKernel& rhs) { return lhs + rhs; })
+      .def_property_readonly("n_terms", &RuntimeKernel::nTerms);
+  pybind11::implicitly_convertible<FlatKernel, RuntimeKernel>();
+  pybind11::implicitly_convertible<ExponentialKernel, RuntimeKernel>();
+  pybind11::implicitly_convertible<GaussianKernel, RuntimeKernel>();
 }
@@ -0,0 +1,72 @@
+#include <span>
+#include <vector>
+
+#include "CLUEstering/utility/hash.hpp"
+#include "CLUEstering/utility/metrics.hpp"
+
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+#include <pybind11/numpy.h>
+
+namespace py = pybind11;
+
+// the labels are converted to contiguous arrays of int if needed
+using Labels = py::array_t<int, py::array::c_style | py::array::forcecast>;
+using Coords = py::array_t<float, py::array::c_style | py::array::forcecast>;
+
+namespace {
+
+  clue::ContingencyTable contingencyTable(Labels labels_a,
+                                          Labels labels_b,
+                                          unsigned int n_threads) {
+    auto rLabelsA = labels_a.request();
+    auto rLabelsB = labels_b.request();
+    std::span<const int> clusters_a{static_cast<const int*>(rLabelsA.ptr),
+                                    static_cast<std::size_t>(rLabelsA.size)};
+    std::span<const int> clusters_b{static_cast<const int*>(rLabelsB.ptr),
+                                    static_cast<std::size_t>(rLabelsB.size)};
+
+    // the counting doesn't need the interpreter
+    py::gil_scoped_release release;
+    return clue::contingency_table(clusters_a, clusters_b, n_threads);
+  }
+
+}  // namespace
+
+PYBIND11_MODULE(CLUE_Utilities, m) {
+  m.doc() = "Binding of the utilities for comparing the results of the clustering";
+
+  m.def(
+      "adjustedRandIndex",
+      [](Labels labels_a, Labels labels_b, unsigned int n_threads) {
+        return clue::adjusted_rand_index(contingencyTable(labels_a, labels_b, n_threads));
+      },
+      "Adjusted Rand index of two clusterings");
+  m.def(
+      "normalizedMutualInformation",
+      [](Labels labels_a, Labels labels_b, unsigned int n_threads) {
+        return clue::normalized_mutual_information(
+            contingencyTable(labels_a, labels_b, n_threads));
+      },
+      "Normalized mutual information of two clusterings");
+  m.def(
+      "clusterMatchFractions",
+      [](Labels labels_a, Labels labels_b, unsigned int n_threads) {
+        return clue::cluster_match_fractions(
+            contingencyTable(labels_a, labels_b, n_threads));
+      },
+      "Fraction of the points of each cluster found in its best matching cluster");
+  m.def(
+      "inputHash",
+      [](Coords coords, std::vector<float> parameters, unsigned int n_threads) {
+        auto rCoords = coords.request();
+        const auto size = static_cast<std::size_t>(rCoords.size) * sizeof(float);
+
+        py::gil_scoped_release release;
+        const auto key = clue::hash_bytes(rCoords.ptr, size, n_threads);
+        return clue::hash_combine(
+            key,
+            clue::hash_bytes(parameters.data(), parameters.size() * sizeof(float)));
+      },
+      "Hash of the coordinates and of the parameters, used as key of the result cache");
+}
@@ -7,6 +7,7 @@ from dataclasses import dataclass
 from glob import glob
 import random as rnd
 from math import sqrt
+from threading import get_ident
 import time
 import types
 from typing import Union
@@ -15,10 +16,12 @@ import numpy as np
 import pandas as pd
 from sklearn.datasets import make_blobs
 from sklearn.preprocessing import StandardScaler
+from os import getpid, makedirs, replace
 from os.path import dirname, exists, join
 path = dirname(__file__)
 sys.path.insert(1, join(path, 'lib'))
 import CLUE_Convolutional_Kernels as clue_kernels
+import CLUE_Utilities as clue_utilities
 import CLUE_CPU_Serial as cpu_serial
 
 backends = ["cpu serial"]
@@ -72,6 +75,125 @@ def is_hip_available():
     return hip_found
 
 
+def adjusted_rand_index(labels_a, labels_b, n_threads: int = 0) -> float:
+    """
+    Returns the adjusted Rand index of two clusterings of the same points.
+
+    The outliers, labelled with -1, are treated as a cluster of their own.
+
+    Parameters
+    ----------
+    labels_a : array_like
+        The cluster ids of the points in the first clustering.
+    labels_b : array_like
+        The cluster ids of the points in the second clustering.
+    n_threads : int, optional
+        The number of threads used for comparing the clusterings. By default all the
+        available hardware threads are used.
+
+    Returns
+    -------
+    float
+        The adjusted Rand index, which is 1 for identical clusterings.
+    """
+
+    return clue_utilities.adjustedRandIndex(np.asarray(labels_a),
+                                            np.asarray(labels_b),
+                                            n_threads)
+
+
+def normalized_mutual_information(labels_a, labels_b, n_threads: int = 0) -> float:
+    """
+    Returns the mutual information of two clusterings of the same points, normalized
+    by the arithmetic mean of their entropies.
+
+    The outliers, labelled with -1, are treated as a cluster of their own.
+
+    Parameters
+    ----------
+    labels_a : array_like
+        The cluster ids of the points in the first clustering.
+    labels_b : array_like
+        The cluster ids of the points in the second clustering.
+    n_threads : int, optional
+        The number of threads used for comparing the clusterings. By default all the
+        available hardware threads are used.
+
+    Returns
+    -------
+    float
+        The normalized mutual information, which is 1 for identical clusterings.
+    """
+
+    return clue_utilities.normalizedMutualInformation(np.asarray(labels_a),
+                                                      np.asarray(labels_b),
+                                                      n_threads)
+
+
+def cluster_match_fractions(labels_a, labels_b, n_threads: int = 0) -> np.ndarray:
+    """
+    Returns, for each cluster of the first clustering, the fraction of its points
+    that are found in the cluster of the second clustering that best matches it.
+
+    Parameters
+    ----------
+    labels_a : array_like
+        The cluster ids of the points in the first clustering.
+    labels_b : array_like
+        The cluster ids of the points in the second clustering.
+    n_threads : int, optional
+        The number of threads used for comparing the clusterings. By default all the
+        available hardware threads are used.
+
+    Returns
+    -------
+    np.ndarray
+        The fraction of matched points, indexed by the cluster id.
+    """
+
+    return np.array(clue_utilities.clusterMatchFractions(np.asarray(labels_a),
+                                                         np.asarray(labels_b),
+                                                         n_threads))
+
+
+# results of the previous runs, indexed by the hash of their inputs
+_result_cache = {}
+
+
+def clear_result_cache() -> None:
+    """
+    Removes the results kept in memory by the result cache of run_clue.
+    The results written to disk are not removed.
+    """
+
+    _result_cache.clear()
+
+
+def _find_cached_results(key: int, cache_dir: Union[str, None]) -> Union[np.ndarray, None]:
+    if key in _result_cache:
+        return np.copy(_result_cache[key])
+    if cache_dir is not None:
+        file_name = join(cache_dir, f"{key:016x}.npy")
+        if exists(file_name):
+            _result_cache[key] = np.load(file_name)
+            return np.copy(_result_cache[key])
+    return None
+
+
+def _store_cached_results(key: int, results: np.ndarray,
+                          cache_dir: Union[str, None]) -> None:
+    _result_cache[key] = np.copy(results)
+    if cache_dir is not None:
+        makedirs(cache_dir, exist_ok=True)
+        # written to a temporary file first, so that a partial file is never read. Its name
+        # is unique to the process and thread, so that concurrent writers don't race
+        file_name = join(cache_dir, f"{key:016x}.npy")
+        tmp_name = f"{file_name}.{getpid()}.{get_ident()}.tmp"
+        with open(tmp_name, "wb") as tmp_file:
+            np.save(tmp_file, results)
+        replace(tmp_name, file_name)
+
+
 def test_blobs(n_samples: int, n_dim: int, n_blobs: int = 4, mean: float = 0,
                sigma: float = 0.5, x_max: float = 30, y_max: float = 30) -> pd.DataFrame:
     """
@@ -264,6 +386,8 @@ class clusterer:
 
         ## Kernel for calculation of local density
         self.kernel = clue_kernels.FlatKernel(0.5)
+        # name and parameters of the kernel, used for hashing the inputs
+        self._kernel_params = ("flat", [0.5])
 
         ## Output attributes
         self.clust_prop = None
@@ -300,9 +424,9 @@ class clusterer:
 
         # [[x0, x1, x2, ...], [y0, y1, y2, ...], ... , [weights]]
         if isinstance(input_data[0][0], (int, float)):
-            if len(input_data) < 2 or len(input_data) > 11:
-                raise ValueError("Inadequate data. The supported dimensions are between" +
-                                 "1 and 10.")
+            if len(input_data) < 2:
+                raise ValueError("Inadequate data. The data must contain"
+                                 + " at least one coordinate and the weight.")
             npoints = len(input_data[-1])
             ndim = len(input_data[:-1])
             coords = np.vstack([input_data[:-1],      # coordinates SoA
@@ -410,9 +534,6 @@ class clusterer:
         if len(df_.columns) < 2:
             raise ValueError("Inadequate data. The data must contain"
                              + " at least one coordinate and the weight.")
-        if len(coordinate_columns) > 10:
-            raise ValueError("Inadequate data. The maximum number of"
-                             + " dimensions supported is 10.")
         ndim = len(coordinate_columns)
         npoints = len(df_.index)
         coords = df_.iloc[:, 0:-1].to_numpy()
@@ -519,12 +640,14 @@ class clusterer:
                 raise ValueError("Wrong number of parameters. The flat kernel"
                                  + " requires 1 parameter.")
             self.kernel = clue_kernels.FlatKernel(parameters[0])
+            self._kernel_params = ("flat", list(parameters))
         elif choice == "exp":
             if len(parameters) != 2:
                 raise ValueError("Wrong number of parameters. The exponential"
                                  + " kernel requires 2 parameters.")
             self.kernel = clue_kernels.ExponentialKernel(parameters[0],
                                                                        parameters[1])
+            self._kernel_params = ("exp", list(parameters))
         elif choice == "gaus":
             if len(parameters) != 3:
                 raise ValueError("Wrong number of parameters. The gaussian" +
@@ -532,10 +655,13 @@ class clusterer:
             self.kernel = clue_kernels.GaussianKernel(parameters[0],
                                                                    parameters[1],
                                                                    parameters[2])
+            self._kernel_params = ("gaus", list(parameters))
         elif choice == "custom":
             if len(parameters) != 0:
                 raise ValueError("Wrong number of parameters. Custom kernels"
                                  + " requires 0 parameters.")
+            # the results of custom kernels can't be cached
+            self._kernel_params = None
         else:
             raise ValueError("Invalid kernel. The allowed choices for the"
                              + " kernels are: flat, exp, gaus and custom.")
@@ -650,7 +776,13 @@ class clusterer:
                  block_size: int = 1024,
                  device_id: int = 0,
                  verbose: bool = False,
-                 dimensions: Union[list, None] = None) -> None:
+                 dimensions: Union[list, None] = None,
+                 cache: bool = False,
+                 cache_dir: Union[str, None] = None,
+                 projection: str = "none",
+                 lsh_tables: int = 0,
+                 lsh_hashes: int = 4,
+                 lsh_bucket_width: float = 0.) -> None:
         """
         Executes the CLUE clustering algorithm.
 
@@ -659,6 +791,32 @@ class clusterer:
         verbose : bool, optional
             The verbose option prints the execution time of runCLUE and the number
             of clusters found.
+        cache : bool, optional
+            If true, the results are taken from the result cache when the same points
+            have already been clustered with the same parameters and kernel, and
+            otherwise they are stored in it. The cache is kept in memory and shared by
+            all the clusterers, and is disabled for custom kernels.
+        cache_dir : str, optional
+            If given, the cached results are also written to and read from this
+            directory, so that they can be reused by other processes.
+        projection : str, optional
+            Coordinates used for tiling the points with more than 10 dimensions, which
+            are otherwise tiled on their first two coordinates. It can be "none",
+            "random", for a random orthonormal projection, or "pca", for the principal
+            components of the points, which usually separate them better but require
+            an additional pass over all the coordinates.
+        lsh_tables : int, optional
+            If positive, the neighbours are searched with locality-sensitive hashing
+            over this number of hash tables instead of the tiles. The search is
+            approximate, because some neighbours can be missed, but prunes the
+            candidates better for points with many dimensions. More tables find more
+            neighbours at the cost of more candidates.
+        lsh_hashes : int, optional
+            Number of hashes combined in each table. More hashes reduce the number of
+            candidates, but miss more neighbours.
+        lsh_bucket_width : float, optional
+            Width of the buckets of the hashes. If not positive, four times the
+            largest of dc and dm is used.
 
         Modified attributes
         -------------------
@@ -692,18 +850,52 @@ class clusterer:
             data.n_dim = len(dimensions)
             data.n_points = self.clust_data.n_points
 
+        projection_ids = {"none": 0, "random": 1, "pca": 2}
+        if projection not in projection_ids:
+            raise ValueError(f"Unknown projection {projection}. "
+                             + "The available ones are none, random and pca.")
+        projection_id = projection_ids[projection]
+
         start = time.time_ns()
-        if backend == "cpu serial":
+        # whether the clustering was actually run, so that its results can be cached
+        ran = False
+        cache_key = None
+        if cache and self._kernel_params is not None:
+            kernel_ids = {"flat": 0., "exp": 1., "gaus": 2.}
+            # the order of the floating point sums and of the seeds depends on the
+            # backend, so the results of different backends are cached separately
+            backend_ids = {"cpu serial": 0., "cpu tbb": 1., "cpu openmp": 2.,
+                           "gpu cuda": 3., "gpu hip": 4.}
+            parameters = [self.dc_, self.rhoc, self.dm, float(self.ppbin),
+                          float(data.n_dim), kernel_ids[self._kernel_params[0]],
+                          *self._kernel_params[1], float(projection_id),
+                          float(lsh_tables), float(lsh_hashes), lsh_bucket_width,
+                          backend_ids.get(backend, -1.)]
+            cache_key = clue_utilities.inputHash(data.coords, parameters, 0)
+            cached_results = _find_cached_results(cache_key, cache_dir)
+            if cached_results is not None:
+                data.results = cached_results
+                backend = "cached"
+
+        if backend == "cached":
+            pass
+        elif backend == "cpu serial":
             cluster_id_is_seed = cpu_serial.mainRun(self.dc_, self.rhoc, self.dm, self.ppbin,
                                                     data.coords, data.results,
                                                     self.kernel, data.n_dim,
-                                                    data.n_points, block_size, device_id)
+                                                    data.n_points, projection_id, lsh_tables,
+                                                    lsh_hashes, lsh_bucket_width,
+                                                    block_size, device_id)
+            ran = True
         elif backend == "cpu tbb":
             if tbb_found:
                 cluster_id_is_seed = cpu_tbb.mainRun(self.dc_, self.rhoc, self.dm, self.ppbin,
                                                      data.coords, data.results,
                                                      self.kernel, data.n_dim,
-                                                     data.n_points, block_size, device_id)
+                                                     data.n_points, projection_id, lsh_tables,
+                                                     lsh_hashes, lsh_bucket_width,
+                                                     block_size, device_id)
+                ran = True
             else:
                 print("TBB module not found. Please re-compile the library and try again.")
 
@@ -712,7 +904,10 @@ class clusterer:
                 cluster_id_is_seed = cpu_omp.mainRun(self.dc_, self.rhoc, self.dm, self.ppbin,
                                                      data.coords, data.results,
                                                      self.kernel, data.n_dim,
-                                                     data.n_points, block_size, device_id)
+                                                     data.n_points, projection_id, lsh_tables,
+                                                     lsh_hashes, lsh_bucket_width,
+                                                     block_size, device_id)
+                ran = True
             else:
                 print("OpenMP module not found. Please re-compile the library and try again.")
 
@@ -721,7 +916,10 @@ class clusterer:
                 cluster_id_is_seed = gpu_cuda.mainRun(self.dc_, self.rhoc, self.dm, self.ppbin,
                                                       data.coords, data.results,
                                                       self.kernel, data.n_dim,
-                                                      data.n_points, block_size, device_id)
+                                                      data.n_points, projection_id, lsh_tables,
+                                                      lsh_hashes, lsh_bucket_width,
+                                                      block_size, device_id)
+                ran = True
             else:
                 print("CUDA module not found. Please re-compile the library and try again.")
 
@@ -730,11 +928,16 @@ class clusterer:
                 cluster_id_is_seed = gpu_hip.mainRun(self.dc_, self.rhoc, self.dm, self.ppbin,
                                                      data.coords, data.results,
                                                      self.kernel, data.n_dim,
-                                                     data.n_points, block_size, device_id)
+                                                     data.n_points, projection_id, lsh_tables,
+                                                     lsh_hashes, lsh_bucket_width,
+                                                     block_size, device_id)
+                ran = True
             else:
                 print("HIP module not found. Please re-compile the library and try again.")
 
         finish = time.time_ns()
+        if cache_key is not None and ran:
+            _store_cached_results(cache_key, data.results, cache_dir)
         cluster_ids = data.results[0]
         is_seed = data.results[1]
         clusters = np.unique(cluster_ids)
@@ -0,0 +1,446 @@
+"""
+Compares CLUEstering with the DBSCAN and HDBSCAN clusterings of scikit-learn and with
+a brute-force implementation of CLUE on the same synthetic datasets.
+
+For each generator and number of points, the clusterings are run on every backend of
+CLUEstering available locally and by the other methods, each in a separate process,
+and the wall time, the peak memory and the adjusted Rand index are reported in
+a JSON file and in one plot for each generator. The adjusted Rand index is computed
+against the labels of the generator and, when it is run, against the brute-force
+reference, which gives the exact result of CLUE. The outliers of all the methods are
+labelled with -1 and treated as a cluster of their own.
+The wall time of CLUEstering is the one of its clustering call, measured by run_clue,
+which excludes the Python post-processing of the results that the other methods don't
+do.
+The peak memory is the increase of the resident memory of the process during the
+clustering, so it also accounts for the memory allocated by the compiled code.
+
+Run it from the build system with the benchmark_comparison target, or directly with:
+    PYTHONPATH=<repository root> python3 compare.py --sizes 1000 10000 --output results
+"""
+
+import argparse
+import json
+import multiprocessing
+import platform
+import resource
+import sys
+import time
+from os import makedirs
+from os.path import abspath, dirname, join
+from typing import Union
+
+import numpy as np
+
+# use the local build of CLUEstering when the script is run from the repository
+sys.path.insert(1, join(dirname(abspath(__file__)), "..", ".."))
+
+# Parameters of the generators. The critical density of CLUE and the minimum number of
+# samples of DBSCAN are given for n_ref points and scaled with the number of points,
+# since the density of the datasets grows with it. The moons have a uniform density
+# along their arcs, so CLUE needs a critical distance comparable to their width, which
+# would merge them with DBSCAN.
+GENERATORS = {
+    "blobs_2d": {"n_dim": 2, "dc": 1.0, "rhoc": 5.0, "dm": 2.0,
+                 "eps": 1.0, "min_samples": 9},
+    "blobs_3d": {"n_dim": 3, "dc": 1.5, "rhoc": 5.0, "dm": 3.0,
+                 "eps": 1.5, "min_samples": 9},
+    "moons": {"n_dim": 2, "dc": 5.0, "rhoc": 5.0, "dm": 5.0,
+              "eps": 1.0, "min_samples": 9},
+}
+n_ref = 1000
+# flat kernel used by CLUE and by the brute-force reference
+flat_kernel = 0.5
+points_per_tile = 128
+
+
+def generate(generator: str, n_points: int, seed: int) -> tuple:
+    """
+    Returns the coordinates, the weights and the true labels of a synthetic dataset.
+
+    Parameters
+    ----------
+    generator : str
+        The name of the generator, one of the keys of GENERATORS.
+    n_points : int
+        The number of points of the dataset.
+    seed : int
+        The seed of the random generator.
+
+    Returns
+    -------
+    tuple
+        The coordinates, with shape (n_points, n_dim), the weights and the labels.
+    """
+
+    # imported here so that the processes which don't generate data don't need it
+    from sklearn.datasets import make_blobs, make_moons
+
+    if generator == "blobs_2d":
+        coords, labels = make_blobs(n_samples=n_points, n_features=2, centers=8,
+                                    cluster_std=1.0, center_box=(-40., 40.),
+                                    random_state=seed)
+    elif generator == "blobs_3d":
+        coords, labels = make_blobs(n_samples=n_points, n_features=3, centers=8,
+                                    cluster_std=1.0, center_box=(-40., 40.),
+                                    random_state=seed)
+    elif generator == "moons":
+        coords, labels = make_moons(n_samples=n_points, noise=0.05, random_state=seed)
+        coords *= 10.
+    else:
+        raise ValueError(f"Unknown generator {generator}. The available generators"
+                         + f" are: {', '.join(GENERATORS)}.")
+    return coords, np.ones(n_points), labels
+
+
+def clue_parameters(generator: str, n_points: int) -> tuple:
+    """
+    Returns the parameters dc, rhoc and dm of CLUE for a dataset.
+    """
+
+    params = GENERATORS[generator]
+    return params["dc"], params["rhoc"] * n_points / n_ref, params["dm"]
+
+
+def brute_force_clue(coords: np.ndarray, weights: np.ndarray,
+                     dc: float, rhoc: float, dm: float) -> np.ndarray:
+    """
+    Returns the cluster ids found by CLUE with the flat kernel, computing the distances
+    between all the pairs of points.
+
+    The ties in the density are broken with the index of the points as in CLUEstering,
+    and the computations are done in single precision, so that the result is the one
+    of CLUEstering up to the rounding of the densities.
+
+    Parameters
+    ----------
+    coords : np.ndarray
+        The coordinates of the points, with shape (n_points, n_dim).
+    weights : np.ndarray
+        The weights of the points.
+    dc, rhoc, dm : float
+        The parameters of CLUE.
+
+    Returns
+    -------
+    np.ndarray
+        The cluster ids of the points, where the outliers have id -1.
+    """
+
+    coords = coords.astype(np.float32)
+    weights = weights.astype(np.float32)
+    n_points = len(weights)
+    # the rows of the distance matrix are computed in chunks, to bound the memory
+    chunk = max(1, (1 << 24) // max(n_points, 1))
+
+    def squared_distances(first, last):
+        diff = coords[first:last, None, :] - coords[None, :, :]
+        return np.einsum("ijk,ijk->ij", diff, diff)
+
+    rho = weights.copy()
+    for first in range(0, n_points, chunk):
+        last = min(first + chunk, n_points)
+        neighbours = squared_distances(first, last) <= np.float32(dc * dc)
+        neighbours[np.arange(last - first), np.arange(first, last)] = False
+        rho[first:last] += np.float32(flat_kernel) * (neighbours @ weights)
+
+    delta = np.full(n_points, np.inf, dtype=np.float32)
+    nearest_higher = np.full(n_points, -1)
+    indexes = np.arange(n_points)
+    for first in range(0, n_points, chunk):
+        last = min(first + chunk, n_points)
+        rho_i = rho[first:last, None]
+        higher = (rho[None, :] > rho_i) | ((rho[None, :] == rho_i) & (rho_i > 0)
+                                           & (indexes[None, :] > indexes[first:last,
+                                                                         None]))
+        dist_sq = squared_distances(first, last)
+        dist_sq = np.where(higher & (dist_sq <= np.float32(dm * dm)), dist_sq, np.inf)
+        # argmin returns the smallest index among the nearest points
+        nearest = np.argmin(dist_sq, axis=1)
+        found = np.isfinite(dist_sq[np.arange(last - first), nearest])
+        nearest_higher[first:last] = np.where(found, nearest, -1)
+        delta[first:last] = np.where(found,
+                                     np.sqrt(dist_sq[np.arange(last - first), nearest]),
+                                     np.inf)
+
+    is_seed = (delta > dc) & (rho >= rhoc)
+    is_outlier = (delta > dm) & (rho < rhoc)
+    # the seeds and the outliers are the roots of the chains of nearest highers
+    parents = np.where(is_seed | is_outlier, indexes, nearest_higher)
+    while True:
+        grandparents = parents[parents]
+        if np.array_equal(grandparents, parents):
+            break
+        parents = grandparents
+    seed_ids = np.full(n_points, -1)
+    seed_ids[is_seed] = np.arange(np.count_nonzero(is_seed))
+    return seed_ids[parents]
+
+
+def _memory_status(field: str) -> Union[int, None]:
+    try:
+        with open("/proc/self/status", encoding="utf-8") as status:
+            for line in status:
+                if line.startswith(field + ":"):
+                    return int(line.split()[1])
+    except OSError:
+        pass
+    return None
+
+
+def reset_peak_memory() -> int:
+    """
+    Resets the peak resident memory of the process, where supported, and returns the
+    memory to which the peak is compared, in kilobytes.
+
+    On Linux the peak is reset to the current resident memory, otherwise the peak
+    reached so far is returned, which can hide the memory used by small runs.
+    """
+
+    try:
+        with open("/proc/self/clear_refs", "w", encoding="utf-8") as clear_refs:
+            clear_refs.write("5")
+        current = _memory_status("VmRSS")
+        if current is not None:
+            return current
+    except OSError:
+        pass
+    return resource.getrusage(resource.RUSAGE_SELF).ru_maxrss
+
+
+def peak_memory() -> int:
+    """
+    Returns the peak resident memory of the process, in kilobytes.
+    """
+
+    peak = _memory_status("VmHWM")
+    if peak is None:
+        # ru_maxrss is in kilobytes on Linux
+        peak = resource.getrusage(resource.RUSAGE_SELF).ru_maxrss
+    return peak
+
+
+def run_method(task: dict) -> dict:
+    """
+    Runs a clustering configuration and returns its timing, memory and labels.
+
+    It is run in a new process for each configuration, so that the peak memory
+    only includes the clustering of that configuration.
+    """
+
+    coords, weights, _ = generate(task["generator"], task["n_points"], task["seed"])
+    dc, rhoc, dm = clue_parameters(task["generator"], task["n_points"])
+    method = task["method"]
+    # the time of the clustering alone, for the methods that also post-process the
+    # results, otherwise the whole call of fit is timed
+    clustering_time = None
+
+    if method == "clue":
+        import CLUEstering as clue
+
+        data = {f"x{dim}": coords[:, dim] for dim in range(coords.shape[1])}
+        data["weight"] = weights
+        clusterer = clue.clusterer(dc, rhoc, dm, points_per_tile)
+        clusterer.read_data(data)
+
+        def fit():
+            clusterer.run_clue(backend=task["backend"], block_size=task["block_size"])
+            return clusterer.cluster_ids
+
+        def clustering_time():
+            return clusterer.elapsed_time
+        # the first run initializes the device and is not timed
+        fit()
+    elif method == "dbscan":
+        from sklearn.cluster import DBSCAN
+
+        params = GENERATORS[task["generator"]]
+        min_samples = max(2, round(params["min_samples"] * task["n_points"] / n_ref))
+
+        def fit():
+            return DBSCAN(eps=params["eps"], min_samples=min_samples).fit(coords).labels_
+    elif method == "hdbscan":
+        from sklearn.cluster import HDBSCAN
+
+        def fit():
+            return HDBSCAN(min_cluster_size=task["min_cluster_size"],
+                           copy=True).fit(coords).labels_
+    elif method == "brute force":
+        def fit():
+            return brute_force_clue(coords, weights, dc, rhoc, dm)
+    else:
+        raise ValueError(f"Unknown method {method}")
+
+    baseline = reset_peak_memory()
+    times = []
+    for _ in range(task["repeats"]):
+        start = time.perf_counter()
+        labels = fit()
+        elapsed = (time.perf_counter() - start) * 1e3
+        times.append(elapsed if clustering_time is None else clustering_time())
+    peak = peak_memory()
+
+    return {"wall_time_ms": float(np.median(times)),
+            "wall_times_ms": times,
+            "peak_memory_mb": max(peak - baseline, 0) / 1024.,
+            "labels": np.asarray(labels)}
+
+
+def adjusted_rand_index(labels_a: np.ndarray, labels_b: np.ndarray) -> float:
+    from sklearn.metrics import adjusted_rand_score
+
+    return float(adjusted_rand_score(labels_a, labels_b))
+
+
+def available_backends() -> list:
+    try:
+        import CLUEstering as clue
+    except ImportError as error:
+        print(f"CLUEstering can't be imported ({error}), only the other methods are run")
+        return []
+    return list(clue.backends)
+
+
+def plot_results(results: list, output: str) -> None:
+    """
+    Saves for each generator a plot of the wall time, of the peak memory and of the
+    adjusted Rand index of the methods as a function of the number of points.
+    """
+
+    import matplotlib
+    matplotlib.use("Agg")
+    import matplotlib.pyplot as plt
+
+    for generator in GENERATORS:
+        entries = [entry for entry in results if entry["generator"] == generator
+                   and "wall_time_ms" in entry]
+        if not entries:
+            continue
+        labels = sorted({entry["label"] for entry in entries})
+        fig, axes = plt.subplots(1, 3, figsize=(15, 4.5))
+        for label in labels:
+            points = sorted((entry["n_points"], entry) for entry in entries
+                            if entry["label"] == label)
+            sizes = [n_points for n_points, _ in points]
+            axes[0].plot(sizes, [entry["wall_time_ms"] for _, entry in points],
+                         marker="o", label=label)
+            axes[1].plot(sizes, [entry["peak_memory_mb"] for _, entry in points],
+                         marker="o", label=label)
+            axes[2].plot(sizes, [entry["ari_truth"] for _, entry in points],
+                         marker="o", label=label)
+        for axis, title in zip(axes, ["Wall time [ms]", "Peak memory [MB]",
+                                      "ARI with the true labels"]):
+            axis.set_xscale("log")
+            axis.set_xlabel("Number of points")
+            axis.set_title(title)
+            axis.grid(True, alpha=0.3)
+        axes[0].set_yscale("log")
+        axes[0].legend()
+        fig.suptitle(generator)
+        fig.tight_layout()
+        fig.savefig(join(output, f"{generator}.png"))
+        plt.close(fig)
+
+
+def main() -> None:
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    parser.add_argument("--sizes", type=int, nargs="+", default=[1000, 10000, 100000],
+                        help="numbers of points of the datasets")
+    parser.add_argument("--generators", nargs="+", default=list(GENERATORS),
+                        choices=list(GENERATORS), help="synthetic datasets to use")
+    parser.add_argument("--methods", nargs="+",
+                        default=["clue", "dbscan", "hdbscan", "brute force"],
+                        choices=["clue", "dbscan", "hdbscan", "brute force"])
+    parser.add_argument("--repeats", type=int, default=3,
+                        help="timed runs of each configuration, the median is reported")
+    parser.add_argument("--block-size", type=int, default=256,
+                        help="block size of the CLUEstering backends")
+    parser.add_argument("--min-cluster-size", type=int, default=25,
+                        help="minimum cluster size of HDBSCAN")
+    parser.add_argument("--max-sklearn-points", type=int, default=50000,
+                        help="largest dataset clustered with DBSCAN and HDBSCAN")
+    parser.add_argument("--max-brute-force-points", type=int, default=20000,
+                        help="largest dataset clustered with the brute-force reference")
+    parser.add_argument("--seed", type=int, default=0)
+    parser.add_argument("--output", default="benchmark_comparison",
+                        help="directory where the JSON file and the plots are written")
+    parser.add_argument("--no-plots", action="store_true")
+    args = parser.parse_args()
+
+    backends = available_backends() if "clue" in args.methods else []
+    if "hdbscan" in args.methods:
+        try:
+            from sklearn.cluster import HDBSCAN  # noqa: F401
+        except ImportError:
+            print("HDBSCAN requires scikit-learn 1.3 or later, it is not run")
+            args.methods.remove("hdbscan")
+    limits = {"dbscan": args.max_sklearn_points,
+              "hdbscan": args.max_sklearn_points,
+              "brute force": args.max_brute_force_points}
+    # the processes are spawned, so that they don't inherit the memory of this one
+    context = multiprocessing.get_context("spawn")
+
+    results = []
+    for generator in args.generators:
+        for n_points in args.sizes:
+            _, _, truth = generate(generator, n_points, args.seed)
+            configurations = []
+            for method in args.methods:
+                if method == "clue":
+                    configurations += [(method, backend, f"CLUEstering {backend}")
+                                       for backend in backends]
+                else:
+                    configurations.append((method, None, method))
+            # the reference is run first, so that the others can be compared with it
+            configurations.sort(key=lambda configuration: configuration[0]
+                                != "brute force")
+
+            reference = None
+            for method, backend, label in configurations:
+                entry = {"generator": generator, "n_points": n_points,
+                         "method": method, "backend": backend, "label": label}
+                if n_points > limits.get(method, n_points):
+                    entry["skipped"] = "too many points"
+                    results.append(entry)
+                    continue
+                task = {"generator": generator, "n_points": n_points,
+                        "seed": args.seed, "method": method, "backend": backend,
+                        "repeats": args.repeats, "block_size": args.block_size,
+                        "min_cluster_size": args.min_cluster_size}
+                with context.Pool(1) as pool:
+                    run = pool.apply(run_method, (task,))
+                labels = run.pop("labels")
+                entry.update(run)
+                entry["n_clusters"] = int(len(np.unique(labels[labels >= 0])))
+                entry["ari_truth"] = adjusted_rand_index(truth, labels)
+                if method == "brute force":
+                    reference = labels
+                elif reference is not None:
+                    entry["ari_brute_force"] = adjusted_rand_index(reference, labels)
+                results.append(entry)
+                print(f"{generator:>9} {n_points:>8} {label:>24}:"
+                      f" {entry['wall_time_ms']:10.2f} ms,"
+                      f" {entry['peak_memory_mb']:8.1f} MB,"
+                      f" ARI {entry['ari_truth']:.3f}")
+
+    makedirs(args.output, exist_ok=True)
+    report = {"machine": {"platform": platform.platform(),
+                          "processor": platform.processor(),
+                          "python": platform.python_version()},
+              "parameters": {"generators": {generator: GENERATORS[generator]
+                                            for generator in args.generators},
+                             "n_ref": n_ref, "flat_kernel": flat_kernel,
+                             "points_per_tile": points_per_tile,
+                             "repeats": args.repeats, "block_size": args.block_size,
+                             "min_cluster_size": args.min_cluster_size,
+                             "seed": args.seed},
+              "results": results}
+    with open(join(args.output, "comparison.json"), "w", encoding="utf-8") as file:
+        json.dump(report, file, indent=2)
+    if not args.no_plots:
+        plot_results(results, args.output)
+    print(f"Results written to {args.output}")
+
+
+if __name__ == "__main__":
+    main()
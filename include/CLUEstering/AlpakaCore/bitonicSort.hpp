@@ -0,0 +1,74 @@
+#pragma once
+
+#include <alpaka/alpaka.hpp>
+
+#include "alpakaConfig.hpp"
+#include "alpakaWorkDiv.hpp"
+
+namespace clue {
+
+  // Orders the elements by their less-than operator
+  struct Ascending {
+    template <typename T>
+    ALPAKA_FN_HOST_ACC bool operator()(const T& a, const T& b) const {
+      return a < b;
+    }
+  };
+
+  // One step of the bitonic sorting network, where each element is compared with the
+  // one whose index differs by the bits of mask. Only ascending comparisons are used,
+  // the first step of each stage comparing the sequences in reverse order, so that
+  // the elements beyond the end of the data behave as the largest ones and any size
+  // can be sorted.
+  template <typename T, typename TLess>
+  struct KernelBitonicSortStep {
+    template <typename TAcc>
+    ALPAKA_FN_ACC void operator()(
+        const TAcc& acc, T* data, uint32_t size, uint32_t mask, TLess less) const {
+      for (auto i : alpaka::uniformElements(acc, size)) {
+        const auto partner = i ^ mask;
+        if (partner > i and partner < size and less(data[partner], data[i])) {
+          const T tmp{data[i]};
+          data[i] = data[partner];
+          data[partner] = tmp;
+        }
+      }
+    }
+  };
+
+  // Sorts in place the size elements of data on the device, ordered by less, with
+  // O(log^2(size)) launches of size work items each. The sort isn't stable.
+  template <typename TAcc,
+            typename T,
+            typename TLess,
+            typename TQueue,
+            typename = std::enable_if_t<alpaka::isAccelerator<TAcc>>,
+            typename = std::enable_if_t<alpaka::isQueue<TQueue>>>
+  ALPAKA_FN_HOST void bitonicSort(
+      TQueue& queue, T* data, uint32_t size, TLess less, uint32_t block_size = 256) {
+    if (size < 2) {
+      return;
+    }
+    const auto grid_size = divide_up_by(size, block_size);
+    const auto workdiv = make_workdiv<TAcc>(grid_size, block_size);
+    for (uint64_t length{2}; length / 2 < size; length *= 2) {
+      alpaka::exec<TAcc>(queue,
+                         workdiv,
+                         KernelBitonicSortStep<T, TLess>{},
+                         data,
+                         size,
+                         static_cast<uint32_t>(length - 1),
+                         less);
+      for (auto distance = length / 4; distance > 0; distance /= 2) {
+        alpaka::exec<TAcc>(queue,
+                           workdiv,
+                           KernelBitonicSortStep<T, TLess>{},
+                           data,
+                           size,
+                           static_cast<uint32_t>(distance),
+                           less);
+      }
+    }
+  }
+
+}  // namespace clue
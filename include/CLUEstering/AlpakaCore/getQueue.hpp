@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <alpaka/alpaka.hpp>
+
+#include "alpakaDevices.hpp"
+
+namespace clue {
+
+  namespace detail {
+
+    // Process-wide registry of the queues created on the devices of a platform.
+    // The devices are enumerated once, when the registry is first used, and the queues
+    // are created lazily the first time that they are requested and then kept alive, so
+    // that repeated calls to the algorithm don't have to set them up again.
+    template <typename TPlatform, typename TQueue>
+    class QueueRegistry {
+    public:
+      using Device = alpaka::Dev<TPlatform>;
+
+      QueueRegistry() : m_queues(clue::devices<TPlatform>().size()) {}
+
+      TQueue get(std::size_t device_index, std::size_t queue_index) {
+        const auto& devices = clue::devices<TPlatform>();
+        if (device_index >= devices.size()) {
+          throw std::out_of_range("Invalid device index " + std::to_string(device_index) +
+                                  ", only " + std::to_string(devices.size()) +
+                                  " devices are available");
+        }
+
+        // the public interface is thread safe
+        std::lock_guard<std::mutex> guard(m_mutex);
+        auto& device_queues = m_queues[device_index];
+        while (device_queues.size() <= queue_index) {
+          device_queues.emplace_back(devices[device_index]);
+        }
+        // alpaka queues are handles to a shared implementation, so the copy returned
+        // here refers to the same underlying queue
+        return device_queues[queue_index];
+      }
+
+    private:
+      std::mutex m_mutex;
+      std::vector<std::vector<TQueue>> m_queues;
+    };
+
+  }  // namespace detail
+
+  // Returns the queue queue_index of the device device_index, which is created only the
+  // first time that it's requested
+  template <typename TPlatform, typename TQueue>
+  inline TQueue getQueue(std::size_t device_index, std::size_t queue_index = 0) {
+    // the registry is intentionally never destroyed, because the queues could otherwise
+    // outlive the runtime of the backend during the teardown of the process
+    static auto* registry = new detail::QueueRegistry<TPlatform, TQueue>();
+
+    return registry->get(device_index, queue_index);
+  }
+
+}  // namespace clue
@@ -4,6 +4,7 @@
 #include <alpaka/alpaka.hpp>
 
 #include "alpakaConfig.hpp"
+#include "alpakaMemory.hpp"
 #include "alpakaWorkDiv.hpp"
 
 namespace clue {
@@ -229,6 +230,93 @@ namespace clue {
       }
     }
   };
+
+  // Two-pass blocked inclusive scan, used on the CPU backends in place of
+  // multiBlockPrefixScan. Each block first reduces its own chunk of the input, then
+  // every block scans its chunk serially, starting from the sum of the chunks that
+  // precede it. The blocks are independent, so the work is spread over all the
+  // blocks that the backend runs in parallel, without needing warp primitives, a
+  // block counter or a last-block-done step.
+  template <typename T>
+  struct KernelBlockedScanSums {
+    template <typename TAcc>
+    ALPAKA_FN_ACC void operator()(const TAcc& acc,
+                                  T const* ci,
+                                  T* block_sums,
+                                  uint32_t size) const {
+      const auto blockIdx = alpaka::getIdx<alpaka::Grid, alpaka::Blocks>(acc)[0u];
+      const auto [first, last] = element_index_range_in_grid_truncated(acc, size);
+      T sum{0};
+      for (auto i = first; i < last; ++i) {
+        sum += ci[i];
+      }
+      block_sums[blockIdx] = sum;
+    }
+  };
+
+  template <typename T>
+  struct KernelBlockedScanApply {
+    template <typename TAcc>
+    ALPAKA_FN_ACC void operator()(const TAcc& acc,
+                                  T const* ci,
+                                  T* co,
+                                  T const* block_sums,
+                                  uint32_t size) const {
+      const auto blockIdx = alpaka::getIdx<alpaka::Grid, alpaka::Blocks>(acc)[0u];
+      const auto [first, last] = element_index_range_in_grid_truncated(acc, size);
+      // the number of blocks is small, so the partial sums of the preceding blocks
+      // are accumulated directly instead of being scanned in a separate step
+      T partial{0};
+      for (uint32_t block = 0; block < blockIdx; ++block) {
+        partial += block_sums[block];
+      }
+      for (auto i = first; i < last; ++i) {
+        partial += ci[i];
+        co[i] = partial;
+      }
+    }
+  };
+
+  // Computes the inclusive scan of ci into co, choosing at compile time the
+  // implementation that fits the accelerator
+  template <typename TAcc,
+            typename T,
+            typename TQueue,
+            typename = std::enable_if_t<alpaka::isAccelerator<TAcc>>,
+            typename = std::enable_if_t<alpaka::isQueue<TQueue>>>
+  ALPAKA_FN_HOST void inclusivePrefixScan(TQueue& queue,
+                                          T const* ci,
+                                          T* co,
+                                          uint32_t size) {
+    if constexpr (requires_single_thread_per_block_v<TAcc>) {
+      // on the CPU backends each block scans a contiguous chunk of elements
+      const auto elements_per_block = 4096u;
+      const auto gridsize = divide_up_by(size, elements_per_block);
+      const auto workdiv = make_workdiv<TAcc>(gridsize, elements_per_block);
+      auto block_sums = make_device_buffer<T[]>(queue, gridsize);
+      alpaka::exec<TAcc>(
+          queue, workdiv, KernelBlockedScanSums<T>{}, ci, block_sums.data(), size);
+      alpaka::exec<TAcc>(
+          queue, workdiv, KernelBlockedScanApply<T>{}, ci, co, block_sums.data(), size);
+    } else {
+      auto block_counter = make_device_buffer<int32_t>(queue);
+      alpaka::memset(queue, block_counter, 0);
+
+      const auto blocksize = 1024u;
+      const auto gridsize = divide_up_by(size, blocksize);
+      const auto workdiv = make_workdiv<TAcc>(gridsize, blocksize);
+      const auto warp_size = alpaka::getPreferredWarpSize(alpaka::getDev(queue));
+      alpaka::exec<TAcc>(queue,
+                         workdiv,
+                         multiBlockPrefixScan<T>{},
+                         ci,
+                         co,
+                         size,
+                         gridsize,
+                         block_counter.data(),
+                         warp_size);
+    }
+  }
 }  // namespace clue
 
 // declare the amount of block shared memory used by the multiBlockPrefixScan kernel
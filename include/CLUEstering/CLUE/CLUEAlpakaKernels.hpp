@@ -17,14 +17,34 @@ namespace ALPAKA_ACCELERATOR_NAMESPACE_CLUE {
 
   constexpr int32_t max_followers{100};
   constexpr int32_t reserve{1000000};
+  // maximum number of neighbours cached for each point in the density step
+  constexpr int32_t max_neighbours{32};
 
   template <uint8_t Ndim>
   ALPAKA_FN_ACC void getCoords(float* coords, PointsAlpakaView* d_points, uint32_t i) {
     for (auto dim = 0; dim < Ndim; ++dim) {
-      coords[dim] = d_points->coords[i + dim * d_points->n];
+      coords[dim] = d_points->coords[coordIndex<Ndim>(i, dim, d_points->n)];
     }
   }
 
+  // Converts the coordinates copied from the host, which are in SoA layout, to the
+  // layout of the points
+  template <uint8_t Ndim>
+  struct KernelFillCoords {
+    template <typename TAcc>
+    ALPAKA_FN_ACC void operator()(const TAcc& acc,
+                                  const float* soa_coords,
+                                  PointsAlpakaView* d_points,
+                                  uint32_t n_points) const {
+      for (auto i : alpaka::uniformElements(acc, n_points)) {
+        for (uint32_t dim{}; dim != Ndim; ++dim) {
+          d_points->coords[coordIndex<Ndim>(i, dim, n_points)] =
+              soa_coords[i + dim * n_points];
+        }
+      }
+    }
+  };
+
   struct KernelResetFollowers {
     template <typename TAcc>
     ALPAKA_FN_ACC void operator()(const TAcc& acc,
@@ -35,7 +55,122 @@ namespace ALPAKA_ACCELERATOR_NAMESPACE_CLUE {
     }
   };
 
-  template <typename TAcc, uint8_t Ndim, uint8_t N_, typename KernelType>
+  // Accumulates the density of a point with floating point additions, whose result
+  // depends on the order in which the neighbours are visited
+  // The accumulators also receive the squared distance of the neighbour, which is
+  // used by the ones that bin the contributions by distance.
+  struct FloatAccumulator {
+    float value{0.f};
+
+    ALPAKA_FN_ACC inline void add(float contribution, float /*dist_ij_sq*/ = 0.f) {
+      value += contribution;
+    }
+    ALPAKA_FN_ACC inline float result() const { return value; }
+  };
+
+  // Accumulates the density of a point in fixed point, rounding each contribution to a
+  // multiple of 1 / scale. The integer additions are associative, so the result
+  // doesn't depend on the order in which the neighbours are visited, which is set by
+  // the atomics used for filling the tiles.
+  struct FixedPointAccumulator {
+    double scale;
+    int64_t value{0};
+
+    ALPAKA_FN_ACC inline void add(float contribution, float /*dist_ij_sq*/ = 0.f) {
+      const double scaled{contribution * scale};
+      value += static_cast<int64_t>(scaled >= 0. ? scaled + 0.5 : scaled - 0.5);
+    }
+    ALPAKA_FN_ACC inline float result() const {
+      return static_cast<float>(value / scale);
+    }
+  };
+
+  // resolution of the fixed point density used for reproducible results
+  constexpr double fixed_point_scale{1 << 24};
+
+  // Used when the neighbours found in the density step are not cached
+  struct NoNeighbourCache {
+    ALPAKA_FN_ACC inline constexpr void reset(uint32_t) const {}
+    ALPAKA_FN_ACC inline constexpr void record(uint32_t, uint32_t, float) const {}
+  };
+
+  // Squared distance of two points, wrapping the coordinates along the periodic
+  // dimensions of the tiles
+  struct PeriodicDistance {
+    template <uint8_t Ndim>
+    ALPAKA_FN_ACC inline float operator()(TilesAlpakaView<Ndim>* tiles,
+                                          const float* coords_i,
+                                          const float* coords_j) const {
+      return tiles->distance(coords_i, coords_j);
+    }
+  };
+
+  // Squared distance of two points when no dimension of the tiles is periodic, which
+  // doesn't read the wrapping of each dimension for every pair
+  struct EuclideanDistance {
+    template <uint8_t Ndim>
+    ALPAKA_FN_ACC inline float operator()(TilesAlpakaView<Ndim>*,
+                                          const float* coords_i,
+                                          const float* coords_j) const {
+      float dist_sq{0.f};
+      for (int dim{}; dim != Ndim; ++dim) {
+        dist_sq += (coords_i[dim] - coords_j[dim]) * (coords_i[dim] - coords_j[dim]);
+      }
+      return dist_sq;
+    }
+  };
+
+  // Records, for each point, the neighbours found within dm during the density step,
+  // so that the nearest-higher step can read them instead of searching the tiles
+  // again. The neighbours are stored in SoA layout, with the k-th neighbour of the
+  // point i at index i + k * n_points. If a point has more than max_neighbours
+  // neighbours its list is not usable and its size is set above the capacity, and the
+  // nearest-higher step falls back to the search over the tiles for that point.
+  struct NeighbourCache {
+    int32_t* indexes;
+    float* distances;
+    int32_t* sizes;
+    float dm_sq;
+    uint32_t n_points;
+
+    ALPAKA_FN_ACC inline void reset(uint32_t i) const { sizes[i] = 0; }
+
+    ALPAKA_FN_ACC inline void record(uint32_t i, uint32_t j, float dist_ij_sq) const {
+      if (dist_ij_sq <= dm_sq) {
+        const auto k = sizes[i];
+        if (k < max_neighbours) {
+          indexes[i + k * n_points] = j;
+          distances[i + k * n_points] = dist_ij_sq;
+        }
+        sizes[i] = k + 1;
+      }
+    }
+  };
+
+  // Number of neighbours whose contributions to the density are evaluated together
+  constexpr std::size_t kernel_lanes{8};
+
+  template <typename TAcc, typename KernelType, typename TAccumulator>
+  ALPAKA_FN_ACC inline void accumulateLanes(const TAcc& acc,
+                                            const KernelType& kernel,
+                                            const float (&dist_sq)[kernel_lanes],
+                                            const float (&weights)[kernel_lanes],
+                                            std::size_t n_lanes,
+                                            TAccumulator* rho_i) {
+    float values[kernel_lanes];
+    clue::evaluateKernel(acc, kernel, dist_sq, values);
+    for (std::size_t lane{}; lane != n_lanes; ++lane) {
+      rho_i->add(values[lane] * weights[lane], dist_sq[lane]);
+    }
+  }
+
+  template <typename TAcc,
+            uint8_t Ndim,
+            uint8_t N_,
+            typename KernelType,
+            typename TNeighbourCache,
+            typename TDistance,
+            typename TAccumulator>
   ALPAKA_FN_HOST_ACC void for_recursion(
       const TAcc& acc,
       VecArray<uint32_t, Ndim>& base_vec,
@@ -43,8 +178,10 @@ namespace ALPAKA_ACCELERATOR_NAMESPACE_CLUE {
       TilesAlpakaView<Ndim>* tiles,
       PointsAlpakaView* dev_points,
       const KernelType& kernel,
+      const TNeighbourCache& neighbours,
+      const TDistance& distance,
       const float* coords_i,
-      float* rho_i,
+      TAccumulator* rho_i,
       float dc,
       uint32_t point_id) {
     if constexpr (N_ == 0) {
@@ -52,22 +189,40 @@ namespace ALPAKA_ACCELERATOR_NAMESPACE_CLUE {
       // get the size of this bin
       auto binSize = (*tiles)[binId].size();
 
+      // the neighbours are collected in lanes, whose contributions are evaluated
+      // together by the kernel
+      float dist_sq[kernel_lanes]{};
+      float weights[kernel_lanes]{};
+      std::size_t n_lanes{};
+
       // iterate inside this bin
       for (int binIter{}; binIter < binSize; ++binIter) {
         uint32_t j{(*tiles)[binId][binIter]};
+        // the contribution of the point itself is added by the caller
+        if (j == point_id) {
+          continue;
+        }
         // query N_{dc_}(i)
 
         float coords_j[Ndim];
         getCoords<Ndim>(coords_j, dev_points, j);
 
-        float dist_ij_sq = tiles->distance(coords_i, coords_j);
+        float dist_ij_sq = distance(tiles, coords_i, coords_j);
 
         if (dist_ij_sq <= dc * dc) {
-          *rho_i += kernel(acc, alpaka::math::sqrt(acc, dist_ij_sq), point_id, j) *
-                    dev_points->weight[j];
+          dist_sq[n_lanes] = dist_ij_sq;
+          weights[n_lanes] = dev_points->weight[j];
+          if (++n_lanes == kernel_lanes) {
+            accumulateLanes(acc, kernel, dist_sq, weights, n_lanes, rho_i);
+            n_lanes = 0;
+          }
+          neighbours.record(point_id, j, dist_ij_sq);
         }
 
       }  // end of interate inside this bin
+      if (n_lanes > 0) {
+        accumulateLanes(acc, kernel, dist_sq, weights, n_lanes, rho_i);
+      }
       return;
     } else {
       for (unsigned int i{search_box[search_box.capacity() - N_][0]};
@@ -80,6 +235,8 @@ namespace ALPAKA_ACCELERATOR_NAMESPACE_CLUE {
                                           tiles,
                                           dev_points,
                                           kernel,
+                                          neighbours,
+                                          distance,
                                           coords_i,
                                           rho_i,
                                           dc,
@@ -88,46 +245,97 @@ namespace ALPAKA_ACCELERATOR_NAMESPACE_CLUE {
     }
   }
 
+  // Accumulates in rho_i the contributions of the point i and of the points within dc
+  template <typename TAcc,
+            uint8_t Ndim,
+            typename KernelType,
+            typename TNeighbourCache,
+            typename TDistance,
+            typename TAccumulator>
+  ALPAKA_FN_ACC void accumulate_density(const TAcc& acc,
+                                        TilesAlpakaView<Ndim>* dev_tiles,
+                                        PointsAlpakaView* dev_points,
+                                        const KernelType& kernel,
+                                        const TNeighbourCache& neighbours,
+                                        const TDistance& distance,
+                                        TAccumulator* rho_i,
+                                        float dc,
+                                        uint32_t i) {
+    neighbours.reset(i);
+    float coords_i[Ndim];
+    getCoords<Ndim>(coords_i, dev_points, i);
+
+    // Get the extremes of the search box
+    VecArray<VecArray<float, 2>, Ndim> searchbox_extremes;
+    for (int dim{}; dim != Ndim; ++dim) {
+      VecArray<float, 2> dim_extremes;
+      dim_extremes.push_back_unsafe(coords_i[dim] - dc);
+      dim_extremes.push_back_unsafe(coords_i[dim] + dc);
+
+      searchbox_extremes.push_back_unsafe(dim_extremes);
+    }
+
+    // Calculate the search box
+    VecArray<VecArray<uint32_t, 2>, Ndim> search_box;
+    dev_tiles->searchBox(acc, searchbox_extremes, &search_box);
+
+    rho_i->add(kernel.selfContribution() * dev_points->weight[i]);
+    VecArray<uint32_t, Ndim> base_vec;
+    for_recursion<TAcc, Ndim, Ndim>(acc,
+                                    base_vec,
+                                    search_box,
+                                    dev_tiles,
+                                    dev_points,
+                                    kernel,
+                                    neighbours,
+                                    distance,
+                                    coords_i,
+                                    rho_i,
+                                    dc,
+                                    i);
+  }
+
+  // Returns the density of the point i, accumulated from the points within dc
+  template <typename TAcc,
+            uint8_t Ndim,
+            typename KernelType,
+            typename TNeighbourCache,
+            typename TDistance,
+            typename TAccumulator>
+  ALPAKA_FN_ACC float local_density(const TAcc& acc,
+                                    TilesAlpakaView<Ndim>* dev_tiles,
+                                    PointsAlpakaView* dev_points,
+                                    const KernelType& kernel,
+                                    const TNeighbourCache& neighbours,
+                                    const TDistance& distance,
+                                    TAccumulator rho_i,
+                                    float dc,
+                                    uint32_t i) {
+    accumulate_density(
+        acc, dev_tiles, dev_points, kernel, neighbours, distance, &rho_i, dc, i);
+    return rho_i.result();
+  }
+
   struct KernelCalculateLocalDensity {
-    template <typename TAcc, uint8_t Ndim, typename KernelType>
+    template <typename TAcc,
+              uint8_t Ndim,
+              typename KernelType,
+              typename TNeighbourCache,
+              typename TDistance,
+              typename TAccumulator>
     ALPAKA_FN_ACC void operator()(const TAcc& acc,
                                   TilesAlpakaView<Ndim>* dev_tiles,
                                   PointsAlpakaView* dev_points,
                                   const KernelType& kernel,
                                   float dc,
-                                  uint32_t n_points) const {
+                                  uint32_t n_points,
+                                  TNeighbourCache neighbours,
+                                  TDistance distance,
+                                  TAccumulator accumulator) const {
       for (auto i : alpaka::uniformElements(acc, n_points)) {
-        float rho_i{0.f};
-        float coords_i[Ndim];
-        getCoords<Ndim>(coords_i, dev_points, i);
-
-        // Get the extremes of the search box
-        VecArray<VecArray<float, 2>, Ndim> searchbox_extremes;
-        for (int dim{}; dim != Ndim; ++dim) {
-          VecArray<float, 2> dim_extremes;
-          dim_extremes.push_back_unsafe(coords_i[dim] - dc);
-          dim_extremes.push_back_unsafe(coords_i[dim] + dc);
-
-          searchbox_extremes.push_back_unsafe(dim_extremes);
-        }
-
-        // Calculate the search box
-        VecArray<VecArray<uint32_t, 2>, Ndim> search_box;
-        dev_tiles->searchBox(acc, searchbox_extremes, &search_box);
-
-        VecArray<uint32_t, Ndim> base_vec;
-        for_recursion<TAcc, Ndim, Ndim>(acc,
-                                        base_vec,
-                                        search_box,
-                                        dev_tiles,
-                                        dev_points,
-                                        kernel,
-                                        coords_i,
-                                        &rho_i,
-                                        dc,
-                                        i);
-
-        dev_points->rho[i] = rho_i;
+        // each point starts from a copy of the empty accumulator
+        dev_points->rho[i] = local_density(
+            acc, dev_tiles, dev_points, kernel, neighbours, distance, accumulator, dc, i);
       }
     }
   };
@@ -153,12 +361,14 @@ namespace ALPAKA_ACCELERATOR_NAMESPACE_CLUE {
       // iterate inside this bin
       for (int binIter{}; binIter < binSize; ++binIter) {
         unsigned int j{(*tiles)[binId][binIter]};
+        // the ghosts of the periodic boundaries take the index of their original
+        const auto original_j = originalIndex(dev_points, j);
         // query N'_{dm}(i)
         float rho_j{dev_points->rho[j]};
         bool found_higher{(rho_j > rho_i)};
         // in the rare case where rho is the same, use detid
-        found_higher =
-            found_higher || ((rho_j == rho_i) && (rho_j > 0.f) && (j > point_id));
+        found_higher = found_higher ||
+                       ((rho_j == rho_i) && (rho_j > 0.f) && (original_j > point_id));
 
         // Calculate the distance between the two points
         float coords_j[Ndim];
@@ -170,11 +380,13 @@ namespace ALPAKA_ACCELERATOR_NAMESPACE_CLUE {
         }
 
         if (found_higher && dist_ij_sq <= dm_sq) {
-          // find the nearest point within N'_{dm}(i)
-          if (dist_ij_sq < *delta_i) {
+          // find the nearest point within N'_{dm}(i), breaking the ties with the
+          // smallest index so that the result doesn't depend on the order of the points
+          if (dist_ij_sq < *delta_i ||
+              (dist_ij_sq == *delta_i && static_cast<int>(original_j) < *nh_i)) {
             // update delta_i and nearestHigher_i
             *delta_i = dist_ij_sq;
-            *nh_i = j;
+            *nh_i = original_j;
           }
         }
       }  // end of interate inside this bin
@@ -200,6 +412,102 @@ namespace ALPAKA_ACCELERATOR_NAMESPACE_CLUE {
     }
   }
 
+  template <typename TAcc, uint8_t Ndim>
+  ALPAKA_FN_ACC void search_nearest_higher(const TAcc& acc,
+                                           TilesAlpakaView<Ndim>* dev_tiles,
+                                           PointsAlpakaView* dev_points,
+                                           const float* coords_i,
+                                           float rho_i,
+                                           float* delta_i,
+                                           int* nh_i,
+                                           float dm,
+                                           uint32_t point_id) {
+    // Get the extremes of the search box
+    VecArray<VecArray<float, 2>, Ndim> searchbox_extremes;
+    for (int dim{}; dim != Ndim; ++dim) {
+      VecArray<float, 2> dim_extremes;
+      dim_extremes.push_back_unsafe(coords_i[dim] - dm);
+      dim_extremes.push_back_unsafe(coords_i[dim] + dm);
+
+      searchbox_extremes.push_back_unsafe(dim_extremes);
+    }
+
+    // Calculate the search box
+    VecArray<VecArray<uint32_t, 2>, Ndim> search_box;
+    dev_tiles->searchBox(acc, searchbox_extremes, &search_box);
+
+    VecArray<uint32_t, Ndim> base_vec{};
+    for_recursion_nearest_higher<TAcc, Ndim, Ndim>(acc,
+                                                   base_vec,
+                                                   search_box,
+                                                   dev_tiles,
+                                                   dev_points,
+                                                   coords_i,
+                                                   rho_i,
+                                                   delta_i,
+                                                   nh_i,
+                                                   dm * dm,
+                                                   point_id);
+  }
+
+  // Finds the nearest higher of the point i searching the tiles. The squared distance
+  // to it is returned in delta_i.
+  template <typename TAcc, uint8_t Ndim>
+  ALPAKA_FN_ACC void nearest_higher(const TAcc& acc,
+                                    TilesAlpakaView<Ndim>* dev_tiles,
+                                    PointsAlpakaView* dev_points,
+                                    const NoNeighbourCache&,
+                                    float dm,
+                                    uint32_t i,
+                                    float* delta_i,
+                                    int* nh_i) {
+    float coords_i[Ndim];
+    getCoords<Ndim>(coords_i, dev_points, i);
+    float rho_i{dev_points->rho[i]};
+
+    search_nearest_higher(
+        acc, dev_tiles, dev_points, coords_i, rho_i, delta_i, nh_i, dm, i);
+  }
+
+  // Finds the nearest higher of the point i among the neighbours cached during the
+  // density step. It can only be used when dm <= dc, so that all the candidates have
+  // been cached.
+  template <typename TAcc, uint8_t Ndim>
+  ALPAKA_FN_ACC void nearest_higher(const TAcc& acc,
+                                    TilesAlpakaView<Ndim>* dev_tiles,
+                                    PointsAlpakaView* dev_points,
+                                    const NeighbourCache& neighbours,
+                                    float dm,
+                                    uint32_t i,
+                                    float* delta_i,
+                                    int* nh_i) {
+    const auto n_neighbours = neighbours.sizes[i];
+    if (n_neighbours > max_neighbours) {
+      // the neighbours of this point didn't fit in the cache
+      nearest_higher(
+          acc, dev_tiles, dev_points, NoNeighbourCache{}, dm, i, delta_i, nh_i);
+      return;
+    }
+
+    float rho_i{dev_points->rho[i]};
+    const auto n_points = neighbours.n_points;
+    for (int32_t k{}; k < n_neighbours; ++k) {
+      const auto j = static_cast<int>(
+          originalIndex(dev_points, neighbours.indexes[i + k * n_points]));
+      const float dist_ij_sq = neighbours.distances[i + k * n_points];
+      float rho_j{dev_points->rho[j]};
+      bool found_higher{(rho_j > rho_i)};
+      // in the rare case where rho is the same, use detid
+      found_higher = found_higher ||
+                     ((rho_j == rho_i) && (rho_j > 0.f) && (j > static_cast<int>(i)));
+      if (found_higher &&
+          (dist_ij_sq < *delta_i || (dist_ij_sq == *delta_i && j < *nh_i))) {
+        *delta_i = dist_ij_sq;
+        *nh_i = j;
+      }
+    }
+  }
+
   struct KernelCalculateNearestHigher {
     template <typename TAcc, uint8_t Ndim>
     ALPAKA_FN_ACC void operator()(const TAcc& acc,
@@ -208,40 +516,31 @@ namespace ALPAKA_ACCELERATOR_NAMESPACE_CLUE {
                                   float dm,
                                   float,
                                   uint32_t n_points) const {
-      float dm_squared{dm * dm};
       for (auto i : alpaka::uniformElements(acc, n_points)) {
         float delta_i{std::numeric_limits<float>::max()};
         int nh_i{-1};
-        float coords_i[Ndim];
-        getCoords<Ndim>(coords_i, dev_points, i);
-        float rho_i{dev_points->rho[i]};
-
-        // Get the extremes of the search box
-        VecArray<VecArray<float, 2>, Ndim> searchbox_extremes;
-        for (int dim{}; dim != Ndim; ++dim) {
-          VecArray<float, 2> dim_extremes;
-          dim_extremes.push_back_unsafe(coords_i[dim] - dm);
-          dim_extremes.push_back_unsafe(coords_i[dim] + dm);
+        nearest_higher(
+            acc, dev_tiles, dev_points, NoNeighbourCache{}, dm, i, &delta_i, &nh_i);
 
-          searchbox_extremes.push_back_unsafe(dim_extremes);
-        }
+        dev_points->delta[i] = alpaka::math::sqrt(acc, delta_i);
+        dev_points->nearest_higher[i] = nh_i;
+      }
+    }
+  };
 
-        // Calculate the search box
-        VecArray<VecArray<uint32_t, 2>, Ndim> search_box;
-        dev_tiles->searchBox(acc, searchbox_extremes, &search_box);
-
-        VecArray<uint32_t, Ndim> base_vec{};
-        for_recursion_nearest_higher<TAcc, Ndim, Ndim>(acc,
-                                                       base_vec,
-                                                       search_box,
-                                                       dev_tiles,
-                                                       dev_points,
-                                                       coords_i,
-                                                       rho_i,
-                                                       &delta_i,
-                                                       &nh_i,
-                                                       dm_squared,
-                                                       i);
+  // Nearest-higher step reading the neighbours cached during the density step
+  struct KernelCalculateNearestHigherCached {
+    template <typename TAcc, uint8_t Ndim>
+    ALPAKA_FN_ACC void operator()(const TAcc& acc,
+                                  TilesAlpakaView<Ndim>* dev_tiles,
+                                  PointsAlpakaView* dev_points,
+                                  NeighbourCache neighbours,
+                                  float dm,
+                                  uint32_t n_points) const {
+      for (auto i : alpaka::uniformElements(acc, n_points)) {
+        float delta_i{std::numeric_limits<float>::max()};
+        int nh_i{-1};
+        nearest_higher(acc, dev_tiles, dev_points, neighbours, dm, i, &delta_i, &nh_i);
 
         dev_points->delta[i] = alpaka::math::sqrt(acc, delta_i);
         dev_points->nearest_higher[i] = nh_i;
@@ -249,6 +548,38 @@ namespace ALPAKA_ACCELERATOR_NAMESPACE_CLUE {
     }
   };
 
+  // Marks the point i as a seed, a follower of its nearest higher or an outlier
+  template <typename TAcc>
+  ALPAKA_FN_ACC void classify_point(const TAcc& acc,
+                                    VecArray<int32_t, reserve>* seeds,
+                                    VecArray<int32_t, max_followers>* followers,
+                                    PointsAlpakaView* dev_points,
+                                    float delta_i,
+                                    int nh_i,
+                                    float dm,
+                                    float d_c,
+                                    float rho_c,
+                                    uint32_t i) {
+    // initialize cluster_index
+    dev_points->cluster_index[i] = -1;
+
+    float rho_i{dev_points->rho[i]};
+
+    // Determine whether the point is a seed or an outlier
+    bool is_seed{(delta_i > d_c) && (rho_i >= rho_c)};
+    bool is_outlier{(delta_i > dm) && (rho_i < rho_c)};
+
+    if (is_seed) {
+      dev_points->is_seed[i] = 1;
+      seeds->push_back(acc, i);
+    } else {
+      if (!is_outlier) {
+        followers[nh_i].push_back(acc, i);
+      }
+      dev_points->is_seed[i] = 0;
+    }
+  }
+
   template <uint8_t Ndim>
   struct KernelFindClusters {
     template <typename TAcc>
@@ -261,29 +592,111 @@ namespace ALPAKA_ACCELERATOR_NAMESPACE_CLUE {
                                   float rho_c,
                                   uint32_t n_points) const {
       for (auto i : alpaka::uniformElements(acc, n_points)) {
-        // initialize cluster_index
-        dev_points->cluster_index[i] = -1;
-
-        float delta_i{dev_points->delta[i]};
-        float rho_i{dev_points->rho[i]};
-
-        // Determine whether the point is a seed or an outlier
-        bool is_seed{(delta_i > d_c) && (rho_i >= rho_c)};
-        bool is_outlier{(delta_i > dm) && (rho_i < rho_c)};
-
-        if (is_seed) {
-          dev_points->is_seed[i] = 1;
-          seeds->push_back(acc, i);
-        } else {
-          if (!is_outlier) {
-            followers[dev_points->nearest_higher[i]].push_back(acc, i);
-          }
-          dev_points->is_seed[i] = 0;
-        }
+        classify_point(acc,
+                       seeds,
+                       followers,
+                       dev_points,
+                       dev_points->delta[i],
+                       dev_points->nearest_higher[i],
+                       dm,
+                       d_c,
+                       rho_c,
+                       i);
+      }
+    }
+  };
+
+  // Only flags the seeds and the outliers, without registering the seeds and the
+  // followers, for the runs that stop after the classification. The outliers get a
+  // cluster index of -1 and the other points of 0, as the clusters are not assigned.
+  struct KernelClassifyPoints {
+    template <typename TAcc>
+    ALPAKA_FN_ACC void operator()(const TAcc& acc,
+                                  PointsAlpakaView* dev_points,
+                                  float dm,
+                                  float d_c,
+                                  float rho_c,
+                                  uint32_t n_points) const {
+      for (auto i : alpaka::uniformElements(acc, n_points)) {
+        const float delta_i{dev_points->delta[i]};
+        const float rho_i{dev_points->rho[i]};
+        const bool is_seed{(delta_i > d_c) && (rho_i >= rho_c)};
+        const bool is_outlier{(delta_i > dm) && (rho_i < rho_c)};
+        dev_points->is_seed[i] = is_seed ? 1 : 0;
+        dev_points->cluster_index[i] = is_outlier ? -1 : 0;
+      }
+    }
+  };
+
+  // Finds the nearest higher of each point and classifies it right away, registering
+  // it as a seed or as a follower of its nearest higher. This saves a launch and a
+  // pass over the points compared to running KernelCalculateNearestHigher and
+  // KernelFindClusters, and delta never leaves the registers. The delta and nearest
+  // higher of the points are only stored in the debug builds.
+  struct KernelCalculateNearestHigherAndClassify {
+    template <typename TAcc, uint8_t Ndim, typename TNeighbourCache>
+    ALPAKA_FN_ACC void operator()(const TAcc& acc,
+                                  TilesAlpakaView<Ndim>* dev_tiles,
+                                  PointsAlpakaView* dev_points,
+                                  VecArray<int32_t, reserve>* seeds,
+                                  VecArray<int32_t, max_followers>* followers,
+                                  TNeighbourCache neighbours,
+                                  float dm,
+                                  float d_c,
+                                  float rho_c,
+                                  uint32_t n_points) const {
+      for (auto i : alpaka::uniformElements(acc, n_points)) {
+        float delta_i{std::numeric_limits<float>::max()};
+        int nh_i{-1};
+        nearest_higher(acc, dev_tiles, dev_points, neighbours, dm, i, &delta_i, &nh_i);
+        delta_i = alpaka::math::sqrt(acc, delta_i);
+#ifdef CLUE_DEBUG
+        dev_points->delta[i] = delta_i;
+        dev_points->nearest_higher[i] = nh_i;
+#endif
+
+        classify_point(
+            acc, seeds, followers, dev_points, delta_i, nh_i, dm, d_c, rho_c, i);
       }
     }
   };
 
+  // Assigns the index of the cluster to its seed and, going down the followers, to
+  // all the points of the cluster
+  ALPAKA_FN_ACC inline void expand_cluster(const VecArray<int32_t, reserve>& seeds,
+                                           VecArray<int, max_followers>* followers,
+                                           PointsAlpakaView* dev_points,
+                                           int idx_cls) {
+    int local_stack[256] = {-1};
+    int local_stack_size{};
+
+    int idx_this_seed{seeds[idx_cls]};
+    dev_points->cluster_index[idx_this_seed] = idx_cls;
+    // push_back idThisSeed to localStack
+    local_stack[local_stack_size] = idx_this_seed;
+    ++local_stack_size;
+    // process all elements in localStack
+    while (local_stack_size > 0) {
+      // get last element of localStack
+      int idx_end_of_local_stack{local_stack[local_stack_size - 1]};
+      int temp_cluster_index{dev_points->cluster_index[idx_end_of_local_stack]};
+      // pop_back last element of localStack
+      local_stack[local_stack_size - 1] = -1;
+      --local_stack_size;
+      const auto& followers_ies{followers[idx_end_of_local_stack]};
+      const auto followers_size{followers[idx_end_of_local_stack].size()};
+      // loop over followers of last element of localStack
+      for (int j{}; j != followers_size; ++j) {
+        // pass id to follower
+        int follower{followers_ies[j]};
+        dev_points->cluster_index[follower] = temp_cluster_index;
+        // push_back follower to localStack
+        local_stack[local_stack_size] = follower;
+        ++local_stack_size;
+      }
+    }
+  }
+
   template <uint8_t Ndim>
   struct KernelAssignClusters {
     template <typename TAcc>
@@ -294,34 +707,7 @@ namespace ALPAKA_ACCELERATOR_NAMESPACE_CLUE {
       const auto& seeds_0{*seeds};
       const auto n_seeds{seeds_0.size()};
       for (auto idx_cls : alpaka::uniformElements(acc, n_seeds)) {
-        int local_stack[256] = {-1};
-        int local_stack_size{};
-
-        int idx_this_seed{seeds_0[idx_cls]};
-        dev_points->cluster_index[idx_this_seed] = idx_cls;
-        // push_back idThisSeed to localStack
-        local_stack[local_stack_size] = idx_this_seed;
-        ++local_stack_size;
-        // process all elements in localStack
-        while (local_stack_size > 0) {
-          // get last element of localStack
-          int idx_end_of_local_stack{local_stack[local_stack_size - 1]};
-          int temp_cluster_index{dev_points->cluster_index[idx_end_of_local_stack]};
-          // pop_back last element of localStack
-          local_stack[local_stack_size - 1] = -1;
-          --local_stack_size;
-          const auto& followers_ies{followers[idx_end_of_local_stack]};
-          const auto followers_size{followers[idx_end_of_local_stack].size()};
-          // loop over followers of last element of localStack
-          for (int j{}; j != followers_size; ++j) {
-            // pass id to follower
-            int follower{followers_ies[j]};
-            dev_points->cluster_index[follower] = temp_cluster_index;
-            // push_back follower to localStack
-            local_stack[local_stack_size] = follower;
-            ++local_stack_size;
-          }
-        }
+        expand_cluster(seeds_0, followers, dev_points, idx_cls);
       }
     }
   };
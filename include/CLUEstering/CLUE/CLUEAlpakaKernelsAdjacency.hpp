@@ -0,0 +1,292 @@
+#pragma once
+
+#include <alpaka/core/Common.hpp>
+#include <cstdint>
+
+#include "../AlpakaCore/alpakaWorkDiv.hpp"
+#include "../DataFormats/alpaka/AlpakaVecArray.hpp"
+#include "../DataFormats/alpaka/PointsAlpaka.hpp"
+#include "../DataFormats/alpaka/TilesAlpaka.hpp"
+#include "CLUEAlpakaKernels.hpp"
+
+// Adjacency graph of the clusters, where two clusters are linked when a point of one
+// is within a given distance from a point of the other. Each point first lists, with
+// a search over the tiles, the other clusters it touches, together with its smallest
+// distance from each of them. These contacts are then sorted by cluster and
+// neighbouring cluster, so that each run of contacts with the same neighbour gives
+// an edge of the graph.
+namespace ALPAKA_ACCELERATOR_NAMESPACE_CLUE {
+
+  // Number of distinct clusters touched by a point that are merged before being
+  // written. A point touching more clusters can write more than one contact with the
+  // same cluster, which are merged after sorting them.
+  constexpr int32_t max_contacts{16};
+
+  // The contacts of each point, in SoA layout
+  struct ClusterContacts {
+    int32_t* clusters;
+    int32_t* neighbours;
+    uint32_t* points;
+    float* dist_sq;
+    float* weights;
+  };
+
+  // Calls visit with the global bin of each tile in the search box
+  template <typename TAcc, uint8_t Ndim, typename TVisitor>
+  ALPAKA_FN_ACC void forEachTileInBox(const TAcc& acc,
+                                      TilesAlpakaView<Ndim>* tiles,
+                                      const VecArray<VecArray<uint32_t, 2>, Ndim>& s_box,
+                                      TVisitor&& visit) {
+    uint32_t n_tiles{1};
+    for (int32_t dim{}; dim != Ndim; ++dim) {
+      n_tiles *= s_box[dim][1] - s_box[dim][0] + 1;
+    }
+    for (uint32_t k{}; k != n_tiles; ++k) {
+      VecArray<uint32_t, Ndim> bins;
+      uint32_t rest{k};
+      for (int32_t dim{}; dim != Ndim; ++dim) {
+        const auto width = s_box[dim][1] - s_box[dim][0] + 1;
+        bins.push_back_unsafe(s_box[dim][0] + rest % width);
+        rest /= width;
+      }
+      visit(static_cast<uint32_t>(tiles->getGlobalBinByBin(acc, bins)));
+    }
+  }
+
+  // Finds the clusters within distance from the point i, and calls emit with each of
+  // them and the smallest squared distance of the point from it
+  template <typename TAcc, uint8_t Ndim, typename TEmitter>
+  ALPAKA_FN_ACC void findContacts(const TAcc& acc,
+                                  TilesAlpakaView<Ndim>* tiles,
+                                  PointsAlpakaView* dev_points,
+                                  float distance,
+                                  uint32_t i,
+                                  TEmitter&& emit) {
+    const auto cluster_i = dev_points->cluster_index[i];
+    if (cluster_i < 0) {
+      return;
+    }
+    float coords_i[Ndim];
+    getCoords<Ndim>(coords_i, dev_points, i);
+
+    VecArray<VecArray<float, 2>, Ndim> searchbox_extremes;
+    for (int dim{}; dim != Ndim; ++dim) {
+      VecArray<float, 2> dim_extremes;
+      dim_extremes.push_back_unsafe(coords_i[dim] - distance);
+      dim_extremes.push_back_unsafe(coords_i[dim] + distance);
+      searchbox_extremes.push_back_unsafe(dim_extremes);
+    }
+    VecArray<VecArray<uint32_t, 2>, Ndim> search_box;
+    tiles->searchBox(acc, searchbox_extremes, &search_box);
+
+    int32_t clusters[max_contacts];
+    float dist_sq[max_contacts];
+    int32_t n_contacts{};
+    const float distance_sq{distance * distance};
+    forEachTileInBox<TAcc, Ndim>(acc, tiles, search_box, [&](uint32_t bin) {
+      auto points = (*tiles)[bin];
+      for (uint32_t k{}; k != points.size(); ++k) {
+        const auto j = points[k];
+        const auto cluster_j = dev_points->cluster_index[j];
+        if (cluster_j < 0 or cluster_j == cluster_i) {
+          continue;
+        }
+        float coords_j[Ndim];
+        getCoords<Ndim>(coords_j, dev_points, j);
+        const float dist_ij_sq{tiles->distance(coords_i, coords_j)};
+        if (dist_ij_sq > distance_sq) {
+          continue;
+        }
+
+        int32_t c{};
+        while (c != n_contacts and clusters[c] != cluster_j) {
+          ++c;
+        }
+        if (c != n_contacts) {
+          dist_sq[c] = alpaka::math::min(acc, dist_sq[c], dist_ij_sq);
+          continue;
+        }
+        if (n_contacts == max_contacts) {
+          for (c = 0; c != n_contacts; ++c) {
+            emit(clusters[c], dist_sq[c]);
+          }
+          n_contacts = 0;
+        }
+        clusters[n_contacts] = cluster_j;
+        dist_sq[n_contacts] = dist_ij_sq;
+        ++n_contacts;
+      }
+    });
+    for (int32_t c{}; c != n_contacts; ++c) {
+      emit(clusters[c], dist_sq[c]);
+    }
+  }
+
+  template <uint8_t Ndim>
+  struct KernelCountContacts {
+    template <typename TAcc>
+    ALPAKA_FN_ACC void operator()(const TAcc& acc,
+                                  TilesAlpakaView<Ndim>* tiles,
+                                  PointsAlpakaView* dev_points,
+                                  uint32_t* counts,
+                                  float distance,
+                                  uint32_t n_points) const {
+      for (auto i : alpaka::uniformElements(acc, n_points)) {
+        uint32_t count{};
+        findContacts(acc, tiles, dev_points, distance, i, [&](int32_t, float) {
+          ++count;
+        });
+        counts[i] = count;
+      }
+    }
+  };
+
+  // Writes the contacts of the points, where positions is the inclusive scan of their
+  // numbers
+  template <uint8_t Ndim>
+  struct KernelFillContacts {
+    template <typename TAcc>
+    ALPAKA_FN_ACC void operator()(const TAcc& acc,
+                                  TilesAlpakaView<Ndim>* tiles,
+                                  PointsAlpakaView* dev_points,
+                                  const uint32_t* counts,
+                                  const uint32_t* positions,
+                                  ClusterContacts contacts,
+                                  float distance,
+                                  uint32_t n_points) const {
+      for (auto i : alpaka::uniformElements(acc, n_points)) {
+        auto position = positions[i] - counts[i];
+        const auto cluster_i = dev_points->cluster_index[i];
+        const auto weight_i = dev_points->weight[i];
+        findContacts(
+            acc, tiles, dev_points, distance, i, [&](int32_t cluster, float dist_sq) {
+              contacts.clusters[position] = cluster_i;
+              contacts.neighbours[position] = cluster;
+              contacts.points[position] = i;
+              contacts.dist_sq[position] = dist_sq;
+              contacts.weights[position] = weight_i;
+              ++position;
+            });
+      }
+    }
+  };
+
+  // Used for grouping the contacts by cluster in an association map
+  struct GetContactCluster {
+    const int32_t* clusters;
+
+    template <typename TAcc>
+    ALPAKA_FN_ACC uint32_t operator()(const TAcc&, uint32_t i) const {
+      return static_cast<uint32_t>(clusters[i]);
+    }
+  };
+
+  // Orders the contacts by cluster, then by neighbouring cluster and then by point, so
+  // that the sums over them don't depend on the order in which they were written and
+  // the repeated contacts of a point are adjacent
+  struct ContactOrder {
+    ClusterContacts contacts;
+
+    ALPAKA_FN_ACC bool operator()(uint32_t a, uint32_t b) const {
+      if (contacts.clusters[a] != contacts.clusters[b]) {
+        return contacts.clusters[a] < contacts.clusters[b];
+      }
+      if (contacts.neighbours[a] != contacts.neighbours[b]) {
+        return contacts.neighbours[a] < contacts.neighbours[b];
+      }
+      return contacts.points[a] < contacts.points[b];
+    }
+  };
+
+  // Counts the distinct neighbours of each cluster, from the sorted contacts, where
+  // each run of contacts with the same cluster and neighbour starts a new edge. The
+  // counts must be zeroed before the launch.
+  struct KernelCountClusterEdges {
+    template <typename TAcc>
+    ALPAKA_FN_ACC void operator()(const TAcc& acc,
+                                  const uint32_t* indexes,
+                                  ClusterContacts contacts,
+                                  uint32_t* counts,
+                                  uint32_t n_contacts) const {
+      for (auto k : alpaka::uniformElements(acc, n_contacts)) {
+        const auto cluster = contacts.clusters[indexes[k]];
+        if (k == 0 or cluster != contacts.clusters[indexes[k - 1]] or
+            contacts.neighbours[indexes[k]] != contacts.neighbours[indexes[k - 1]]) {
+          alpaka::atomicAdd(acc, &counts[cluster], 1u, alpaka::hierarchy::Blocks{});
+        }
+      }
+    }
+  };
+
+  // Writes the edges of the clusters in CSR format, where positions is the inclusive
+  // scan of their numbers. The boundary weight of an edge is the sum of the weights of
+  // the points of both clusters that touch the other one, so the contacts of the
+  // neighbour with the cluster are found with a binary search over its sorted ones.
+  // The repeated contacts of a point are adjacent, and its weight is only added once.
+  struct KernelFillClusterEdges {
+    template <typename TAcc>
+    ALPAKA_FN_ACC void operator()(const TAcc& acc,
+                                  const uint32_t* offsets,
+                                  const uint32_t* indexes,
+                                  ClusterContacts contacts,
+                                  const uint32_t* counts,
+                                  const uint32_t* positions,
+                                  uint32_t* edge_offsets,
+                                  int32_t* edge_neighbours,
+                                  float* edge_distances,
+                                  float* edge_weights,
+                                  uint32_t n_clusters) const {
+      for (auto cluster : alpaka::uniformElements(acc, n_clusters)) {
+        auto position = positions[cluster] - counts[cluster];
+        edge_offsets[cluster] = position;
+        if (cluster == n_clusters - 1) {
+          edge_offsets[n_clusters] = positions[cluster];
+        }
+
+        const auto last = offsets[cluster + 1];
+        auto k = offsets[cluster];
+        while (k < last) {
+          const auto neighbour = contacts.neighbours[indexes[k]];
+          float min_dist_sq{contacts.dist_sq[indexes[k]]};
+          float weight{};
+          for (auto first = k; k < last and contacts.neighbours[indexes[k]] == neighbour;
+               ++k) {
+            min_dist_sq =
+                alpaka::math::min(acc, min_dist_sq, contacts.dist_sq[indexes[k]]);
+            if (k == first or
+                contacts.points[indexes[k]] != contacts.points[indexes[k - 1]]) {
+              weight += contacts.weights[indexes[k]];
+            }
+          }
+
+          // the contacts of the neighbour with this cluster
+          auto low = offsets[neighbour];
+          auto high = offsets[neighbour + 1];
+          while (low < high) {
+            const auto middle = low + (high - low) / 2;
+            if (contacts.neighbours[indexes[middle]] < static_cast<int32_t>(cluster)) {
+              low = middle + 1;
+            } else {
+              high = middle;
+            }
+          }
+          for (auto l = low; l < offsets[neighbour + 1] and
+                             contacts.neighbours[indexes[l]] ==
+                                 static_cast<int32_t>(cluster);
+               ++l) {
+            if (l == low or
+                contacts.points[indexes[l]] != contacts.points[indexes[l - 1]]) {
+              weight += contacts.weights[indexes[l]];
+            }
+          }
+
+          edge_neighbours[position] = neighbour;
+          edge_distances[position] = alpaka::math::sqrt(acc, min_dist_sq);
+          edge_weights[position] = weight;
+          ++position;
+        }
+      }
+    }
+  };
+
+}  // namespace ALPAKA_ACCELERATOR_NAMESPACE_CLUE
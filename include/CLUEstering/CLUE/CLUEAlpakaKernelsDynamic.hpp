@@ -0,0 +1,251 @@
+#pragma once
+
+#include <alpaka/core/Common.hpp>
+#include <cstdint>
+#include <limits>
+
+#include "../AlpakaCore/alpakaWorkDiv.hpp"
+#include "../DataFormats/alpaka/PointsAlpaka.hpp"
+#include "../DataFormats/alpaka/TilesAlpaka.hpp"
+#include "../DataFormats/alpaka/AlpakaVecArray.hpp"
+#include "CLUEAlpakaKernels.hpp"
+#include "ConvolutionalKernel.hpp"
+
+using clue::VecArray;
+
+// Kernels used when the number of dimensions of the points is only known at runtime.
+// The tiles are built on the first TileDim rows of a SoA buffer of tiling coordinates,
+// which can either be the leading coordinates of the points or a projection of them,
+// while the distances are always computed exactly, looping over all the ndim
+// coordinates of the points.
+namespace ALPAKA_ACCELERATOR_NAMESPACE_CLUE {
+
+  ALPAKA_FN_ACC inline float distance_sq_dynamic(const PointsAlpakaView* dev_points,
+                                                 uint32_t i,
+                                                 uint32_t j,
+                                                 int32_t ndim) {
+    const auto n = dev_points->n;
+    float dist_ij_sq{0.f};
+    for (int32_t dim{}; dim != ndim; ++dim) {
+      const float diff{dev_points->coords[i + dim * n] - dev_points->coords[j + dim * n]};
+      dist_ij_sq += diff * diff;
+    }
+    return dist_ij_sq;
+  }
+
+  template <typename TAcc, uint8_t TileDim>
+  ALPAKA_FN_ACC void getTilingSearchBox(
+      const TAcc& acc,
+      TilesAlpakaView<TileDim>* dev_tiles,
+      const float* tiling_coords,
+      uint32_t n_points,
+      uint32_t i,
+      float radius,
+      VecArray<VecArray<uint32_t, 2>, TileDim>* search_box) {
+    VecArray<VecArray<float, 2>, TileDim> searchbox_extremes;
+    for (int dim{}; dim != TileDim; ++dim) {
+      const float coord_i{tiling_coords[i + dim * n_points]};
+      VecArray<float, 2> dim_extremes;
+      dim_extremes.push_back_unsafe(coord_i - radius);
+      dim_extremes.push_back_unsafe(coord_i + radius);
+
+      searchbox_extremes.push_back_unsafe(dim_extremes);
+    }
+
+    dev_tiles->searchBox(acc, searchbox_extremes, search_box);
+  }
+
+  template <typename TAcc,
+            uint8_t TileDim,
+            uint8_t N_,
+            typename KernelType,
+            typename TAccumulator>
+  ALPAKA_FN_HOST_ACC void for_recursion_dynamic(
+      const TAcc& acc,
+      VecArray<uint32_t, TileDim>& base_vec,
+      const VecArray<VecArray<uint32_t, 2>, TileDim>& search_box,
+      TilesAlpakaView<TileDim>* tiles,
+      PointsAlpakaView* dev_points,
+      const KernelType& kernel,
+      TAccumulator* rho_i,
+      float dc,
+      int32_t ndim,
+      uint32_t point_id) {
+    if constexpr (N_ == 0) {
+      auto binId = tiles->getGlobalBinByBin(acc, base_vec);
+      // get the size of this bin
+      auto binSize = (*tiles)[binId].size();
+
+      // iterate inside this bin
+      for (int binIter{}; binIter < binSize; ++binIter) {
+        uint32_t j{(*tiles)[binId][binIter]};
+        // the contribution of the point itself is added by the caller
+        if (j == point_id) {
+          continue;
+        }
+        // query N_{dc_}(i)
+        float dist_ij_sq = distance_sq_dynamic(dev_points, point_id, j, ndim);
+
+        if (dist_ij_sq <= dc * dc) {
+          rho_i->add(kernel(acc, dist_ij_sq) * dev_points->weight[j], dist_ij_sq);
+        }
+      }  // end of interate inside this bin
+      return;
+    } else {
+      for (unsigned int i{search_box[search_box.capacity() - N_][0]};
+           i <= search_box[search_box.capacity() - N_][1];
+           ++i) {
+        base_vec[base_vec.capacity() - N_] = i;
+        for_recursion_dynamic<TAcc, TileDim, N_ - 1>(acc,
+                                                     base_vec,
+                                                     search_box,
+                                                     tiles,
+                                                     dev_points,
+                                                     kernel,
+                                                     rho_i,
+                                                     dc,
+                                                     ndim,
+                                                     point_id);
+      }
+    }
+  }
+
+  struct KernelCalculateLocalDensityDynamic {
+    template <typename TAcc, uint8_t TileDim, typename KernelType, typename TAccumulator>
+    ALPAKA_FN_ACC void operator()(const TAcc& acc,
+                                  TilesAlpakaView<TileDim>* dev_tiles,
+                                  PointsAlpakaView* dev_points,
+                                  const float* tiling_coords,
+                                  const KernelType& kernel,
+                                  float dc,
+                                  int32_t ndim,
+                                  uint32_t n_points,
+                                  TAccumulator accumulator) const {
+      for (auto i : alpaka::uniformElements(acc, n_points)) {
+        // each point starts from a copy of the empty accumulator
+        TAccumulator rho_i{accumulator};
+        rho_i.add(kernel.selfContribution() * dev_points->weight[i]);
+
+        VecArray<VecArray<uint32_t, 2>, TileDim> search_box;
+        getTilingSearchBox<TAcc, TileDim>(
+            acc, dev_tiles, tiling_coords, n_points, i, dc, &search_box);
+
+        VecArray<uint32_t, TileDim> base_vec;
+        for_recursion_dynamic<TAcc, TileDim, TileDim>(acc,
+                                                      base_vec,
+                                                      search_box,
+                                                      dev_tiles,
+                                                      dev_points,
+                                                      kernel,
+                                                      &rho_i,
+                                                      dc,
+                                                      ndim,
+                                                      i);
+
+        dev_points->rho[i] = rho_i.result();
+      }
+    }
+  };
+
+  template <typename TAcc, uint8_t TileDim, uint8_t N_>
+  ALPAKA_FN_HOST_ACC void for_recursion_nearest_higher_dynamic(
+      const TAcc& acc,
+      VecArray<uint32_t, TileDim>& base_vec,
+      const VecArray<VecArray<uint32_t, 2>, TileDim>& s_box,
+      TilesAlpakaView<TileDim>* tiles,
+      PointsAlpakaView* dev_points,
+      float rho_i,
+      float* delta_i,
+      int* nh_i,
+      float dm_sq,
+      int32_t ndim,
+      uint32_t point_id) {
+    if constexpr (N_ == 0) {
+      int binId{tiles->getGlobalBinByBin(acc, base_vec)};
+      // get the size of this bin
+      int binSize{(*tiles)[binId].size()};
+
+      // iterate inside this bin
+      for (int binIter{}; binIter < binSize; ++binIter) {
+        unsigned int j{(*tiles)[binId][binIter]};
+        // query N'_{dm}(i)
+        float rho_j{dev_points->rho[j]};
+        bool found_higher{(rho_j > rho_i)};
+        // in the rare case where rho is the same, use detid
+        found_higher =
+            found_higher || ((rho_j == rho_i) && (rho_j > 0.f) && (j > point_id));
+        if (!found_higher) {
+          continue;
+        }
+
+        float dist_ij_sq = distance_sq_dynamic(dev_points, point_id, j, ndim);
+        // find the nearest point within N'_{dm}(i)
+        // the ties are broken with the smallest index
+        if (dist_ij_sq <= dm_sq &&
+            (dist_ij_sq < *delta_i ||
+             (dist_ij_sq == *delta_i && static_cast<int>(j) < *nh_i))) {
+          // update delta_i and nearestHigher_i
+          *delta_i = dist_ij_sq;
+          *nh_i = j;
+        }
+      }  // end of interate inside this bin
+
+      return;
+    } else {
+      for (unsigned int i{s_box[s_box.capacity() - N_][0]};
+           i <= s_box[s_box.capacity() - N_][1];
+           ++i) {
+        base_vec[base_vec.capacity() - N_] = i;
+        for_recursion_nearest_higher_dynamic<TAcc, TileDim, N_ - 1>(acc,
+                                                                    base_vec,
+                                                                    s_box,
+                                                                    tiles,
+                                                                    dev_points,
+                                                                    rho_i,
+                                                                    delta_i,
+                                                                    nh_i,
+                                                                    dm_sq,
+                                                                    ndim,
+                                                                    point_id);
+      }
+    }
+  }
+
+  struct KernelCalculateNearestHigherDynamic {
+    template <typename TAcc, uint8_t TileDim>
+    ALPAKA_FN_ACC void operator()(const TAcc& acc,
+                                  TilesAlpakaView<TileDim>* dev_tiles,
+                                  PointsAlpakaView* dev_points,
+                                  const float* tiling_coords,
+                                  float dm,
+                                  int32_t ndim,
+                                  uint32_t n_points) const {
+      for (auto i : alpaka::uniformElements(acc, n_points)) {
+        float delta_i{std::numeric_limits<float>::max()};
+        int nh_i{-1};
+        float rho_i{dev_points->rho[i]};
+
+        VecArray<VecArray<uint32_t, 2>, TileDim> search_box;
+        getTilingSearchBox<TAcc, TileDim>(
+            acc, dev_tiles, tiling_coords, n_points, i, dm, &search_box);
+
+        VecArray<uint32_t, TileDim> base_vec{};
+        for_recursion_nearest_higher_dynamic<TAcc, TileDim, TileDim>(acc,
+                                                                     base_vec,
+                                                                     search_box,
+                                                                     dev_tiles,
+                                                                     dev_points,
+                                                                     rho_i,
+                                                                     &delta_i,
+                                                                     &nh_i,
+                                                                     dm * dm,
+                                                                     ndim,
+                                                                     i);
+
+        dev_points->delta[i] = alpaka::math::sqrt(acc, delta_i);
+        dev_points->nearest_higher[i] = nh_i;
+      }
+    }
+  };
+
+}  // namespace ALPAKA_ACCELERATOR_NAMESPACE_CLUE
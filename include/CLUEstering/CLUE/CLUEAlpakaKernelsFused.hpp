@@ -0,0 +1,137 @@
+#pragma once
+
+#include <alpaka/core/Common.hpp>
+#include <cstdint>
+#include <limits>
+
+#include "../AlpakaCore/alpakaWorkDiv.hpp"
+#include "../DataFormats/alpaka/PointsAlpaka.hpp"
+#include "../DataFormats/alpaka/TilesAlpaka.hpp"
+#include "../DataFormats/alpaka/AlpakaVecArray.hpp"
+#include "CLUEAlpakaKernels.hpp"
+
+namespace ALPAKA_ACCELERATOR_NAMESPACE_CLUE {
+
+  // Suggested largest number of points clustered with the fused kernel on the serial
+  // backend, where the cost of launching the separate kernels dominates
+  constexpr uint32_t fused_max_points{10000};
+
+  // Runs all the stages of the algorithm, from the filling of the tiles to the
+  // assignment of the clusters, in a single launch. It must be launched with a single
+  // block, whose threads are synchronized between the stages, so it's meant for small
+  // events that are processed efficiently by one block.
+  // The geometry of the tiles must already be set. The scratch buffer must contain
+  // n_points elements for the bins of the points and ntiles for the fill offsets.
+  struct KernelFusedClustering {
+    template <typename TAcc, uint8_t Ndim, typename KernelType, typename TAccumulator>
+    ALPAKA_FN_ACC void operator()(const TAcc& acc,
+                                  TilesAlpakaView<Ndim>* dev_tiles,
+                                  PointsAlpakaView* dev_points,
+                                  VecArray<int32_t, reserve>* seeds,
+                                  VecArray<int32_t, max_followers>* followers,
+                                  uint32_t* scratch,
+                                  const KernelType& kernel,
+                                  float dc,
+                                  float rhoc,
+                                  float dm,
+                                  uint32_t n_points,
+                                  TAccumulator accumulator,
+                                  bool sort_seeds) const {
+      const bool first_thread{
+          alpaka::getIdx<alpaka::Block, alpaka::Threads>(acc)[0u] == 0};
+      const auto n_tiles = static_cast<uint32_t>(dev_tiles->ntiles);
+      uint32_t* bins = scratch;
+      uint32_t* fill_offsets = scratch + n_points;
+      uint32_t* offsets = dev_tiles->offsets;
+
+      // reset the tiles and the clusters of the previous event
+      for (auto bin : alpaka::uniformElements(acc, n_tiles + 1)) {
+        offsets[bin] = 0;
+      }
+      for (auto i : alpaka::uniformElements(acc, n_points)) {
+        followers[i].reset();
+      }
+      if (first_thread) {
+        seeds->reset();
+      }
+      alpaka::syncBlockThreads(acc);
+
+      // count the points in each tile, shifted by one to get the offsets from the scan
+      for (auto i : alpaka::uniformElements(acc, n_points)) {
+        float coords_i[Ndim];
+        getCoords<Ndim>(coords_i, dev_points, i);
+        bins[i] = dev_tiles->getGlobalBin(acc, coords_i);
+        alpaka::atomicAdd(acc, &offsets[bins[i] + 1], 1u, alpaka::hierarchy::Threads{});
+      }
+      alpaka::syncBlockThreads(acc);
+      // the events are small, so the scan is done by a single thread
+      if (first_thread) {
+        for (uint32_t bin{1}; bin <= n_tiles; ++bin) {
+          offsets[bin] += offsets[bin - 1];
+        }
+      }
+      alpaka::syncBlockThreads(acc);
+      for (auto bin : alpaka::uniformElements(acc, n_tiles)) {
+        fill_offsets[bin] = offsets[bin];
+      }
+      alpaka::syncBlockThreads(acc);
+      for (auto i : alpaka::uniformElements(acc, n_points)) {
+        const auto position = alpaka::atomicAdd(
+            acc, &fill_offsets[bins[i]], 1u, alpaka::hierarchy::Threads{});
+        dev_tiles->indexes[position] = i;
+      }
+      alpaka::syncBlockThreads(acc);
+
+      for (auto i : alpaka::uniformElements(acc, n_points)) {
+        dev_points->rho[i] = local_density(acc,
+                                           dev_tiles,
+                                           dev_points,
+                                           kernel,
+                                           NoNeighbourCache{},
+                                           PeriodicDistance{},
+                                           accumulator,
+                                           dc,
+                                           i);
+      }
+      alpaka::syncBlockThreads(acc);
+
+      // each point is classified as soon as its nearest higher is found
+      for (auto i : alpaka::uniformElements(acc, n_points)) {
+        float delta_i{std::numeric_limits<float>::max()};
+        int nh_i{-1};
+        nearest_higher(
+            acc, dev_tiles, dev_points, NoNeighbourCache{}, dm, i, &delta_i, &nh_i);
+        delta_i = alpaka::math::sqrt(acc, delta_i);
+#ifdef CLUE_DEBUG
+        dev_points->delta[i] = delta_i;
+        dev_points->nearest_higher[i] = nh_i;
+#endif
+
+        classify_point(acc, seeds, followers, dev_points, delta_i, nh_i, dm, dc, rhoc, i);
+      }
+      alpaka::syncBlockThreads(acc);
+
+      // the seeds are pushed with atomics, so their order changes between runs when
+      // the block has more than one thread
+      if (sort_seeds and first_thread) {
+        auto& seeds_0 = *seeds;
+        for (int k{1}; k < seeds_0.size(); ++k) {
+          const auto seed = seeds_0[k];
+          int l{k - 1};
+          for (; l >= 0 and seeds_0[l] > seed; --l) {
+            seeds_0[l + 1] = seeds_0[l];
+          }
+          seeds_0[l + 1] = seed;
+        }
+      }
+      alpaka::syncBlockThreads(acc);
+
+      const auto& seeds_0{*seeds};
+      const auto n_seeds = static_cast<uint32_t>(seeds_0.size());
+      for (auto idx_cls : alpaka::uniformElements(acc, n_seeds)) {
+        expand_cluster(seeds_0, followers, dev_points, idx_cls);
+      }
+    }
+  };
+
+}  // namespace ALPAKA_ACCELERATOR_NAMESPACE_CLUE
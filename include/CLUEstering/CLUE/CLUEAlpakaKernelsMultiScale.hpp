@@ -0,0 +1,88 @@
+#pragma once
+
+#include <alpaka/core/Common.hpp>
+#include <cstdint>
+
+#include "../AlpakaCore/alpakaWorkDiv.hpp"
+#include "../DataFormats/alpaka/PointsAlpaka.hpp"
+#include "../DataFormats/alpaka/TilesAlpaka.hpp"
+#include "CLUEAlpakaKernels.hpp"
+
+// Kernels used for clustering the points at several scales, where the densities of
+// all the scales are computed with a single search of the neighbours within the
+// largest radius.
+namespace ALPAKA_ACCELERATOR_NAMESPACE_CLUE {
+
+  constexpr int32_t max_scales{8};
+
+  // Squared radii of the scales, in ascending order
+  struct ScaleRadii {
+    float dc_sq[max_scales];
+    int32_t n_scales;
+  };
+
+  // Bins the contributions to the density by the smallest scale whose radius contains
+  // the neighbour, so that the density at each scale is the sum of the bins up to it.
+  // The bins are summed in a fixed order, so with the fixed point accumulator the
+  // densities are still reproducible.
+  template <typename TAccumulator>
+  struct MultiScaleAccumulator {
+    ScaleRadii radii;
+    TAccumulator bins[max_scales];
+
+    ALPAKA_FN_ACC MultiScaleAccumulator(const ScaleRadii& scale_radii,
+                                        const TAccumulator& accumulator)
+        : radii{scale_radii} {
+      for (int32_t scale{}; scale != max_scales; ++scale) {
+        bins[scale] = accumulator;
+      }
+    }
+
+    ALPAKA_FN_ACC inline void add(float contribution, float dist_ij_sq = 0.f) {
+      int32_t scale{};
+      while (scale < radii.n_scales - 1 and dist_ij_sq > radii.dc_sq[scale]) {
+        ++scale;
+      }
+      bins[scale].add(contribution);
+    }
+
+    ALPAKA_FN_ACC inline float result(int32_t scale) const {
+      float rho{0.f};
+      for (int32_t bin{}; bin <= scale; ++bin) {
+        rho += bins[bin].result();
+      }
+      return rho;
+    }
+  };
+
+  // Writes the density of the point i at the scale s at index i + s * n_points
+  struct KernelCalculateMultiScaleDensity {
+    template <typename TAcc, uint8_t Ndim, typename KernelType, typename TAccumulator>
+    ALPAKA_FN_ACC void operator()(const TAcc& acc,
+                                  TilesAlpakaView<Ndim>* dev_tiles,
+                                  PointsAlpakaView* dev_points,
+                                  const KernelType& kernel,
+                                  ScaleRadii radii,
+                                  float* rho_scales,
+                                  uint32_t n_points,
+                                  TAccumulator accumulator) const {
+      const float max_dc{alpaka::math::sqrt(acc, radii.dc_sq[radii.n_scales - 1])};
+      for (auto i : alpaka::uniformElements(acc, n_points)) {
+        MultiScaleAccumulator<TAccumulator> rho_i{radii, accumulator};
+        accumulate_density(acc,
+                           dev_tiles,
+                           dev_points,
+                           kernel,
+                           NoNeighbourCache{},
+                           PeriodicDistance{},
+                           &rho_i,
+                           max_dc,
+                           i);
+        for (int32_t scale{}; scale != radii.n_scales; ++scale) {
+          rho_scales[i + scale * n_points] = rho_i.result(scale);
+        }
+      }
+    }
+  };
+
+}  // namespace ALPAKA_ACCELERATOR_NAMESPACE_CLUE
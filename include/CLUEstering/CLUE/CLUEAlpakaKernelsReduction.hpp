@@ -0,0 +1,132 @@
+#pragma once
+
+#include <alpaka/core/Common.hpp>
+#include <cstdint>
+
+#include "../AlpakaCore/alpakaWorkDiv.hpp"
+#include "../DataFormats/alpaka/PointsAlpaka.hpp"
+#include "CLUEAlpakaKernels.hpp"
+#include "ClusterReduction.hpp"
+
+// Segmented reduction of the points over the clusters. The points are grouped by
+// cluster with an association map, whose indexes are a permutation of the points
+// sorted by cluster. The points of each cluster are split in chunks, which are
+// reduced in parallel by the threads of a block, and the values of the chunks of
+// each cluster are then combined.
+namespace ALPAKA_ACCELERATOR_NAMESPACE_CLUE {
+
+  // Used for grouping the points by cluster, where the outliers go to an additional
+  // bin after the ones of the clusters
+  struct GetClusterBin {
+    const int* cluster_index;
+    uint32_t n_clusters;
+
+    template <typename TAcc>
+    ALPAKA_FN_ACC uint32_t operator()(const TAcc&, uint32_t i) const {
+      const auto cluster = cluster_index[i];
+      return cluster < 0 ? n_clusters : static_cast<uint32_t>(cluster);
+    }
+  };
+
+  // Largest number of points of a cluster reduced by a block, which is also the
+  // number of threads of the blocks on the GPU backends
+  constexpr uint32_t reduction_chunk_size{256};
+
+  // Counts the chunks of reduction_chunk_size points in which each cluster is split
+  struct KernelCountReductionChunks {
+    template <typename TAcc>
+    ALPAKA_FN_ACC void operator()(const TAcc& acc,
+                                  const uint32_t* offsets,
+                                  uint32_t* chunks,
+                                  uint32_t n_clusters) const {
+      for (auto cluster : alpaka::uniformElements(acc, n_clusters)) {
+        const auto size = offsets[cluster + 1] - offsets[cluster];
+        chunks[cluster] = (size + reduction_chunk_size - 1) / reduction_chunk_size;
+      }
+    }
+  };
+
+  // Each block reduces a chunk of the points of a cluster, at indexes offsets[c] to
+  // offsets[c + 1] of the permutation. Each thread folds its own points, and the
+  // values of the threads are then combined in shared memory. The chunks of the
+  // cluster c are numbered from chunk_offsets[c - 1], given by the inclusive scan of
+  // their number.
+  template <uint8_t Ndim>
+  struct KernelReduceClusterChunks {
+    template <typename TAcc, typename TReduction>
+    ALPAKA_FN_ACC void operator()(const TAcc& acc,
+                                  PointsAlpakaView* dev_points,
+                                  const uint32_t* offsets,
+                                  const uint32_t* indexes,
+                                  const uint32_t* chunk_offsets,
+                                  TReduction reduction,
+                                  typename TReduction::value_type* chunk_values,
+                                  uint32_t n_clusters) const {
+      using value_type = typename TReduction::value_type;
+      const auto chunk = alpaka::getIdx<alpaka::Grid, alpaka::Blocks>(acc)[0u];
+      const auto thread = alpaka::getIdx<alpaka::Block, alpaka::Threads>(acc)[0u];
+      const auto n_threads = alpaka::getWorkDiv<alpaka::Block, alpaka::Threads>(acc)[0u];
+
+      // the cluster of the chunk is the first one whose chunks end after it
+      uint32_t low{0}, high{n_clusters - 1};
+      while (low < high) {
+        const auto mid = (low + high) / 2;
+        if (chunk_offsets[mid] > chunk) {
+          high = mid;
+        } else {
+          low = mid + 1;
+        }
+      }
+      const auto cluster = low;
+      const auto first_chunk = cluster == 0 ? 0u : chunk_offsets[cluster - 1];
+      const auto begin = offsets[cluster] + (chunk - first_chunk) * reduction_chunk_size;
+      const auto size =
+          alpaka::math::min(acc, reduction_chunk_size, offsets[cluster + 1] - begin);
+
+      auto& values =
+          alpaka::declareSharedVar<value_type[reduction_chunk_size], __COUNTER__>(acc);
+      auto value = reduction.identity();
+      for (auto k : alpaka::uniformElementsWithinBlock(acc, size)) {
+        const auto i = indexes[begin + k];
+        float coords_i[Ndim];
+        getCoords<Ndim>(coords_i, dev_points, i);
+        reduction.accumulate(acc, value, coords_i, dev_points->weight[i], i);
+      }
+      values[thread] = value;
+      alpaka::syncBlockThreads(acc);
+
+      for (uint32_t stride{1}; stride < n_threads; stride *= 2) {
+        if (thread % (2 * stride) == 0 and thread + stride < n_threads) {
+          reduction.combine(acc, values[thread], values[thread + stride]);
+        }
+        alpaka::syncBlockThreads(acc);
+      }
+      if (thread == 0) {
+        chunk_values[chunk] = values[0];
+      }
+    }
+  };
+
+  // Each work item combines the values of the chunks of a cluster
+  template <typename TReduction>
+  struct KernelCombineClusterChunks {
+    template <typename TAcc>
+    ALPAKA_FN_ACC void operator()(const TAcc& acc,
+                                  const uint32_t* chunk_offsets,
+                                  TReduction reduction,
+                                  const typename TReduction::value_type* chunk_values,
+                                  typename TReduction::value_type* values,
+                                  uint32_t n_clusters) const {
+      for (auto cluster : alpaka::uniformElements(acc, n_clusters)) {
+        const auto first_chunk = cluster == 0 ? 0u : chunk_offsets[cluster - 1];
+        auto value = reduction.identity();
+        for (auto chunk = first_chunk; chunk < chunk_offsets[cluster]; ++chunk) {
+          reduction.combine(acc, value, chunk_values[chunk]);
+        }
+        clue::finalizeReduction(acc, reduction, value);
+        values[cluster] = value;
+      }
+    }
+  };
+
+}  // namespace ALPAKA_ACCELERATOR_NAMESPACE_CLUE
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <alpaka/core/Common.hpp>
+#include <cstdint>
+#include <limits>
+
+#include "../AlpakaCore/alpakaWorkDiv.hpp"
+#include "../DataFormats/alpaka/PointsAlpaka.hpp"
+#include "../DataFormats/alpaka/TilesAlpaka.hpp"
+
+// Kernels used for clustering a subset of the points already resident on the device.
+// The selected points are gathered in a separate set of points, which is clustered
+// as usual, and the results are then scattered back to the positions of the points
+// in the full set.
+namespace ALPAKA_ACCELERATOR_NAMESPACE_CLUE {
+
+  struct KernelMaskToCounts {
+    template <typename TAcc>
+    ALPAKA_FN_ACC void operator()(const TAcc& acc,
+                                  const uint8_t* mask,
+                                  uint32_t* counts,
+                                  uint32_t n_points) const {
+      for (auto i : alpaka::uniformElements(acc, n_points)) {
+        counts[i] = mask[i] ? 1u : 0u;
+      }
+    }
+  };
+
+  // Writes the indexes of the points selected by the mask, in increasing order, using
+  // the inclusive scan of the mask to find their positions
+  struct KernelCompactMask {
+    template <typename TAcc>
+    ALPAKA_FN_ACC void operator()(const TAcc& acc,
+                                  const uint8_t* mask,
+                                  const uint32_t* positions,
+                                  uint32_t* selected,
+                                  uint32_t n_points) const {
+      for (auto i : alpaka::uniformElements(acc, n_points)) {
+        if (mask[i]) {
+          selected[positions[i] - 1] = i;
+        }
+      }
+    }
+  };
+
+  template <uint8_t Ndim>
+  struct KernelGatherPoints {
+    template <typename TAcc>
+    ALPAKA_FN_ACC void operator()(const TAcc& acc,
+                                  PointsAlpakaView* all_points,
+                                  PointsAlpakaView* subset_points,
+                                  const uint32_t* selected,
+                                  uint32_t n_selected) const {
+      const auto n_all = static_cast<uint32_t>(all_points->n);
+      for (auto k : alpaka::uniformElements(acc, n_selected)) {
+        const auto i = selected[k];
+        for (uint32_t dim{}; dim != Ndim; ++dim) {
+          subset_points->coords[coordIndex<Ndim>(k, dim, n_selected)] =
+              all_points->coords[coordIndex<Ndim>(i, dim, n_all)];
+        }
+        subset_points->weight[k] = all_points->weight[i];
+      }
+    }
+  };
+
+  // Computes the extremes of the coordinates of the points, which must be initialised
+  // to the largest and the lowest floats
+  template <uint8_t Ndim>
+  struct KernelCalculateExtremes {
+    template <typename TAcc>
+    ALPAKA_FN_ACC void operator()(const TAcc& acc,
+                                  PointsAlpakaView* dev_points,
+                                  CoordinateExtremes<Ndim>* min_max,
+                                  uint32_t n_points) const {
+      float thread_min[Ndim];
+      float thread_max[Ndim];
+      for (uint32_t dim{}; dim != Ndim; ++dim) {
+        thread_min[dim] = std::numeric_limits<float>::max();
+        thread_max[dim] = std::numeric_limits<float>::lowest();
+      }
+      bool found{false};
+      for (auto i : alpaka::uniformElements(acc, n_points)) {
+        found = true;
+        for (uint32_t dim{}; dim != Ndim; ++dim) {
+          const auto coord = dev_points->coords[coordIndex<Ndim>(i, dim, n_points)];
+          thread_min[dim] = alpaka::math::min(acc, thread_min[dim], coord);
+          thread_max[dim] = alpaka::math::max(acc, thread_max[dim], coord);
+        }
+      }
+      // only one atomic per dimension for each thread that processed some points
+      if (found) {
+        for (uint32_t dim{}; dim != Ndim; ++dim) {
+          alpaka::atomicMin(acc, &min_max->min(dim), thread_min[dim]);
+          alpaka::atomicMax(acc, &min_max->max(dim), thread_max[dim]);
+        }
+      }
+    }
+  };
+
+  template <uint8_t Ndim>
+  struct KernelCalculateTileSizes {
+    template <typename TAcc>
+    ALPAKA_FN_ACC void operator()(const TAcc& acc,
+                                  const CoordinateExtremes<Ndim>* min_max,
+                                  float* tile_sizes,
+                                  int32_t n_per_dim) const {
+      for (auto dim : alpaka::uniformElements(acc, static_cast<uint32_t>(Ndim))) {
+        tile_sizes[dim] = min_max->range(dim) / n_per_dim;
+      }
+    }
+  };
+
+  // The points that are not selected are left unassigned, with a cluster index of -1
+  struct KernelResetResults {
+    template <typename TAcc>
+    ALPAKA_FN_ACC void operator()(const TAcc& acc,
+                                  PointsAlpakaView* all_points,
+                                  uint32_t n_points) const {
+      for (auto i : alpaka::uniformElements(acc, n_points)) {
+        all_points->cluster_index[i] = -1;
+        all_points->is_seed[i] = 0;
+#ifdef CLUE_DEBUG
+        all_points->rho[i] = 0.f;
+        all_points->delta[i] = std::numeric_limits<float>::max();
+        all_points->nearest_higher[i] = -1;
+#endif
+      }
+    }
+  };
+
+  // The nearest-higher of the selected points is translated to the indexes of the
+  // full set
+  struct KernelScatterResults {
+    template <typename TAcc>
+    ALPAKA_FN_ACC void operator()(const TAcc& acc,
+                                  PointsAlpakaView* subset_points,
+                                  PointsAlpakaView* all_points,
+                                  const uint32_t* selected,
+                                  uint32_t n_selected) const {
+      for (auto k : alpaka::uniformElements(acc, n_selected)) {
+        const auto i = selected[k];
+        all_points->cluster_index[i] = subset_points->cluster_index[k];
+        all_points->is_seed[i] = subset_points->is_seed[k];
+#ifdef CLUE_DEBUG
+        all_points->rho[i] = subset_points->rho[k];
+        all_points->delta[i] = subset_points->delta[k];
+        const auto nh = subset_points->nearest_higher[k];
+        all_points->nearest_higher[i] = nh >= 0 ? static_cast<int>(selected[nh]) : -1;
+#endif
+      }
+    }
+  };
+
+}  // namespace ALPAKA_ACCELERATOR_NAMESPACE_CLUE
@@ -0,0 +1,342 @@
+#pragma once
+
+#include <alpaka/core/Common.hpp>
+#include <cstdint>
+#include <limits>
+
+#include "../AlpakaCore/alpakaWorkDiv.hpp"
+#include "../DataFormats/alpaka/PointsAlpaka.hpp"
+#include "../DataFormats/alpaka/TilesAlpaka.hpp"
+#include "CLUEAlpakaKernels.hpp"
+
+// Evaluation of the density and of the nearest higher over pairs of tiles. The tiles
+// that can contain points within the search radius of the points of a tile are listed
+// once per tile, instead of being found again by the search box of each point. Each
+// work item then processes a tile, loading blocks of its points and of the points of
+// the tiles in its list, and evaluating all the pairs between the two blocks, so that
+// the coordinates of the neighbours are read from memory once per block of points
+// rather than once per point. Only used for the tiles without wrapped coordinates.
+namespace ALPAKA_ACCELERATOR_NAMESPACE_CLUE {
+
+  // Number of points of a tile loaded together, both as targets and as sources
+  constexpr uint32_t tile_block{16};
+
+  // The neighbours of the tile t are the tiles at indexes offsets[t] to
+  // offsets[t + 1] of tiles
+  struct TileInteractions {
+    const uint32_t* offsets;
+    const uint32_t* tiles;
+  };
+
+  // Visits the tiles whose boxes are within radius from the box of the tile, and calls
+  // visit with the global bin of each of them
+  template <typename TAcc, uint8_t Ndim, typename TVisitor>
+  ALPAKA_FN_ACC void forEachTileInRange(const TAcc& acc,
+                                        const TilesAlpakaView<Ndim>* tiles,
+                                        uint32_t tile,
+                                        float radius,
+                                        TVisitor&& visit) {
+    const auto nperdim = tiles->nperdim;
+    int32_t bin[Ndim];
+    int32_t first[Ndim];
+    int32_t width[Ndim];
+    int32_t n_tiles{1};
+    uint32_t remainder{tile};
+    for (int32_t dim{Ndim - 1}; dim >= 0; --dim) {
+      bin[dim] = remainder % nperdim;
+      remainder /= nperdim;
+    }
+    for (int32_t dim{}; dim != Ndim; ++dim) {
+      const float size{tiles->tilesizes[dim]};
+      const int32_t reach{
+          size > 0.f ? static_cast<int32_t>(alpaka::math::ceil(acc, radius / size))
+                     : nperdim};
+      first[dim] = alpaka::math::max(acc, bin[dim] - reach, 0);
+      const auto last = alpaka::math::min(acc, bin[dim] + reach, nperdim - 1);
+      width[dim] = last - first[dim] + 1;
+      n_tiles *= width[dim];
+    }
+
+    for (int32_t k{}; k != n_tiles; ++k) {
+      int32_t rest{k};
+      uint32_t global_bin{};
+      uint32_t stride{1};
+      float gap_sq{0.f};
+      for (int32_t dim{Ndim - 1}; dim >= 0; --dim) {
+        const auto other = first[dim] + rest % width[dim];
+        rest /= width[dim];
+        global_bin += other * stride;
+        stride *= nperdim;
+        // distance between the boxes of the two tiles along this coordinate
+        const auto bins_between =
+            (other > bin[dim] ? other - bin[dim] : bin[dim] - other) - 1;
+        if (bins_between > 0) {
+          const float gap{bins_between * tiles->tilesizes[dim]};
+          gap_sq += gap * gap;
+        }
+      }
+      if (gap_sq <= radius * radius) {
+        visit(global_bin);
+      }
+    }
+  }
+
+  template <uint8_t Ndim>
+  struct KernelCountTileInteractions {
+    template <typename TAcc>
+    ALPAKA_FN_ACC void operator()(const TAcc& acc,
+                                  const TilesAlpakaView<Ndim>* tiles,
+                                  uint32_t* counts,
+                                  float radius) const {
+      const auto n_tiles = static_cast<uint32_t>(tiles->ntiles);
+      for (auto t : alpaka::uniformElements(acc, n_tiles)) {
+        uint32_t count{};
+        forEachTileInRange(acc, tiles, t, radius, [&](uint32_t) { ++count; });
+        counts[t] = count;
+      }
+    }
+  };
+
+  // Writes the lists of neighbours of the tiles, where positions is the inclusive scan
+  // of their sizes
+  template <uint8_t Ndim>
+  struct KernelFillTileInteractions {
+    template <typename TAcc>
+    ALPAKA_FN_ACC void operator()(const TAcc& acc,
+                                  const TilesAlpakaView<Ndim>* tiles,
+                                  const uint32_t* counts,
+                                  const uint32_t* positions,
+                                  uint32_t* offsets,
+                                  uint32_t* interactions,
+                                  float radius) const {
+      const auto n_tiles = static_cast<uint32_t>(tiles->ntiles);
+      for (auto t : alpaka::uniformElements(acc, n_tiles)) {
+        auto position = positions[t] - counts[t];
+        offsets[t] = position;
+        if (t == n_tiles - 1) {
+          offsets[n_tiles] = positions[t];
+        }
+        forEachTileInRange(acc, tiles, t, radius, [&](uint32_t other) {
+          interactions[position++] = other;
+        });
+      }
+    }
+  };
+
+  // Loads the coordinates of the points from first to first + n_block of the tile
+  template <uint8_t Ndim>
+  ALPAKA_FN_ACC inline void loadBlock(TilesAlpakaView<Ndim>* tiles,
+                                      PointsAlpakaView* dev_points,
+                                      uint32_t tile,
+                                      uint32_t first,
+                                      uint32_t n_block,
+                                      uint32_t (&indexes)[tile_block],
+                                      float (&coords)[tile_block][Ndim]) {
+    auto points = (*tiles)[tile];
+    for (uint32_t k{}; k != n_block; ++k) {
+      indexes[k] = points[first + k];
+      getCoords<Ndim>(coords[k], dev_points, indexes[k]);
+    }
+  }
+
+  template <uint8_t Ndim>
+  ALPAKA_FN_ACC inline float distanceSq(const float (&coords_i)[Ndim],
+                                        const float (&coords_j)[Ndim]) {
+    float dist_ij_sq{0.f};
+    for (int32_t dim{}; dim != Ndim; ++dim) {
+      dist_ij_sq += (coords_j[dim] - coords_i[dim]) * (coords_j[dim] - coords_i[dim]);
+    }
+    return dist_ij_sq;
+  }
+
+  // Only the points with index below n_points are targets, the others, like the ghosts
+  // of the periodic boundaries, are only sources
+  struct KernelCalculateLocalDensityTilePairs {
+    template <typename TAcc, uint8_t Ndim, typename KernelType, typename TAccumulator>
+    ALPAKA_FN_ACC void operator()(const TAcc& acc,
+                                  TilesAlpakaView<Ndim>* dev_tiles,
+                                  PointsAlpakaView* dev_points,
+                                  TileInteractions interactions,
+                                  const KernelType& kernel,
+                                  float dc,
+                                  uint32_t n_points,
+                                  TAccumulator accumulator) const {
+      const auto n_tiles = static_cast<uint32_t>(dev_tiles->ntiles);
+      for (auto t : alpaka::uniformElements(acc, n_tiles)) {
+        const auto n_targets = static_cast<uint32_t>((*dev_tiles)[t].size());
+        for (uint32_t first_target{}; first_target < n_targets;
+             first_target += tile_block) {
+          const uint32_t n_block{
+              alpaka::math::min(acc, tile_block, n_targets - first_target)};
+          uint32_t target_indexes[tile_block];
+          float target_coords[tile_block][Ndim];
+          loadBlock(dev_tiles,
+                    dev_points,
+                    t,
+                    first_target,
+                    n_block,
+                    target_indexes,
+                    target_coords);
+          TAccumulator rho[tile_block];
+          for (uint32_t k{}; k != n_block; ++k) {
+            rho[k] = accumulator;
+            rho[k].add(kernel.selfContribution() * dev_points->weight[target_indexes[k]]);
+          }
+
+          for (auto s{interactions.offsets[t]}; s != interactions.offsets[t + 1]; ++s) {
+            const auto source_tile = interactions.tiles[s];
+            const auto n_sources =
+                static_cast<uint32_t>((*dev_tiles)[source_tile].size());
+            for (uint32_t first_source{}; first_source < n_sources;
+                 first_source += tile_block) {
+              const uint32_t n_source_block{
+                  alpaka::math::min(acc, tile_block, n_sources - first_source)};
+              uint32_t source_indexes[tile_block];
+              float source_coords[tile_block][Ndim];
+              loadBlock(dev_tiles,
+                        dev_points,
+                        source_tile,
+                        first_source,
+                        n_source_block,
+                        source_indexes,
+                        source_coords);
+
+              for (uint32_t k{}; k != n_block; ++k) {
+                float dist_sq[kernel_lanes]{};
+                float weights[kernel_lanes]{};
+                std::size_t n_lanes{};
+                for (uint32_t l{}; l != n_source_block; ++l) {
+                  const float dist_ij_sq{
+                      distanceSq<Ndim>(target_coords[k], source_coords[l])};
+                  if (source_indexes[l] != target_indexes[k] and dist_ij_sq <= dc * dc) {
+                    dist_sq[n_lanes] = dist_ij_sq;
+                    weights[n_lanes] = dev_points->weight[source_indexes[l]];
+                    if (++n_lanes == kernel_lanes) {
+                      accumulateLanes(acc, kernel, dist_sq, weights, n_lanes, &rho[k]);
+                      n_lanes = 0;
+                    }
+                  }
+                }
+                if (n_lanes > 0) {
+                  accumulateLanes(acc, kernel, dist_sq, weights, n_lanes, &rho[k]);
+                }
+              }
+            }
+          }
+
+          for (uint32_t k{}; k != n_block; ++k) {
+            if (target_indexes[k] < n_points) {
+              dev_points->rho[target_indexes[k]] = rho[k].result();
+            }
+          }
+        }
+      }
+    }
+  };
+
+  // Finds the nearest higher of the points and classifies them, like
+  // KernelCalculateNearestHigherAndClassify
+  struct KernelCalculateNearestHigherTilePairs {
+    template <typename TAcc, uint8_t Ndim>
+    ALPAKA_FN_ACC void operator()(const TAcc& acc,
+                                  TilesAlpakaView<Ndim>* dev_tiles,
+                                  PointsAlpakaView* dev_points,
+                                  TileInteractions interactions,
+                                  VecArray<int32_t, reserve>* seeds,
+                                  VecArray<int32_t, max_followers>* followers,
+                                  float dm,
+                                  float d_c,
+                                  float rho_c,
+                                  uint32_t n_points) const {
+      const auto n_tiles = static_cast<uint32_t>(dev_tiles->ntiles);
+      for (auto t : alpaka::uniformElements(acc, n_tiles)) {
+        const auto n_targets = static_cast<uint32_t>((*dev_tiles)[t].size());
+        for (uint32_t first_target{}; first_target < n_targets;
+             first_target += tile_block) {
+          const uint32_t n_block{
+              alpaka::math::min(acc, tile_block, n_targets - first_target)};
+          uint32_t target_indexes[tile_block];
+          float target_coords[tile_block][Ndim];
+          loadBlock(dev_tiles,
+                    dev_points,
+                    t,
+                    first_target,
+                    n_block,
+                    target_indexes,
+                    target_coords);
+          float rho[tile_block];
+          float delta[tile_block];
+          int nh[tile_block];
+          for (uint32_t k{}; k != n_block; ++k) {
+            rho[k] = dev_points->rho[target_indexes[k]];
+            delta[k] = std::numeric_limits<float>::max();
+            nh[k] = -1;
+          }
+
+          for (auto s{interactions.offsets[t]}; s != interactions.offsets[t + 1]; ++s) {
+            const auto source_tile = interactions.tiles[s];
+            const auto n_sources =
+                static_cast<uint32_t>((*dev_tiles)[source_tile].size());
+            for (uint32_t first_source{}; first_source < n_sources;
+                 first_source += tile_block) {
+              const uint32_t n_source_block{
+                  alpaka::math::min(acc, tile_block, n_sources - first_source)};
+              uint32_t source_indexes[tile_block];
+              float source_coords[tile_block][Ndim];
+              loadBlock(dev_tiles,
+                        dev_points,
+                        source_tile,
+                        first_source,
+                        n_source_block,
+                        source_indexes,
+                        source_coords);
+              float source_rho[tile_block];
+              for (uint32_t l{}; l != n_source_block; ++l) {
+                source_rho[l] = dev_points->rho[source_indexes[l]];
+                // the ghosts of the periodic boundaries take the index of their original
+                source_indexes[l] = originalIndex(dev_points, source_indexes[l]);
+              }
+
+              for (uint32_t k{}; k != n_block; ++k) {
+                for (uint32_t l{}; l != n_source_block; ++l) {
+                  const auto j = static_cast<int>(source_indexes[l]);
+                  // in the rare case where rho is the same, use detid
+                  const bool found_higher{
+                      source_rho[l] > rho[k] ||
+                      (source_rho[l] == rho[k] && source_rho[l] > 0.f &&
+                       source_indexes[l] > target_indexes[k])};
+                  if (!found_higher) {
+                    continue;
+                  }
+                  const float dist_ij_sq{
+                      distanceSq<Ndim>(target_coords[k], source_coords[l])};
+                  // the ties are broken with the smallest index
+                  if (dist_ij_sq <= dm * dm &&
+                      (dist_ij_sq < delta[k] || (dist_ij_sq == delta[k] && j < nh[k]))) {
+                    delta[k] = dist_ij_sq;
+                    nh[k] = j;
+                  }
+                }
+              }
+            }
+          }
+
+          for (uint32_t k{}; k != n_block; ++k) {
+            const auto i = target_indexes[k];
+            if (i >= n_points) {
+              continue;
+            }
+            const float delta_i{alpaka::math::sqrt(acc, delta[k])};
+#ifdef CLUE_DEBUG
+            dev_points->delta[i] = delta_i;
+            dev_points->nearest_higher[i] = nh[k];
+#endif
+            classify_point(
+                acc, seeds, followers, dev_points, delta_i, nh[k], dm, d_c, rho_c, i);
+          }
+        }
+      }
+    }
+  };
+
+}  // namespace ALPAKA_ACCELERATOR_NAMESPACE_CLUE
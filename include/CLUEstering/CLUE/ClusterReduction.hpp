@@ -0,0 +1,140 @@
+#pragma once
+
+#include <alpaka/core/Common.hpp>
+#include <alpaka/alpaka.hpp>
+#include <cstdint>
+
+// A cluster reduction computes a summary of each cluster on the device, folding its
+// points into a value of type value_type. The value starts from identity, and
+// accumulate adds to it a point, given its coordinates, its weight and its index, so
+// that a reduction can also read its own arrays indexed by the points. The points of
+// a cluster are split in groups that are accumulated in parallel, so combine must
+// merge into a value the one accumulated over another group of points of the same
+// cluster. A reduction can also provide finalize, which is applied to the value once
+// all the points of the cluster have been accumulated and combined.
+// The points of a cluster are accumulated and combined in an unspecified order, so
+// the results of the floating point additions can change between runs and backends
+// in the last bits.
+
+namespace clue {
+
+  template <typename TReduction, typename TAcc>
+  concept FinalizedReduction = requires(const TReduction& reduction,
+                                        const TAcc& acc,
+                                        typename TReduction::value_type& value) {
+    reduction.finalize(acc, value);
+  };
+
+  template <typename TAcc, typename TReduction>
+  ALPAKA_FN_HOST_ACC inline void finalizeReduction(
+      const TAcc& acc,
+      const TReduction& reduction,
+      typename TReduction::value_type& value) {
+    if constexpr (FinalizedReduction<TReduction, TAcc>) {
+      reduction.finalize(acc, value);
+    }
+  }
+
+}  // namespace clue
+
+// Sum of the weights of the points
+class WeightSum {
+public:
+  using value_type = float;
+
+  ALPAKA_FN_HOST_ACC value_type identity() const { return 0.f; }
+
+  template <typename TAcc>
+  ALPAKA_FN_HOST_ACC void accumulate(const TAcc&,
+                                     value_type& value,
+                                     const float* /*coords*/,
+                                     float weight,
+                                     uint32_t /*i*/) const {
+    value += weight;
+  }
+
+  template <typename TAcc>
+  ALPAKA_FN_HOST_ACC void combine(const TAcc&,
+                                  value_type& value,
+                                  const value_type& other) const {
+    value += other;
+  }
+};
+
+// Weighted average of the coordinates of the points
+template <uint8_t Ndim>
+class Centroid {
+public:
+  struct value_type {
+    float coords[Ndim];
+    float weight;
+  };
+
+  ALPAKA_FN_HOST_ACC value_type identity() const { return value_type{}; }
+
+  template <typename TAcc>
+  ALPAKA_FN_HOST_ACC void accumulate(const TAcc&,
+                                     value_type& value,
+                                     const float* coords,
+                                     float weight,
+                                     uint32_t /*i*/) const {
+    for (int32_t dim{}; dim != Ndim; ++dim) {
+      value.coords[dim] += weight * coords[dim];
+    }
+    value.weight += weight;
+  }
+
+  template <typename TAcc>
+  ALPAKA_FN_HOST_ACC void combine(const TAcc&,
+                                  value_type& value,
+                                  const value_type& other) const {
+    for (int32_t dim{}; dim != Ndim; ++dim) {
+      value.coords[dim] += other.coords[dim];
+    }
+    value.weight += other.weight;
+  }
+
+  template <typename TAcc>
+  ALPAKA_FN_HOST_ACC void finalize(const TAcc&, value_type& value) const {
+    if (value.weight != 0.f) {
+      for (int32_t dim{}; dim != Ndim; ++dim) {
+        value.coords[dim] /= value.weight;
+      }
+    }
+  }
+};
+
+// Index and weight of the point with the largest weight, with the ties broken by the
+// smallest index
+class MaxWeightPoint {
+public:
+  struct value_type {
+    float weight;
+    int32_t index;
+  };
+
+  ALPAKA_FN_HOST_ACC value_type identity() const { return value_type{0.f, -1}; }
+
+  template <typename TAcc>
+  ALPAKA_FN_HOST_ACC void accumulate(const TAcc&,
+                                     value_type& value,
+                                     const float* /*coords*/,
+                                     float weight,
+                                     uint32_t i) const {
+    const auto index = static_cast<int32_t>(i);
+    if (value.index < 0 or weight > value.weight or
+        (weight == value.weight and index < value.index)) {
+      value.weight = weight;
+      value.index = index;
+    }
+  }
+
+  template <typename TAcc>
+  ALPAKA_FN_HOST_ACC void combine(const TAcc& acc,
+                                  value_type& value,
+                                  const value_type& other) const {
+    if (other.index >= 0) {
+      accumulate(acc, value, nullptr, other.weight, static_cast<uint32_t>(other.index));
+    }
+  }
+};
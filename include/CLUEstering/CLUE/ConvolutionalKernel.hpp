@@ -1,28 +1,84 @@
-
 #pragma once
 
 #include <alpaka/core/Common.hpp>
 #include <alpaka/alpaka.hpp>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+#include "../utility/hash.hpp"
+
+// A convolutional kernel gives the contribution of a neighbour to the density of a
+// point as a function of their squared distance, so that the kernels which don't need
+// the distance itself avoid the square root. The contribution of the point to its own
+// density is given separately by selfContribution, and is added once outside of the
+// search over the neighbours.
+// A kernel can also provide a batch overload, which evaluates the contributions of a
+// whole vector of lanes at once. If it doesn't, the batch is evaluated calling the
+// scalar overload for each lane.
+// The kernels provide hash, which hashes their parameters for the result cache and the
+// checkpoints. The kernels without it can't be used with either of them.
+
+namespace clue {
+
+  template <typename KernelType, typename TAcc, std::size_t lanes>
+  concept BatchKernel = requires(const KernelType& kernel,
+                                 const TAcc& acc,
+                                 const float (&dist_sq)[lanes],
+                                 float (&values)[lanes]) {
+    kernel(acc, dist_sq, values);
+  };
+
+  template <typename KernelType>
+  concept HashedKernel = requires(const KernelType& kernel) {
+    { kernel.hash() } -> std::convertible_to<uint64_t>;
+  };
+
+  template <typename TAcc, typename KernelType, std::size_t lanes>
+  ALPAKA_FN_HOST_ACC inline void evaluateKernel(const TAcc& acc,
+                                                const KernelType& kernel,
+                                                const float (&dist_sq)[lanes],
+                                                float (&values)[lanes]) {
+    if constexpr (BatchKernel<KernelType, TAcc, lanes>) {
+      kernel(acc, dist_sq, values);
+    } else {
+      for (std::size_t lane{}; lane != lanes; ++lane) {
+        values[lane] = kernel(acc, dist_sq[lane]);
+      }
+    }
+  }
+
+}  // namespace clue
 
 class FlatKernel {
 private:
   float m_flat;
 
+  friend class RuntimeKernel;
+
 public:
   // Constructors
   FlatKernel() = delete;
-  FlatKernel(float flat) : m_flat{flat} {}
+  ALPAKA_FN_HOST_ACC FlatKernel(float flat) : m_flat{flat} {}
+
+  ALPAKA_FN_HOST_ACC float selfContribution() const { return 1.f; }
+
+  uint64_t hash() const { return clue::hash_bytes(&m_flat, sizeof(m_flat)); }
 
   // Overload call operator
   template <typename TAcc>
-  ALPAKA_FN_HOST_ACC float operator()(const TAcc&,
-                                      float /*dist_ij*/,
-                                      int point_id,
-                                      int j) const {
-    if (point_id == j) {
-      return 1.f;
-    } else {
-      return m_flat;
+  ALPAKA_FN_HOST_ACC float operator()(const TAcc&, float /*dist_ij_sq*/) const {
+    return m_flat;
+  }
+
+  template <typename TAcc, std::size_t lanes>
+  ALPAKA_FN_HOST_ACC void operator()(const TAcc&,
+                                     const float (&)[lanes],
+                                     float (&values)[lanes]) const {
+    for (std::size_t lane{}; lane != lanes; ++lane) {
+      values[lane] = m_flat;
     }
   }
 };
@@ -32,26 +88,54 @@ private:
   float m_gaus_avg;
   float m_gaus_std;
   float m_gaus_amplitude;
+  // factor of the exponent, shared by the scalar and the batch overloads so that
+  // they round in the same way
+  float m_scale;
+
+  friend class RuntimeKernel;
 
 public:
   // Constructors
   GaussianKernel() = delete;
-  GaussianKernel(float gaus_avg, float gaus_std, float gaus_amplitude)
-      : m_gaus_avg{gaus_avg}, m_gaus_std{gaus_std}, m_gaus_amplitude{gaus_amplitude} {}
+  ALPAKA_FN_HOST_ACC GaussianKernel(float gaus_avg, float gaus_std, float gaus_amplitude)
+      : m_gaus_avg{gaus_avg},
+        m_gaus_std{gaus_std},
+        m_gaus_amplitude{gaus_amplitude},
+        m_scale{-1.f / (2 * gaus_std * gaus_std)} {}
+
+  ALPAKA_FN_HOST_ACC float selfContribution() const { return 1.f; }
+
+  uint64_t hash() const {
+    const float parameters[] = {m_gaus_avg, m_gaus_std, m_gaus_amplitude};
+    return clue::hash_bytes(parameters, sizeof(parameters));
+  }
 
   // Overload call operator
   template <typename TAcc>
-  ALPAKA_FN_HOST_ACC float operator()(const TAcc& acc,
-                                      float dist_ij,
-                                      int point_id,
-                                      int j) const {
-    if (point_id == j) {
-      return 1.f;
+  ALPAKA_FN_HOST_ACC float operator()(const TAcc& acc, float dist_ij_sq) const {
+    // the square root is only needed if the gaussian is not centered in zero
+    const float exponent =
+        (m_gaus_avg == 0.f)
+            ? dist_ij_sq
+            : (alpaka::math::sqrt(acc, dist_ij_sq) - m_gaus_avg) *
+                  (alpaka::math::sqrt(acc, dist_ij_sq) - m_gaus_avg);
+    return (m_gaus_amplitude * alpaka::math::exp(acc, m_scale * exponent));
+  }
+
+  template <typename TAcc, std::size_t lanes>
+  ALPAKA_FN_HOST_ACC void operator()(const TAcc& acc,
+                                     const float (&dist_sq)[lanes],
+                                     float (&values)[lanes]) const {
+    if (m_gaus_avg == 0.f) {
+      for (std::size_t lane{}; lane != lanes; ++lane) {
+        values[lane] =
+            m_gaus_amplitude * alpaka::math::exp(acc, m_scale * dist_sq[lane]);
+      }
     } else {
-      return (m_gaus_amplitude *
-              alpaka::math::exp(acc,
-                                -(dist_ij - m_gaus_avg) * (dist_ij - m_gaus_avg) /
-                                    (2 * m_gaus_std * m_gaus_std)));
+      for (std::size_t lane{}; lane != lanes; ++lane) {
+        const float diff{alpaka::math::sqrt(acc, dist_sq[lane]) - m_gaus_avg};
+        values[lane] = m_gaus_amplitude * alpaka::math::exp(acc, m_scale * (diff * diff));
+      }
     }
   }
 };
@@ -61,22 +145,142 @@ private:
   float m_exp_avg;
   float m_exp_amplitude;
 
+  friend class RuntimeKernel;
+
 public:
   // Constructors
   ExponentialKernel() = delete;
-  ExponentialKernel(float exp_avg, float exp_amplitude)
+  ALPAKA_FN_HOST_ACC ExponentialKernel(float exp_avg, float exp_amplitude)
       : m_exp_avg{exp_avg}, m_exp_amplitude{exp_amplitude} {}
 
+  ALPAKA_FN_HOST_ACC float selfContribution() const { return 1.f; }
+
+  uint64_t hash() const {
+    const float parameters[] = {m_exp_avg, m_exp_amplitude};
+    return clue::hash_bytes(parameters, sizeof(parameters));
+  }
+
   // Overload call operator
   template <typename TAcc>
-  ALPAKA_FN_HOST_ACC float operator()(const TAcc& acc,
-                                      float dist_ij,
-                                      int point_id,
-                                      int j) const {
-    if (point_id == j) {
-      return 1.f;
-    } else {
-      return (m_exp_amplitude * alpaka::math::exp(acc, -m_exp_avg * dist_ij));
+  ALPAKA_FN_HOST_ACC float operator()(const TAcc& acc, float dist_ij_sq) const {
+    return (m_exp_amplitude *
+            alpaka::math::exp(acc, -m_exp_avg * alpaka::math::sqrt(acc, dist_ij_sq)));
+  }
+};
+
+// Kernel chosen at runtime, as the sum of up to max_terms of the kernels above, so that
+// a single instantiation of the algorithm serves all of them, including their
+// combinations. Each term is written when the kernel is built as
+//   amplitude * exp(scale * x),
+// where x is the squared distance, the distance minus a shift, or its square, so
+// that the terms are evaluated without switching on their kind. The factors are
+// computed as in the kernels above, and a kernel of a single term gives their same
+// values.
+class RuntimeKernel {
+public:
+  static constexpr int32_t max_terms{4};
+
+  // Constructors
+  RuntimeKernel() = delete;
+  RuntimeKernel(const FlatKernel& kernel)
+      : m_terms{Term{Argument::squared_distance, kernel.m_flat, 0.f, 0.f}},
+        m_nterms{1} {}
+  RuntimeKernel(const ExponentialKernel& kernel)
+      : m_terms{Term{
+            Argument::distance, kernel.m_exp_amplitude, -kernel.m_exp_avg, 0.f}},
+        m_nterms{1},
+        m_needs_distance{true} {}
+  RuntimeKernel(const GaussianKernel& kernel)
+      : m_terms{Term{kernel.m_gaus_avg == 0.f ? Argument::squared_distance
+                                              : Argument::squared_difference,
+                     kernel.m_gaus_amplitude,
+                     kernel.m_scale,
+                     kernel.m_gaus_avg}},
+        m_nterms{1},
+        m_needs_distance{kernel.m_gaus_avg != 0.f} {}
+
+  // Adds the terms of other to the ones of this kernel
+  RuntimeKernel& operator+=(const RuntimeKernel& other) {
+    if (m_nterms + other.m_nterms > max_terms) {
+      throw std::length_error("A runtime kernel can have at most " +
+                              std::to_string(max_terms) + " terms");
+    }
+    for (int32_t term{}; term != other.m_nterms; ++term) {
+      m_terms[m_nterms++] = other.m_terms[term];
+    }
+    m_needs_distance = m_needs_distance or other.m_needs_distance;
+    return *this;
+  }
+  friend RuntimeKernel operator+(RuntimeKernel lhs, const RuntimeKernel& rhs) {
+    lhs += rhs;
+    return lhs;
+  }
+
+  int32_t nTerms() const { return m_nterms; }
+
+  // the fields of the terms are hashed one by one, since the terms contain padding
+  uint64_t hash() const {
+    auto key = static_cast<uint64_t>(m_nterms);
+    for (int32_t term{}; term != m_nterms; ++term) {
+      const auto& t = m_terms[term];
+      const float factors[] = {t.amplitude, t.scale, t.shift};
+      key = clue::hash_combine(key, static_cast<uint64_t>(t.argument));
+      key = clue::hash_combine(key, clue::hash_bytes(factors, sizeof(factors)));
+    }
+    return key;
+  }
+
+  // the point itself is counted once, however many terms the kernel has
+  ALPAKA_FN_HOST_ACC float selfContribution() const { return 1.f; }
+
+  // Overload call operator
+  template <typename TAcc>
+  ALPAKA_FN_HOST_ACC float operator()(const TAcc& acc, float dist_ij_sq) const {
+    const float dist_sq[1]{dist_ij_sq};
+    float values[1];
+    (*this)(acc, dist_sq, values);
+    return values[0];
+  }
+
+  template <typename TAcc, std::size_t lanes>
+  ALPAKA_FN_HOST_ACC void operator()(const TAcc& acc,
+                                     const float (&dist_sq)[lanes],
+                                     float (&values)[lanes]) const {
+    float dist[lanes]{};
+    if (m_needs_distance) {
+      for (std::size_t lane{}; lane != lanes; ++lane) {
+        dist[lane] = alpaka::math::sqrt(acc, dist_sq[lane]);
+      }
+    }
+    for (std::size_t lane{}; lane != lanes; ++lane) {
+      values[lane] = m_terms[0].evaluate(acc, dist_sq[lane], dist[lane]);
+    }
+    for (int32_t term{1}; term < m_nterms; ++term) {
+      for (std::size_t lane{}; lane != lanes; ++lane) {
+        values[lane] += m_terms[term].evaluate(acc, dist_sq[lane], dist[lane]);
+      }
     }
   }
+
+private:
+  enum class Argument : uint8_t { squared_distance, distance, squared_difference };
+  struct Term {
+    Argument argument;
+    float amplitude;
+    float scale;
+    float shift;
+
+    template <typename TAcc>
+    ALPAKA_FN_HOST_ACC float evaluate(const TAcc& acc, float dist_sq, float dist) const {
+      const float diff{dist - shift};
+      const float x{argument == Argument::squared_distance ? dist_sq
+                    : argument == Argument::distance       ? diff
+                                                           : diff * diff};
+      return amplitude * alpaka::math::exp(acc, scale * x);
+    }
+  };
+
+  Term m_terms[max_terms]{};
+  int32_t m_nterms;
+  bool m_needs_distance{false};
 };
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <algorithm>
+#include <alpaka/core/Common.hpp>
+#include <cstdint>
+#include <vector>
+
+#include "../DataFormats/Points.hpp"
+#include "../DataFormats/alpaka/PointsAlpaka.hpp"
+#include "../DataFormats/alpaka/TilesAlpaka.hpp"
+
+// Alternative treatment of the periodic coordinates, where the points within a given
+// width from a periodic boundary are replicated beyond the opposite boundary, with
+// their coordinates shifted by the period. The tiles are then built over the points
+// and their ghosts without wrapping, so that the searches use plain euclidean
+// distances and tile indexes, and the ghosts found by them are mapped back to the
+// points they replicate. As in the wrapped tiles, the period of a coordinate is the
+// range of its values.
+namespace ALPAKA_ACCELERATOR_NAMESPACE_CLUE {
+
+  struct HaloPoints {
+    // coordinates of the points followed by the ones of the ghosts, in SoA layout,
+    // followed by the weights
+    std::vector<float> input;
+    // index of the point replicated by each ghost
+    std::vector<uint32_t> origins;
+  };
+
+  // Replicates the points within width from the boundaries of the wrapped
+  // coordinates, including the corners where more than one coordinate is wrapped
+  template <uint8_t Ndim>
+  HaloPoints buildHalo(const PointsSoA<Ndim>& h_points,
+                       const CoordinateExtremes<Ndim>& min_max,
+                       float width) {
+    const auto n_points = h_points.nPoints();
+    const auto wrapped = h_points.wrapped();
+    const float* coords = h_points.coords();
+
+    // the ghosts are collected in AoS layout, as their number isn't known in advance
+    std::vector<float> ghosts;
+    HaloPoints halo;
+    for (uint32_t i{}; i != n_points; ++i) {
+      // the shifts of each coordinate, where the first is always zero
+      float shifts[Ndim][3];
+      int32_t n_shifts[Ndim];
+      int32_t n_copies{1};
+      for (int32_t dim{}; dim != Ndim; ++dim) {
+        const float coord{coords[i + dim * n_points]};
+        shifts[dim][0] = 0.f;
+        n_shifts[dim] = 1;
+        if (wrapped[dim]) {
+          if (coord < min_max.min(dim) + width) {
+            shifts[dim][n_shifts[dim]++] = min_max.range(dim);
+          }
+          if (coord > min_max.max(dim) - width) {
+            shifts[dim][n_shifts[dim]++] = -min_max.range(dim);
+          }
+        }
+        n_copies *= n_shifts[dim];
+      }
+
+      // each copy is a combination of the shifts, skipping the point itself
+      for (int32_t copy{1}; copy < n_copies; ++copy) {
+        int32_t remainder{copy};
+        for (int32_t dim{}; dim != Ndim; ++dim) {
+          const auto shift = shifts[dim][remainder % n_shifts[dim]];
+          remainder /= n_shifts[dim];
+          ghosts.push_back(coords[i + dim * n_points] + shift);
+        }
+        halo.origins.push_back(i);
+      }
+    }
+
+    const auto n_ghosts = static_cast<uint32_t>(halo.origins.size());
+    const auto n_stored = n_points + n_ghosts;
+    halo.input.resize((Ndim + 1) * n_stored);
+    for (int32_t dim{}; dim != Ndim; ++dim) {
+      std::copy(coords + dim * n_points,
+                coords + (dim + 1) * n_points,
+                halo.input.begin() + dim * n_stored);
+      for (uint32_t g{}; g != n_ghosts; ++g) {
+        halo.input[dim * n_stored + n_points + g] = ghosts[g * Ndim + dim];
+      }
+    }
+    const float* weights = h_points.weights();
+    std::copy(weights, weights + n_points, halo.input.begin() + Ndim * n_stored);
+    for (uint32_t g{}; g != n_ghosts; ++g) {
+      halo.input[Ndim * n_stored + n_points + g] = weights[halo.origins[g]];
+    }
+    return halo;
+  }
+
+  // Copies the density of the points to their ghosts, which are read by the search
+  // of the nearest higher
+  struct KernelCopyGhostDensity {
+    template <typename TAcc>
+    ALPAKA_FN_ACC void operator()(const TAcc& acc,
+                                  PointsAlpakaView* dev_points,
+                                  uint32_t n_ghosts) const {
+      const auto n_real = static_cast<uint32_t>(dev_points->n_real);
+      for (auto g : alpaka::uniformElements(acc, n_ghosts)) {
+        dev_points->rho[n_real + g] = dev_points->rho[dev_points->ghost_origin[g]];
+      }
+    }
+  };
+
+}  // namespace ALPAKA_ACCELERATOR_NAMESPACE_CLUE
@@ -0,0 +1,201 @@
+#pragma once
+
+#include <alpaka/core/Common.hpp>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "../AlpakaCore/alpakaWorkDiv.hpp"
+#include "../DataFormats/alpaka/AssociationMap.hpp"
+#include "../DataFormats/alpaka/PointsAlpaka.hpp"
+#include "CLUEAlpakaKernelsDynamic.hpp"
+
+// Approximate neighbour search based on locality-sensitive hashing, for points with
+// many dimensions where the tiles can't prune the candidates effectively.
+// Each of the n_tables hash tables assigns a point to the bucket obtained combining
+// n_hashes p-stable hashes floor((a * x + b) / bucket_width), where the components of
+// a are gaussian and b is uniform in [0, bucket_width). The neighbours of a point are
+// searched only among the points sharing a bucket with it in at least one table, so
+// points within the search radius can be missed. The recall increases with the number
+// of tables and the width of the buckets, and decreases with the number of hashes,
+// which instead reduces the number of candidates that are checked.
+namespace clue {
+
+  struct LSHParameters {
+    int32_t n_tables{8};
+    int32_t n_hashes{4};
+    // if not positive, four times the largest of dc and dm is used
+    float bucket_width{0.f};
+    uint32_t seed{0};
+  };
+
+  // Returns the gaussian projections of all the hashes, stored by row, followed by
+  // their uniform offsets
+  inline std::vector<float> generateLSHFunctions(const LSHParameters& params,
+                                                 int32_t ndim,
+                                                 float bucket_width) {
+    std::mt19937 generator(params.seed);
+    std::normal_distribution<float> gaus(0.f, 1.f);
+    std::uniform_real_distribution<float> uniform(0.f, bucket_width);
+
+    const auto n_functions = params.n_tables * params.n_hashes;
+    std::vector<float> functions(n_functions * (ndim + 1));
+    for (int32_t k{}; k != n_functions * ndim; ++k) {
+      functions[k] = gaus(generator);
+    }
+    for (int32_t k{}; k != n_functions; ++k) {
+      functions[n_functions * ndim + k] = uniform(generator);
+    }
+    return functions;
+  }
+
+}  // namespace clue
+
+namespace ALPAKA_ACCELERATOR_NAMESPACE_CLUE {
+
+  // Computes the bucket of each point in each table. The buckets are numbered globally,
+  // so that the bucket of the point i in the table t, stored at index i + t * n_points,
+  // is between t * n_buckets and (t + 1) * n_buckets.
+  struct KernelComputeLSHBuckets {
+    template <typename TAcc>
+    ALPAKA_FN_ACC void operator()(const TAcc& acc,
+                                  PointsAlpakaView* dev_points,
+                                  const float* functions,
+                                  uint32_t* buckets,
+                                  float bucket_width,
+                                  int32_t ndim,
+                                  int32_t n_tables,
+                                  int32_t n_hashes,
+                                  uint32_t n_buckets) const {
+      const auto n = static_cast<uint32_t>(dev_points->n);
+      const auto n_functions = n_tables * n_hashes;
+      const float* offsets = functions + n_functions * ndim;
+      for (auto i : alpaka::uniformElements(acc, n)) {
+        for (int32_t t{}; t != n_tables; ++t) {
+          uint32_t hash{};
+          for (int32_t h{}; h != n_hashes; ++h) {
+            const auto k = t * n_hashes + h;
+            float projection{offsets[k]};
+            for (int32_t dim{}; dim != ndim; ++dim) {
+              projection += functions[k * ndim + dim] * dev_points->coords[i + dim * n];
+            }
+            const auto value = static_cast<int32_t>(
+                alpaka::math::floor(acc, projection / bucket_width));
+            hash ^=
+                static_cast<uint32_t>(value) + 0x9e3779b9u + (hash << 6) + (hash >> 2);
+          }
+          buckets[i + t * n] = t * n_buckets + hash % n_buckets;
+        }
+      }
+    }
+  };
+
+  // Used for filling the association map of the buckets, where the element e is the
+  // point e % n_points in the table e / n_points
+  struct GetLSHBucket {
+    const uint32_t* buckets;
+
+    template <typename TAcc>
+    ALPAKA_FN_ACC uint32_t operator()(const TAcc&, uint32_t index) const {
+      return buckets[index];
+    }
+  };
+
+  // Returns true if the point j has already been found as a candidate of the point i
+  // in one of the tables before the table t
+  ALPAKA_FN_ACC inline bool foundInPreviousTable(const uint32_t* buckets,
+                                                 uint32_t i,
+                                                 uint32_t j,
+                                                 int32_t t,
+                                                 uint32_t n_points) {
+    for (int32_t prev{}; prev != t; ++prev) {
+      if (buckets[i + prev * n_points] == buckets[j + prev * n_points]) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  struct KernelCalculateLocalDensityLSH {
+    template <typename TAcc, typename KernelType, typename TAccumulator>
+    ALPAKA_FN_ACC void operator()(const TAcc& acc,
+                                  clue::AssociationMapView* tables,
+                                  const uint32_t* buckets,
+                                  PointsAlpakaView* dev_points,
+                                  const KernelType& kernel,
+                                  float dc,
+                                  int32_t ndim,
+                                  int32_t n_tables,
+                                  uint32_t n_points,
+                                  TAccumulator accumulator) const {
+      for (auto i : alpaka::uniformElements(acc, n_points)) {
+        // each point starts from a copy of the empty accumulator
+        TAccumulator rho_i{accumulator};
+        rho_i.add(kernel.selfContribution() * dev_points->weight[i]);
+
+        for (int32_t t{}; t != n_tables; ++t) {
+          auto bucket = (*tables)[buckets[i + t * n_points]];
+          for (uint32_t k{}; k < bucket.size(); ++k) {
+            const uint32_t j{bucket[k] % n_points};
+            if (j == i or foundInPreviousTable(buckets, i, j, t, n_points)) {
+              continue;
+            }
+
+            float dist_ij_sq = distance_sq_dynamic(dev_points, i, j, ndim);
+            if (dist_ij_sq <= dc * dc) {
+              rho_i.add(kernel(acc, dist_ij_sq) * dev_points->weight[j], dist_ij_sq);
+            }
+          }
+        }
+
+        dev_points->rho[i] = rho_i.result();
+      }
+    }
+  };
+
+  struct KernelCalculateNearestHigherLSH {
+    template <typename TAcc>
+    ALPAKA_FN_ACC void operator()(const TAcc& acc,
+                                  clue::AssociationMapView* tables,
+                                  const uint32_t* buckets,
+                                  PointsAlpakaView* dev_points,
+                                  float dm,
+                                  int32_t ndim,
+                                  int32_t n_tables,
+                                  uint32_t n_points) const {
+      for (auto i : alpaka::uniformElements(acc, n_points)) {
+        float delta_i{std::numeric_limits<float>::max()};
+        int nh_i{-1};
+        float rho_i{dev_points->rho[i]};
+
+        for (int32_t t{}; t != n_tables; ++t) {
+          auto bucket = (*tables)[buckets[i + t * n_points]];
+          for (uint32_t k{}; k < bucket.size(); ++k) {
+            const uint32_t j{bucket[k] % n_points};
+            float rho_j{dev_points->rho[j]};
+            bool found_higher{(rho_j > rho_i)};
+            // in the rare case where rho is the same, use detid
+            found_higher = found_higher || ((rho_j == rho_i) && (rho_j > 0.f) && (j > i));
+            if (!found_higher or foundInPreviousTable(buckets, i, j, t, n_points)) {
+              continue;
+            }
+
+            float dist_ij_sq = distance_sq_dynamic(dev_points, i, j, ndim);
+            // the ties are broken with the smallest index
+            if (dist_ij_sq <= dm * dm &&
+                (dist_ij_sq < delta_i ||
+                 (dist_ij_sq == delta_i && static_cast<int>(j) < nh_i))) {
+              delta_i = dist_ij_sq;
+              nh_i = j;
+            }
+          }
+        }
+
+        dev_points->delta[i] = alpaka::math::sqrt(acc, delta_i);
+        dev_points->nearest_higher[i] = nh_i;
+      }
+    }
+  };
+
+}  // namespace ALPAKA_ACCELERATOR_NAMESPACE_CLUE
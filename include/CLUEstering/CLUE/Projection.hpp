@@ -0,0 +1,271 @@
+#pragma once
+
+#include <algorithm>
+#include <alpaka/core/Common.hpp>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "../AlpakaCore/alpakaWorkDiv.hpp"
+#include "../DataFormats/alpaka/PointsAlpaka.hpp"
+#include "../DataFormats/alpaka/TilesAlpaka.hpp"
+
+// Projection of high-dimensional points on a small number of directions, used for
+// tiling them. The directions are orthonormal, so in exact arithmetic the projection
+// can only shrink the distances between the points, and the neighbours within a
+// radius in the full space are found within the same radius in the projected space.
+// The basis and the projected coordinates are stored in single precision though, so
+// a neighbour whose distance is within a few ulps of the radius can be missed.
+namespace clue {
+
+  enum class Projection { none, random, pca };
+
+  // The sums over the points needed for the principal components are split in at
+  // most pca_max_chunks chunks of at least pca_chunk_points points
+  inline constexpr uint32_t pca_chunk_points{1024};
+  inline constexpr uint32_t pca_max_chunks{256};
+
+  namespace detail {
+
+    // Orthogonalizes the vector v against the first k rows of the basis and
+    // normalizes it. Returns false if v is linearly dependent on them.
+    inline bool orthonormalize(std::vector<double>& v,
+                               const std::vector<float>& basis,
+                               int32_t k,
+                               int32_t ndim) {
+      for (int32_t row{}; row != k; ++row) {
+        double dot{};
+        for (int32_t dim{}; dim != ndim; ++dim) {
+          dot += v[dim] * basis[row * ndim + dim];
+        }
+        for (int32_t dim{}; dim != ndim; ++dim) {
+          v[dim] -= dot * basis[row * ndim + dim];
+        }
+      }
+
+      double norm{};
+      for (auto x : v) {
+        norm += x * x;
+      }
+      norm = std::sqrt(norm);
+      if (norm < 1e-9) {
+        return false;
+      }
+      for (auto& x : v) {
+        x /= norm;
+      }
+      return true;
+    }
+
+  }  // namespace detail
+
+  // Returns n_directions random orthonormal directions, stored by row
+  inline std::vector<float> randomProjectionBasis(int32_t ndim,
+                                                  int32_t n_directions,
+                                                  uint32_t seed = 0) {
+    std::mt19937 generator(seed);
+    std::normal_distribution<double> gaus(0., 1.);
+
+    std::vector<float> basis(n_directions * ndim);
+    std::vector<double> v(ndim);
+    for (int32_t k{}; k != n_directions; ++k) {
+      do {
+        for (auto& x : v) {
+          x = gaus(generator);
+        }
+      } while (!detail::orthonormalize(v, basis, k, ndim));
+      std::copy(v.begin(), v.end(), basis.begin() + k * ndim);
+    }
+    return basis;
+  }
+
+  // Returns the n_directions principal components of a covariance matrix, stored by
+  // row, computed with power iterations and deflation. If the data doesn't span
+  // enough directions, the remaining ones are left as random orthonormal vectors.
+  inline std::vector<float> principalComponentsBasis(
+      const std::vector<double>& covariance,
+      int32_t ndim,
+      int32_t n_directions,
+      int32_t n_iterations = 100) {
+    std::mt19937 generator(0);
+    std::normal_distribution<double> gaus(0., 1.);
+
+    std::vector<float> basis(n_directions * ndim);
+    std::vector<double> v(ndim);
+    std::vector<double> cv(ndim);
+    for (int32_t k{}; k != n_directions; ++k) {
+      do {
+        for (auto& x : v) {
+          x = gaus(generator);
+        }
+      } while (!detail::orthonormalize(v, basis, k, ndim));
+
+      for (int32_t iter{}; iter != n_iterations; ++iter) {
+        for (int32_t a{}; a != ndim; ++a) {
+          cv[a] = 0.;
+          for (int32_t b{}; b != ndim; ++b) {
+            cv[a] += covariance[a * ndim + b] * v[b];
+          }
+        }
+        // the component along the previous directions is removed at each iteration,
+        // which deflates the matrix
+        if (!detail::orthonormalize(cv, basis, k, ndim)) {
+          break;
+        }
+        std::swap(v, cv);
+      }
+      std::copy(v.begin(), v.end(), basis.begin() + k * ndim);
+    }
+    return basis;
+  }
+
+}  // namespace clue
+
+namespace ALPAKA_ACCELERATOR_NAMESPACE_CLUE {
+
+  // The sums over the points needed for the principal components are split over
+  // n_chunks chunks of consecutive points. Each work item sums one element over one
+  // chunk, and the partial sums of the chunks are then added by KernelCombineChunks,
+  // so that the work is parallel over the points and not only over the elements.
+  ALPAKA_FN_HOST_ACC inline uint32_t chunkBegin(uint32_t chunk,
+                                                uint32_t n_chunks,
+                                                uint32_t n_points) {
+    return static_cast<uint32_t>(static_cast<uint64_t>(chunk) * n_points / n_chunks);
+  }
+
+  struct KernelChunkSums {
+    template <typename TAcc>
+    ALPAKA_FN_ACC void operator()(const TAcc& acc,
+                                  PointsAlpakaView* dev_points,
+                                  double* partial_sums,
+                                  int32_t ndim,
+                                  uint32_t n_chunks) const {
+      const auto n = static_cast<uint32_t>(dev_points->n);
+      const auto n_elements = static_cast<uint32_t>(ndim);
+      for (auto index : alpaka::uniformElements(acc, n_chunks * n_elements)) {
+        const auto chunk = index / n_elements;
+        const auto dim = index % n_elements;
+        double sum{};
+        for (auto i = chunkBegin(chunk, n_chunks, n);
+             i != chunkBegin(chunk + 1, n_chunks, n);
+             ++i) {
+          sum += dev_points->coords[i + dim * n];
+        }
+        partial_sums[index] = sum;
+      }
+    }
+  };
+
+  // The elements of the upper triangle of the covariance matrix are numbered by row
+  struct KernelChunkCovariance {
+    template <typename TAcc>
+    ALPAKA_FN_ACC void operator()(const TAcc& acc,
+                                  PointsAlpakaView* dev_points,
+                                  const double* means,
+                                  double* partial_sums,
+                                  int32_t ndim,
+                                  uint32_t n_chunks) const {
+      const auto n = static_cast<uint32_t>(dev_points->n);
+      const auto n_elements = static_cast<uint32_t>(ndim * (ndim + 1) / 2);
+      for (auto index : alpaka::uniformElements(acc, n_chunks * n_elements)) {
+        const auto chunk = index / n_elements;
+        auto a = 0u;
+        auto b = index % n_elements;
+        while (b >= static_cast<uint32_t>(ndim) - a) {
+          b -= ndim - a;
+          ++a;
+        }
+        b += a;
+
+        double sum{};
+        for (auto i = chunkBegin(chunk, n_chunks, n);
+             i != chunkBegin(chunk + 1, n_chunks, n);
+             ++i) {
+          sum += (dev_points->coords[i + a * n] - means[a]) *
+                 (dev_points->coords[i + b * n] - means[b]);
+        }
+        partial_sums[index] = sum;
+      }
+    }
+  };
+
+  // Adds the partial sums of the chunks of each element, and multiplies them by norm
+  struct KernelCombineChunks {
+    template <typename TAcc>
+    ALPAKA_FN_ACC void operator()(const TAcc& acc,
+                                  const double* partial_sums,
+                                  double* sums,
+                                  double norm,
+                                  uint32_t n_elements,
+                                  uint32_t n_chunks) const {
+      for (auto element : alpaka::uniformElements(acc, n_elements)) {
+        double sum{};
+        for (uint32_t chunk{}; chunk != n_chunks; ++chunk) {
+          sum += partial_sums[chunk * n_elements + element];
+        }
+        sums[element] = sum * norm;
+      }
+    }
+  };
+
+  // Computes the extremes of the first TileDim rows of a SoA buffer of coordinates,
+  // which must be initialised to the largest and the lowest floats
+  template <uint8_t TileDim>
+  struct KernelCalculateTilingExtremes {
+    template <typename TAcc>
+    ALPAKA_FN_ACC void operator()(const TAcc& acc,
+                                  const float* tiling_coords,
+                                  CoordinateExtremes<TileDim>* min_max,
+                                  uint32_t n_points) const {
+      float thread_min[TileDim];
+      float thread_max[TileDim];
+      for (uint32_t dim{}; dim != TileDim; ++dim) {
+        thread_min[dim] = std::numeric_limits<float>::max();
+        thread_max[dim] = std::numeric_limits<float>::lowest();
+      }
+      bool found{false};
+      for (auto i : alpaka::uniformElements(acc, n_points)) {
+        found = true;
+        for (uint32_t dim{}; dim != TileDim; ++dim) {
+          const auto coord = tiling_coords[i + dim * n_points];
+          thread_min[dim] = alpaka::math::min(acc, thread_min[dim], coord);
+          thread_max[dim] = alpaka::math::max(acc, thread_max[dim], coord);
+        }
+      }
+      // only one atomic per dimension for each thread that processed some points
+      if (found) {
+        for (uint32_t dim{}; dim != TileDim; ++dim) {
+          alpaka::atomicMin(acc, &min_max->min(dim), thread_min[dim]);
+          alpaka::atomicMax(acc, &min_max->max(dim), thread_max[dim]);
+        }
+      }
+    }
+  };
+
+  // Writes the projected coordinates in SoA layout, with the k-th projected
+  // coordinate of the point i at index i + k * n
+  struct KernelProjectPoints {
+    template <typename TAcc>
+    ALPAKA_FN_ACC void operator()(const TAcc& acc,
+                                  PointsAlpakaView* dev_points,
+                                  const float* basis,
+                                  float* projected_coords,
+                                  int32_t ndim,
+                                  int32_t n_directions) const {
+      const auto n = static_cast<uint32_t>(dev_points->n);
+      for (auto i : alpaka::uniformElements(acc, n)) {
+        for (int32_t k{}; k != n_directions; ++k) {
+          float coord{0.f};
+          for (int32_t dim{}; dim != ndim; ++dim) {
+            coord += basis[k * ndim + dim] * dev_points->coords[i + dim * n];
+          }
+          projected_coords[i + k * n] = coord;
+        }
+      }
+    }
+  };
+
+}  // namespace ALPAKA_ACCELERATOR_NAMESPACE_CLUE
@@ -6,15 +6,36 @@
 #include <alpaka/vec/Vec.hpp>
 #include <cmath>
 #include <cstdint>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <string>
 #include <utility>
 #include <vector>
 
+#include "AlpakaCore/bitonicSort.hpp"
+#include "AlpakaCore/prefixScan.hpp"
 #include "DataFormats/Points.hpp"
 #include "DataFormats/alpaka/PointsAlpaka.hpp"
 #include "DataFormats/alpaka/TilesAlpaka.hpp"
 #include "CLUE/CLUEAlpakaKernels.hpp"
+#include "CLUE/CLUEAlpakaKernelsAdjacency.hpp"
+#include "CLUE/CLUEAlpakaKernelsFused.hpp"
+#include "CLUE/CLUEAlpakaKernelsMultiScale.hpp"
+#include "CLUE/CLUEAlpakaKernelsReduction.hpp"
+#include "CLUE/CLUEAlpakaKernelsSubset.hpp"
+#include "CLUE/CLUEAlpakaKernelsTilePairs.hpp"
 #include "CLUE/ConvolutionalKernel.hpp"
+#include "CLUE/Halo.hpp"
+#include "utility/checkpoint.hpp"
+#include "utility/cluster_graph.hpp"
+#include "utility/hash.hpp"
+#include "utility/hierarchy.hpp"
+#include "utility/result_cache.hpp"
+#include "utility/tmp_path.hpp"
 #include "utility/validation.hpp"
 
 using clue::VecArray;
@@ -24,10 +45,8 @@ namespace ALPAKA_ACCELERATOR_NAMESPACE_CLUE {
   template <uint8_t Ndim>
   class CLUEAlgoAlpaka {
   public:
-    explicit CLUEAlgoAlpaka(float dc, float rhoc, float dm, int pPBin, Queue queue)
-        : dc_{dc}, rhoc_{rhoc}, dm_{dm}, pointsPerTile_{pPBin} {
-      init_device(queue);
-    }
+    explicit CLUEAlgoAlpaka(float dc, float rhoc, float dm, int pPBin, Queue)
+        : dc_{dc}, rhoc_{rhoc}, dm_{dm}, pointsPerTile_{pPBin} {}
     explicit CLUEAlgoAlpaka(float dc,
                             float rhoc,
                             float dm,
@@ -39,8 +58,10 @@ namespace ALPAKA_ACCELERATOR_NAMESPACE_CLUE {
     }
 
     TilesAlpakaView<Ndim>* m_tiles;
-    VecArray<int32_t, reserve>* m_seeds;
-    VecArray<int32_t, max_followers>* m_followers;
+    // the seeds and the followers are allocated by the first run that classifies the
+    // points
+    VecArray<int32_t, reserve>* m_seeds{nullptr};
+    VecArray<int32_t, max_followers>* m_followers{nullptr};
 
     template <typename KernelType>
     void make_clusters(PointsSoA<Ndim>& h_points,
@@ -53,15 +74,194 @@ namespace ALPAKA_ACCELERATOR_NAMESPACE_CLUE {
                        const KernelType& kernel,
                        Queue queue_,
                        std::size_t block_size);
+    // Same as above, but the state of the algorithm is written to a checkpoint file
+    // after each stage. If the file already contains a checkpoint for the same points
+    // and parameters, identified by their hash, the run resumes after the last
+    // completed stage. Otherwise the checkpoint is ignored and overwritten.
+    template <typename KernelType>
+    void make_clusters(PointsSoA<Ndim>& h_points,
+                       PointsAlpaka<Ndim>& d_points,
+                       const KernelType& kernel,
+                       Queue queue_,
+                       std::size_t block_size,
+                       const std::string& checkpoint_path);
+    // Same as above, but if the cache contains the results for the same points and
+    // parameters they are copied in the points instead of running the clustering.
+    // Otherwise the results are stored in the cache.
+    template <typename KernelType>
+    void make_clusters(PointsSoA<Ndim>& h_points,
+                       PointsAlpaka<Ndim>& d_points,
+                       const KernelType& kernel,
+                       Queue queue_,
+                       std::size_t block_size,
+                       clue::ResultCache& cache);
+
+    // Copies the points to the device, where subsets of them can then be clustered
+    // multiple times without transferring the coordinates again
+    void uploadPoints(const PointsSoA<Ndim>& h_points,
+                      PointsAlpaka<Ndim>& d_points,
+                      Queue queue,
+                      std::size_t block_size) {
+      copyPoints(h_points, d_points, queue, block_size);
+    }
+    // Clusters the n_selected points of d_points whose indexes are in the device array
+    // selected. The points must have been copied to the device with uploadPoints, and
+    // h_points only receives the results, where the points that are not selected
+    // have a cluster index of -1. The tiles are built only over the selected points.
+    template <typename KernelType>
+    void make_clusters(PointsSoA<Ndim>& h_points,
+                       PointsAlpaka<Ndim>& d_points,
+                       const uint32_t* selected,
+                       uint32_t n_selected,
+                       const KernelType& kernel,
+                       Queue queue_,
+                       std::size_t block_size);
+    // Same as above, but the points are selected by a device array of flags
+    template <typename KernelType>
+    void make_clusters(PointsSoA<Ndim>& h_points,
+                       PointsAlpaka<Ndim>& d_points,
+                       const uint8_t* mask,
+                       const KernelType& kernel,
+                       Queue queue_,
+                       std::size_t block_size);
+
+    // Runs the stages of the algorithm up to last_stage, for the applications that
+    // only need the densities or the outliers. Only the launches and the buffers
+    // needed by these stages are run and allocated, in particular the seeds and the
+    // followers are not used before the classification. The results of the last stage
+    // are retrieved with the getters below, except for the classification and the
+    // assignment, whose results are copied in h_points. When stopping after the
+    // classification, the cluster index is -1 for the outliers and 0 for the points
+    // that would be assigned to a cluster.
+    template <typename KernelType>
+    void run_stages(clue::Stage last_stage,
+                    PointsSoA<Ndim>& h_points,
+                    PointsAlpaka<Ndim>& d_points,
+                    const KernelType& kernel,
+                    Queue queue,
+                    std::size_t block_size);
+    // Runs the nearest-higher stage after run_stages stopped after the density, with
+    // the densities of the points replaced by rho. This is used when the densities of
+    // some of the points are computed elsewhere, like the ghosts received from the
+    // other processes in the distributed version.
+    void resume_nearest_higher(std::span<const float> rho,
+                               PointsAlpaka<Ndim>& d_points,
+                               Queue queue,
+                               std::size_t block_size);
+
+    // Clusters the points at each of the radii, which must be in ascending order and
+    // at most max_scales, and links each cluster to the cluster containing most of
+    // its points at the next scale. The tiles are built once, and the densities of
+    // all the scales are computed with a single search within the largest radius.
+    // The outlier distance of each scale keeps the ratio dm / dc of the parameters,
+    // and the results of the finest scale are also copied in h_points.
+    template <typename KernelType>
+    clue::ClusterHierarchy make_cluster_hierarchy(PointsSoA<Ndim>& h_points,
+                                                  PointsAlpaka<Ndim>& d_points,
+                                                  std::span<const float> radii,
+                                                  const KernelType& kernel,
+                                                  Queue queue,
+                                                  std::size_t block_size);
+
+    // Builds the adjacency graph of the clusters found by the last make_clusters on
+    // d_points, where two clusters are linked when some pair of their points lies
+    // within distance, searching the tiles of that run. h_points must contain its
+    // results. It can't be used after clustering a subset of the points or with the
+    // halo wrapping, whose tiles don't contain the points of d_points, after a
+    // cluster hierarchy or after run_stages stopped before the assignment, and throws
+    // std::logic_error in these cases.
+    clue::ClusterGraph make_cluster_graph(const PointsSoA<Ndim>& h_points,
+                                          PointsAlpaka<Ndim>& d_points,
+                                          float distance,
+                                          Queue queue,
+                                          std::size_t block_size);
+
+    // Folds the points of each cluster found by the last make_clusters on d_points
+    // with the reduction, over a permutation of the points sorted by cluster whose
+    // chunks are reduced in parallel, and returns the value of each cluster. Only
+    // these values are copied to the host. h_points must contain the results, and as
+    // for the cluster graph the clusters of a subset, of the halo wrapping, of a
+    // hierarchy or of a partial run can't be reduced, and std::logic_error is thrown.
+    // The interface of the reductions is described in ClusterReduction.hpp.
+    template <typename TReduction>
+    std::vector<typename TReduction::value_type> reduce_clusters(
+        const PointsSoA<Ndim>& h_points,
+        PointsAlpaka<Ndim>& d_points,
+        const TReduction& reduction,
+        Queue queue,
+        std::size_t block_size);
+
+    // Copy to the host the densities, available after the density stage, and the
+    // deltas and nearest highers, available when stopping after the nearest-higher
+    // or the classification stage
+    std::vector<float> getDensity(PointsAlpaka<Ndim>& d_points, Queue queue) const;
+    std::vector<float> getDelta(PointsAlpaka<Ndim>& d_points, Queue queue) const;
+    std::vector<int> getNearestHigher(PointsAlpaka<Ndim>& d_points, Queue queue) const;
+
+    // Hash of the points and of all the parameters that affect the results, used as
+    // key of the result cache
+    template <typename KernelType>
+    uint64_t inputHash(const PointsSoA<Ndim>& h_points, const KernelType& kernel) const;
 
     std::vector<std::vector<int>> getClusters(const PointsSoA<Ndim>& h_points);
 
+    // When enabled and dm <= dc, the neighbours of each point found within dm in the
+    // density step are cached and reused in the nearest-higher step, instead of
+    // searching the tiles a second time. This requires max_neighbours indexes and
+    // distances of additional device memory per point. The cache isn't used for the
+    // points with wrapped coordinates.
+    void cacheNeighbours(bool enable) { cacheNeighbours_ = enable; }
+
+    // When enabled, the results don't depend on the order in which the points are
+    // visited, so they are bitwise identical across runs and CPU backends. The
+    // densities are accumulated in fixed point, with a resolution of
+    // 1 / fixed_point_scale, and the seeds are sorted before assigning the cluster
+    // indexes, which costs a copy of the seeds to the host.
+    void reproducibleResults(bool enable) { reproducible_ = enable; }
+
+    // Events with at most max_points points are clustered with a single kernel launch,
+    // which runs all the stages in one block. This is disabled by default, and meant
+    // for the serial backend, where fused_max_points is a reasonable threshold. On the
+    // other backends a block runs on a single thread, so the fused events are run
+    // serially. The fused events don't use the neighbour cache or the tile
+    // interaction lists. Setting it to zero disables the fused kernel.
+    void fuseSmallEvents(uint32_t max_points) { fusedMaxPoints_ = max_points; }
+
+    // When enabled, the periodic coordinates are handled by replicating the points
+    // within max(dc, dm) from their boundaries beyond the opposite ones, instead of
+    // wrapping the searches around the tiles. The points and their ghosts are
+    // clustered in an internal buffer, so the points passed on the device are left
+    // untouched. Only the plain make_clusters is affected, which then never uses the
+    // fused kernel.
+    void haloWrapping(bool enable) { haloWrapping_ = enable; }
+
+    // When enabled, the density and the nearest higher are evaluated over pairs of
+    // tiles, using the lists of neighbouring tiles built once per tile, with each work
+    // item processing the points of a tile in blocks. This increases the reuse of the
+    // coordinates on the CPU backends, but exposes only one work item per tile, so it
+    // is not meant for the GPUs. It replaces the neighbour cache, while the tiles
+    // with wrapped coordinates and the events run by the fused kernel are still
+    // searched point by point.
+    void tileInteractionLists(bool enable) { tilePairs_ = enable; }
+
   private:
     float dc_;
     float rhoc_;
     float dm_;
     // average number of points found in a tile
     int pointsPerTile_;
+    bool cacheNeighbours_{false};
+    bool reproducible_{false};
+    uint32_t fusedMaxPoints_{0};
+    bool haloWrapping_{false};
+    bool tilePairs_{false};
+    // whether the current tiles have wrapped coordinates
+    bool wrappedTiles_{false};
+    // the kind of the last run, as the cluster graph and the reductions need the
+    // results of a complete run over all the points of d_points. A partial run stops
+    // before the assignment, so the cluster indexes aren't the final ones.
+    enum class RunKind : uint8_t { none, points, partial, subset, halo, hierarchy };
+    RunKind lastRun_{RunKind::none};
 
     // internal buffers
     std::optional<TilesAlpaka<Ndim>> d_tiles;
@@ -69,20 +269,132 @@ namespace ALPAKA_ACCELERATOR_NAMESPACE_CLUE {
     std::optional<clue::device_buffer<Device, clue::VecArray<int32_t, max_followers>[]>>
         d_followers;
     std::optional<PointsAlpaka<Ndim>> d_points;
+    std::optional<clue::device_buffer<Device, int32_t[]>> d_neighbours;
+    std::optional<clue::device_buffer<Device, float[]>> d_neighbour_distances;
+    std::optional<clue::device_buffer<Device, int32_t[]>> d_neighbour_sizes;
+    std::optional<clue::device_buffer<Device, uint32_t[]>> d_fused_scratch;
+    // used for clustering a subset of the points
+    std::optional<PointsAlpaka<Ndim>> d_subset_points;
+    std::optional<clue::device_buffer<Device, uint32_t[]>> d_selected;
+    std::optional<clue::device_buffer<Device, uint32_t[]>> d_mask_positions;
+    // used for clustering the points together with their ghosts
+    std::optional<PointsAlpaka<Ndim>> d_halo_points;
+    // lists of the neighbours of the tiles
+    std::optional<clue::device_buffer<Device, uint32_t[]>> d_tile_counts;
+    std::optional<clue::device_buffer<Device, uint32_t[]>> d_tile_positions;
+    std::optional<clue::device_buffer<Device, uint32_t[]>> d_tile_offsets;
+    std::optional<clue::device_buffer<Device, uint32_t[]>> d_tile_interactions;
 
-    void init_device(Queue queue_);
     void init_device(Queue queue_, TilesAlpaka<Ndim>* tile_buffer);
+    void setupClusters(Queue queue);
 
+    int32_t resizeTiles(Queue queue, uint32_t n_points);
     void setupTiles(Queue queue, const PointsSoA<Ndim>& h_points);
+    // the geometry of the tiles is computed on the device from the selected points
+    void setupSubsetTiles(Queue queue,
+                          const PointsSoA<Ndim>& h_points,
+                          PointsAlpaka<Ndim>& subset_points,
+                          uint32_t n_selected,
+                          std::size_t block_size);
+    void copyPoints(const PointsSoA<Ndim>& h_points,
+                    PointsAlpaka<Ndim>& dev_points,
+                    Queue queue,
+                    std::size_t block_size);
+    // h_input contains the coordinates of the points in SoA layout followed by their
+    // weights
+    void copyPoints(const float* h_input,
+                    uint32_t nPoints,
+                    PointsAlpaka<Ndim>& dev_points,
+                    Queue queue,
+                    std::size_t block_size);
     void setupPoints(const PointsSoA<Ndim>& h_points,
                      PointsAlpaka<Ndim>& dev_points,
                      Queue queue,
                      std::size_t block_size);
+    void resetClusters(Queue queue, uint32_t n_points, std::size_t block_size);
 
     void calculate_tile_size(CoordinateExtremes<Ndim>* min_max,
                              float* tile_sizes,
                              const PointsSoA<Ndim>& h_points,
                              uint32_t nPerDim);
+
+    NeighbourCache setupNeighbourCache(Queue queue, uint32_t n_points);
+    // filled by the density stage when the neighbours are cached
+    std::optional<NeighbourCache> m_neighbourCache;
+    TileInteractions setupTileInteractions(Queue queue, std::size_t block_size);
+    // filled by the density stage when it is evaluated over pairs of tiles
+    std::optional<TileInteractions> m_tileInteractions;
+
+    template <typename KernelType, typename TAccumulator>
+    void launch_local_density(PointsAlpaka<Ndim>& dev_points,
+                              const KernelType& kernel,
+                              Queue queue,
+                              std::size_t block_size,
+                              uint32_t n_points,
+                              TAccumulator accumulator);
+    void sort_seeds(Queue queue);
+
+    template <typename KernelType>
+    void run_fused(PointsAlpaka<Ndim>& dev_points,
+                   const KernelType& kernel,
+                   Queue queue,
+                   std::size_t block_size,
+                   uint32_t n_points);
+
+    // stages of the algorithm
+    template <typename KernelType>
+    void calculate_local_density(PointsAlpaka<Ndim>& dev_points,
+                                 const KernelType& kernel,
+                                 Queue queue,
+                                 std::size_t block_size,
+                                 uint32_t n_points);
+    void calculate_nearest_higher(PointsAlpaka<Ndim>& dev_points,
+                                  Queue queue,
+                                  std::size_t block_size,
+                                  uint32_t n_points);
+    void find_clusters(PointsAlpaka<Ndim>& dev_points,
+                       Queue queue,
+                       std::size_t block_size,
+                       uint32_t n_points);
+    template <typename KernelType>
+    void make_clusters_halo(PointsSoA<Ndim>& h_points,
+                            const KernelType& kernel,
+                            Queue queue,
+                            std::size_t block_size);
+
+    // runs the two stages above in a single kernel
+    void calculate_nearest_higher_and_classify(PointsAlpaka<Ndim>& dev_points,
+                                               Queue queue,
+                                               std::size_t block_size,
+                                               uint32_t n_points) {
+      calculate_nearest_higher_and_classify(
+          dev_points, queue, block_size, n_points, dc_, dm_);
+    }
+    // same as above, with the given radii instead of the ones of the algorithm
+    void calculate_nearest_higher_and_classify(PointsAlpaka<Ndim>& dev_points,
+                                               Queue queue,
+                                               std::size_t block_size,
+                                               uint32_t n_points,
+                                               float dc,
+                                               float dm);
+    void assign_clusters(PointsAlpaka<Ndim>& dev_points,
+                         Queue queue,
+                         std::size_t block_size);
+    void copy_results(PointsSoA<Ndim>& h_points,
+                      PointsAlpaka<Ndim>& dev_points,
+                      Queue queue);
+
+    void save_checkpoint(const std::string& path,
+                         clue::Stage stage,
+                         uint64_t input_hash,
+                         PointsAlpaka<Ndim>& dev_points,
+                         Queue queue,
+                         uint32_t n_points);
+    clue::Stage load_checkpoint(const std::string& path,
+                                uint64_t input_hash,
+                                PointsAlpaka<Ndim>& dev_points,
+                                Queue queue,
+                                uint32_t n_points);
   };
 
   template <uint8_t Ndim>
@@ -107,7 +419,10 @@ namespace ALPAKA_ACCELERATOR_NAMESPACE_CLUE {
   }
 
   template <uint8_t Ndim>
-  void CLUEAlgoAlpaka<Ndim>::init_device(Queue queue) {
+  void CLUEAlgoAlpaka<Ndim>::setupClusters(Queue queue) {
+    if (d_seeds.has_value()) {
+      return;
+    }
     d_seeds = clue::make_device_buffer<VecArray<int32_t, reserve>>(queue);
     d_followers =
         clue::make_device_buffer<VecArray<int32_t, max_followers>[]>(queue, reserve);
@@ -117,40 +432,40 @@ namespace ALPAKA_ACCELERATOR_NAMESPACE_CLUE {
   }
 
   template <uint8_t Ndim>
-  void CLUEAlgoAlpaka<Ndim>::init_device(Queue queue_, TilesAlpaka<Ndim>* tile_buffer) {
-    d_seeds = clue::make_device_buffer<VecArray<int32_t, reserve>>(queue_);
-    d_followers =
-        clue::make_device_buffer<VecArray<int32_t, max_followers>[]>(queue_, reserve);
-
-    m_seeds = (*d_seeds).data();
-    m_followers = (*d_followers).data();
-
+  void CLUEAlgoAlpaka<Ndim>::init_device(Queue, TilesAlpaka<Ndim>* tile_buffer) {
     // load tiles from outside
     d_tiles = *tile_buffer;
     m_tiles = tile_buffer->view();
   }
 
   template <uint8_t Ndim>
-  void CLUEAlgoAlpaka<Ndim>::setupTiles(Queue queue, const PointsSoA<Ndim>& h_points) {
+  int32_t CLUEAlgoAlpaka<Ndim>::resizeTiles(Queue queue, uint32_t n_points) {
     // TODO: reconsider the way that we compute the number of tiles
-    auto nTiles = static_cast<int32_t>(
-        std::ceil(h_points.nPoints() / static_cast<float>(pointsPerTile_)));
+    auto nTiles =
+        static_cast<int32_t>(std::ceil(n_points / static_cast<float>(pointsPerTile_)));
     const auto nPerDim = static_cast<int32_t>(std::ceil(std::pow(nTiles, 1. / Ndim)));
     nTiles = static_cast<int32_t>(std::pow(nPerDim, Ndim));
 
     if (!d_tiles.has_value()) {
-      d_tiles = std::make_optional<TilesAlpaka<Ndim>>(queue, h_points.nPoints(), nTiles);
+      d_tiles = std::make_optional<TilesAlpaka<Ndim>>(queue, n_points, nTiles);
       m_tiles = d_tiles->view();
     }
-    // check if tiles are large enough for current data
+    // check if tiles are large enough for current data, the offsets having one entry
+    // more than the tiles
     if (!(alpaka::trait::GetExtents<clue::device_buffer<Device, uint32_t[]>>{}(
-              d_tiles->indexes())[0u] >= h_points.nPoints()) or
+              d_tiles->indexes())[0u] >= n_points) or
         !(alpaka::trait::GetExtents<clue::device_buffer<Device, uint32_t[]>>{}(
-              d_tiles->offsets())[0u] >= nTiles)) {
-      d_tiles->initialize(h_points.nPoints(), nTiles, nPerDim, queue);
+              d_tiles->offsets())[0u] > nTiles)) {
+      d_tiles->initialize(n_points, nTiles, nPerDim, queue);
     } else {
-      d_tiles->reset(h_points.nPoints(), nTiles, nPerDim, queue);
+      d_tiles->reset(n_points, nTiles, nPerDim, queue);
     }
+    return nPerDim;
+  }
+
+  template <uint8_t Ndim>
+  void CLUEAlgoAlpaka<Ndim>::setupTiles(Queue queue, const PointsSoA<Ndim>& h_points) {
+    const auto nPerDim = resizeTiles(queue, h_points.nPoints());
 
     auto min_max = clue::make_host_buffer<CoordinateExtremes<Ndim>>(queue);
     auto tile_sizes = clue::make_host_buffer<float[Ndim]>(queue);
@@ -161,27 +476,183 @@ namespace ALPAKA_ACCELERATOR_NAMESPACE_CLUE {
     alpaka::memcpy(queue, d_tiles->tileSize(), tile_sizes);
     alpaka::memcpy(
         queue, d_tiles->wrapped(), clue::make_host_view(h_points.wrapped().data(), Ndim));
+    const auto& wrapped = h_points.wrapped();
+    wrappedTiles_ =
+        std::any_of(wrapped.begin(), wrapped.end(), [](auto w) { return w != 0; });
     alpaka::wait(queue);
   }
 
+  template <uint8_t Ndim>
+  void CLUEAlgoAlpaka<Ndim>::setupSubsetTiles(Queue queue,
+                                              const PointsSoA<Ndim>& h_points,
+                                              PointsAlpaka<Ndim>& subset_points,
+                                              uint32_t n_selected,
+                                              std::size_t block_size) {
+    const auto nPerDim = resizeTiles(queue, n_selected);
+
+    auto min_max = clue::make_host_buffer<CoordinateExtremes<Ndim>>(queue);
+    for (size_t dim{}; dim != Ndim; ++dim) {
+      min_max->min(dim) = std::numeric_limits<float>::max();
+      min_max->max(dim) = std::numeric_limits<float>::lowest();
+    }
+    alpaka::memcpy(queue, d_tiles->minMax(), min_max);
+    alpaka::memcpy(
+        queue, d_tiles->wrapped(), clue::make_host_view(h_points.wrapped().data(), Ndim));
+    const auto& wrapped = h_points.wrapped();
+    wrappedTiles_ =
+        std::any_of(wrapped.begin(), wrapped.end(), [](auto w) { return w != 0; });
+
+    const Idx grid_size = clue::divide_up_by(n_selected, block_size);
+    const auto working_div = clue::make_workdiv<Acc1D>(grid_size, block_size);
+    alpaka::exec<Acc1D>(queue,
+                        working_div,
+                        KernelCalculateExtremes<Ndim>{},
+                        subset_points.view(),
+                        d_tiles->minMax().data(),
+                        n_selected);
+    alpaka::exec<Acc1D>(queue,
+                        clue::make_workdiv<Acc1D>(1, Ndim),
+                        KernelCalculateTileSizes<Ndim>{},
+                        d_tiles->minMax().data(),
+                        d_tiles->tileSize().data(),
+                        nPerDim);
+    alpaka::wait(queue);
+  }
+
+  template <uint8_t Ndim>
+  void CLUEAlgoAlpaka<Ndim>::copyPoints(const PointsSoA<Ndim>& h_points,
+                                        PointsAlpaka<Ndim>& dev_points,
+                                        Queue queue,
+                                        std::size_t block_size) {
+    copyPoints(h_points.coords(), h_points.nPoints(), dev_points, queue, block_size);
+  }
+
+  template <uint8_t Ndim>
+  void CLUEAlgoAlpaka<Ndim>::copyPoints(const float* h_input,
+                                        uint32_t nPoints,
+                                        PointsAlpaka<Ndim>& dev_points,
+                                        Queue queue,
+                                        std::size_t block_size) {
+    if constexpr (aosoa_block == 0) {
+      // the coordinates and the weights are copied together
+      const auto copyExtent = (Ndim + 1) * nPoints;
+      alpaka::memcpy(queue,
+                     dev_points.input_buffer,
+                     clue::make_host_view(h_input, copyExtent),
+                     copyExtent);
+    } else {
+      // the coordinates are rearranged on the device
+      auto soa_coords = clue::make_device_buffer<float[]>(queue, Ndim * nPoints);
+      alpaka::memcpy(queue, soa_coords, clue::make_host_view(h_input, Ndim * nPoints));
+      const auto device = alpaka::getDev(queue);
+      float* d_weights = dev_points.input_buffer.data() + coordsSize<Ndim>(nPoints);
+      alpaka::memcpy(queue,
+                     clue::make_device_view(device, d_weights, nPoints),
+                     clue::make_host_view(h_input + Ndim * nPoints, nPoints));
+
+      const Idx grid_size = clue::divide_up_by(nPoints, block_size);
+      const auto working_div = clue::make_workdiv<Acc1D>(grid_size, block_size);
+      alpaka::exec<Acc1D>(queue,
+                          working_div,
+                          KernelFillCoords<Ndim>{},
+                          soa_coords.data(),
+                          dev_points.view(),
+                          nPoints);
+    }
+  }
+
   template <uint8_t Ndim>
   void CLUEAlgoAlpaka<Ndim>::setupPoints(const PointsSoA<Ndim>& h_points,
                                          PointsAlpaka<Ndim>& dev_points,
                                          Queue queue,
                                          std::size_t block_size) {
-    const auto copyExtent = (Ndim + 1) * h_points.nPoints();
-    alpaka::memcpy(queue,
-                   dev_points.input_buffer,
-                   clue::make_host_view(h_points.coords(), copyExtent),
-                   copyExtent);
+    copyPoints(h_points, dev_points, queue, block_size);
+    resetClusters(queue, h_points.nPoints(), block_size);
+  }
 
+  template <uint8_t Ndim>
+  void CLUEAlgoAlpaka<Ndim>::resetClusters(Queue queue,
+                                           uint32_t n_points,
+                                           std::size_t block_size) {
+    setupClusters(queue);
     // TODO: when reworking the followers with the association map, this piece of
     // code will need to be moved
     alpaka::memset(queue, *d_seeds, 0x00);
-    const Idx grid_size = clue::divide_up_by(h_points.nPoints(), block_size);
+    const Idx grid_size = clue::divide_up_by(n_points, block_size);
     const auto working_div = clue::make_workdiv<Acc1D>(grid_size, block_size);
     alpaka::exec<Acc1D>(
-        queue, working_div, KernelResetFollowers{}, m_followers, h_points.nPoints());
+        queue, working_div, KernelResetFollowers{}, m_followers, n_points);
+  }
+
+  template <uint8_t Ndim>
+  NeighbourCache CLUEAlgoAlpaka<Ndim>::setupNeighbourCache(Queue queue,
+                                                           uint32_t n_points) {
+    // the buffers are only reallocated when they are too small for the current data
+    if (!d_neighbour_sizes.has_value() or
+        alpaka::trait::GetExtents<clue::device_buffer<Device, int32_t[]>>{}(
+            *d_neighbour_sizes)[0u] < n_points) {
+      d_neighbours =
+          clue::make_device_buffer<int32_t[]>(queue, max_neighbours * n_points);
+      d_neighbour_distances =
+          clue::make_device_buffer<float[]>(queue, max_neighbours * n_points);
+      d_neighbour_sizes = clue::make_device_buffer<int32_t[]>(queue, n_points);
+    }
+
+    return NeighbourCache{(*d_neighbours).data(),
+                          (*d_neighbour_distances).data(),
+                          (*d_neighbour_sizes).data(),
+                          dm_ * dm_,
+                          n_points};
+  }
+
+  template <uint8_t Ndim>
+  TileInteractions CLUEAlgoAlpaka<Ndim>::setupTileInteractions(Queue queue,
+                                                               std::size_t block_size) {
+    const auto n_tiles = static_cast<uint32_t>(d_tiles->size());
+    if (!d_tile_offsets.has_value() or
+        alpaka::getExtentProduct(*d_tile_offsets) < n_tiles + 1) {
+      d_tile_counts = clue::make_device_buffer<uint32_t[]>(queue, n_tiles);
+      d_tile_positions = clue::make_device_buffer<uint32_t[]>(queue, n_tiles);
+      d_tile_offsets = clue::make_device_buffer<uint32_t[]>(queue, n_tiles + 1);
+    }
+
+    // the neighbours are listed within the largest of the two search radii
+    const float radius{std::max(dc_, dm_)};
+    const Idx grid_size = clue::divide_up_by(n_tiles, block_size);
+    const auto working_div = clue::make_workdiv<Acc1D>(grid_size, block_size);
+    alpaka::exec<Acc1D>(queue,
+                        working_div,
+                        KernelCountTileInteractions<Ndim>{},
+                        m_tiles,
+                        (*d_tile_counts).data(),
+                        radius);
+    clue::inclusivePrefixScan<Acc1D>(
+        queue, (*d_tile_counts).data(), (*d_tile_positions).data(), n_tiles);
+
+    // the total size of the lists is the last element of the scan
+    auto n_interactions = clue::make_host_buffer<uint32_t[]>(queue, 1);
+    alpaka::memcpy(queue,
+                   n_interactions,
+                   clue::make_device_view(alpaka::getDev(queue),
+                                          (*d_tile_positions).data() + n_tiles - 1,
+                                          1));
+    alpaka::wait(queue);
+    const auto total = n_interactions.data()[0];
+    if (!d_tile_interactions.has_value() or
+        alpaka::getExtentProduct(*d_tile_interactions) < total) {
+      d_tile_interactions = clue::make_device_buffer<uint32_t[]>(queue, total);
+    }
+    alpaka::exec<Acc1D>(queue,
+                        working_div,
+                        KernelFillTileInteractions<Ndim>{},
+                        m_tiles,
+                        (*d_tile_counts).data(),
+                        (*d_tile_positions).data(),
+                        (*d_tile_offsets).data(),
+                        (*d_tile_interactions).data(),
+                        radius);
+
+    return TileInteractions{(*d_tile_offsets).data(), (*d_tile_interactions).data()};
   }
 
   template <uint8_t Ndim>
@@ -195,39 +666,166 @@ namespace ALPAKA_ACCELERATOR_NAMESPACE_CLUE {
     make_clusters(h_points, dev_points, kernel, queue, block_size);
   }
 
+  template <uint8_t Ndim>
+  template <typename KernelType, typename TAccumulator>
+  void CLUEAlgoAlpaka<Ndim>::launch_local_density(PointsAlpaka<Ndim>& dev_points,
+                                                  const KernelType& kernel,
+                                                  Queue queue,
+                                                  std::size_t block_size,
+                                                  uint32_t n_points,
+                                                  TAccumulator accumulator) {
+    if (m_tileInteractions.has_value()) {
+      const Idx grid_size = clue::divide_up_by(d_tiles->size(), block_size);
+      alpaka::exec<Acc1D>(queue,
+                          clue::make_workdiv<Acc1D>(grid_size, block_size),
+                          KernelCalculateLocalDensityTilePairs{},
+                          m_tiles,
+                          dev_points.view(),
+                          *m_tileInteractions,
+                          kernel,
+                          dc_,
+                          n_points,
+                          accumulator);
+      return;
+    }
+    const Idx grid_size = clue::divide_up_by(n_points, block_size);
+    auto working_div = clue::make_workdiv<Acc1D>(grid_size, block_size);
+    auto launch = [&](auto neighbours, auto distance) {
+      alpaka::exec<Acc1D>(queue,
+                          working_div,
+                          KernelCalculateLocalDensity{},
+                          m_tiles,
+                          dev_points.view(),
+                          kernel,
+                          dc_,
+                          n_points,
+                          neighbours,
+                          distance,
+                          accumulator);
+    };
+    // the neighbours are only cached without wrapping, and the tiles of the halo
+    // wrapping are never wrapped
+    if (m_neighbourCache.has_value()) {
+      launch(*m_neighbourCache, EuclideanDistance{});
+    } else if (wrappedTiles_) {
+      launch(NoNeighbourCache{}, PeriodicDistance{});
+    } else {
+      launch(NoNeighbourCache{}, EuclideanDistance{});
+    }
+  }
+
   template <uint8_t Ndim>
   template <typename KernelType>
-  void CLUEAlgoAlpaka<Ndim>::make_clusters(PointsSoA<Ndim>& h_points,
-                                           PointsAlpaka<Ndim>& dev_points,
-                                           const KernelType& kernel,
-                                           Queue queue,
-                                           std::size_t block_size) {
-    const auto device = alpaka::getDev(queue);
-    setupTiles(queue, h_points);
-    setupPoints(h_points, dev_points, queue, block_size);
-    const auto nPoints = h_points.nPoints();
+  void CLUEAlgoAlpaka<Ndim>::run_fused(PointsAlpaka<Ndim>& dev_points,
+                                       const KernelType& kernel,
+                                       Queue queue,
+                                       std::size_t block_size,
+                                       uint32_t n_points) {
+    setupClusters(queue);
+    const auto scratch_size = n_points + static_cast<uint32_t>(d_tiles->size());
+    if (!d_fused_scratch.has_value() or
+        alpaka::getExtentProduct(*d_fused_scratch) < scratch_size) {
+      d_fused_scratch = clue::make_device_buffer<uint32_t[]>(queue, scratch_size);
+    }
 
-    // fill the tiles
-    d_tiles->fill(queue, dev_points, nPoints);
+    // all the points are processed by a single block
+    const auto working_div = clue::make_workdiv<Acc1D>(1, block_size);
+    auto launch = [&](auto accumulator) {
+      alpaka::exec<Acc1D>(queue,
+                          working_div,
+                          KernelFusedClustering{},
+                          m_tiles,
+                          dev_points.view(),
+                          m_seeds,
+                          m_followers,
+                          (*d_fused_scratch).data(),
+                          kernel,
+                          dc_,
+                          rhoc_,
+                          dm_,
+                          n_points,
+                          accumulator,
+                          reproducible_);
+    };
+    if (reproducible_) {
+      launch(FixedPointAccumulator{fixed_point_scale});
+    } else {
+      launch(FloatAccumulator{});
+    }
+  }
 
-    const Idx grid_size = clue::divide_up_by(nPoints, block_size);
+  template <uint8_t Ndim>
+  template <typename KernelType>
+  void CLUEAlgoAlpaka<Ndim>::calculate_local_density(PointsAlpaka<Ndim>& dev_points,
+                                                     const KernelType& kernel,
+                                                     Queue queue,
+                                                     std::size_t block_size,
+                                                     uint32_t n_points) {
+    if (tilePairs_ and !wrappedTiles_) {
+      m_tileInteractions = setupTileInteractions(queue, block_size);
+    } else {
+      m_tileInteractions.reset();
+    }
+    // the cached distances are the periodic ones, while the nearest-higher search
+    // doesn't wrap the coordinates, so the cache is only used without wrapping
+    if (cacheNeighbours_ and dm_ <= dc_ and !wrappedTiles_ and
+        !m_tileInteractions.has_value()) {
+      m_neighbourCache = setupNeighbourCache(queue, n_points);
+    } else {
+      m_neighbourCache.reset();
+    }
+
+    if (reproducible_) {
+      launch_local_density(dev_points,
+                           kernel,
+                           queue,
+                           block_size,
+                           n_points,
+                           FixedPointAccumulator{fixed_point_scale});
+    } else {
+      launch_local_density(
+          dev_points, kernel, queue, block_size, n_points, FloatAccumulator{});
+    }
+  }
+
+  template <uint8_t Ndim>
+  void CLUEAlgoAlpaka<Ndim>::calculate_nearest_higher(PointsAlpaka<Ndim>& dev_points,
+                                                      Queue queue,
+                                                      std::size_t block_size,
+                                                      uint32_t n_points) {
+    m_tileInteractions.reset();
+    const Idx grid_size = clue::divide_up_by(n_points, block_size);
+    auto working_div = clue::make_workdiv<Acc1D>(grid_size, block_size);
+    // the cache is only available if it was filled by the density stage of this run
+    if (m_neighbourCache.has_value()) {
+      alpaka::exec<Acc1D>(queue,
+                          working_div,
+                          KernelCalculateNearestHigherCached{},
+                          m_tiles,
+                          dev_points.view(),
+                          *m_neighbourCache,
+                          dm_,
+                          n_points);
+      m_neighbourCache.reset();
+    } else {
+      alpaka::exec<Acc1D>(queue,
+                          working_div,
+                          KernelCalculateNearestHigher{},
+                          m_tiles,
+                          dev_points.view(),
+                          dm_,
+                          dc_,
+                          n_points);
+    }
+  }
+
+  template <uint8_t Ndim>
+  void CLUEAlgoAlpaka<Ndim>::find_clusters(PointsAlpaka<Ndim>& dev_points,
+                                           Queue queue,
+                                           std::size_t block_size,
+                                           uint32_t n_points) {
+    const Idx grid_size = clue::divide_up_by(n_points, block_size);
     auto working_div = clue::make_workdiv<Acc1D>(grid_size, block_size);
-    alpaka::exec<Acc1D>(queue,
-                        working_div,
-                        KernelCalculateLocalDensity{},
-                        m_tiles,
-                        dev_points.view(),
-                        kernel,
-                        dc_,
-                        nPoints);
-    alpaka::exec<Acc1D>(queue,
-                        working_div,
-                        KernelCalculateNearestHigher{},
-                        m_tiles,
-                        dev_points.view(),
-                        dm_,
-                        dc_,
-                        nPoints);
     alpaka::exec<Acc1D>(queue,
                         working_div,
                         KernelFindClusters<Ndim>{},
@@ -237,7 +835,81 @@ namespace ALPAKA_ACCELERATOR_NAMESPACE_CLUE {
                         dm_,
                         dc_,
                         rhoc_,
-                        nPoints);
+                        n_points);
+  }
+
+  template <uint8_t Ndim>
+  void CLUEAlgoAlpaka<Ndim>::calculate_nearest_higher_and_classify(
+      PointsAlpaka<Ndim>& dev_points,
+      Queue queue,
+      std::size_t block_size,
+      uint32_t n_points,
+      float dc,
+      float dm) {
+    // the lists are only available if they were built by the density stage of this run
+    if (m_tileInteractions.has_value()) {
+      const Idx grid_size = clue::divide_up_by(d_tiles->size(), block_size);
+      alpaka::exec<Acc1D>(queue,
+                          clue::make_workdiv<Acc1D>(grid_size, block_size),
+                          KernelCalculateNearestHigherTilePairs{},
+                          m_tiles,
+                          dev_points.view(),
+                          *m_tileInteractions,
+                          m_seeds,
+                          m_followers,
+                          dm,
+                          dc,
+                          rhoc_,
+                          n_points);
+      m_tileInteractions.reset();
+      return;
+    }
+    const Idx grid_size = clue::divide_up_by(n_points, block_size);
+    auto working_div = clue::make_workdiv<Acc1D>(grid_size, block_size);
+    auto launch = [&](auto neighbours) {
+      alpaka::exec<Acc1D>(queue,
+                          working_div,
+                          KernelCalculateNearestHigherAndClassify{},
+                          m_tiles,
+                          dev_points.view(),
+                          m_seeds,
+                          m_followers,
+                          neighbours,
+                          dm,
+                          dc,
+                          rhoc_,
+                          n_points);
+    };
+    // the cache is only available if it was filled by the density stage of this run
+    if (m_neighbourCache.has_value()) {
+      launch(*m_neighbourCache);
+      m_neighbourCache.reset();
+    } else {
+      launch(NoNeighbourCache{});
+    }
+  }
+
+  template <uint8_t Ndim>
+  void CLUEAlgoAlpaka<Ndim>::sort_seeds(Queue queue) {
+    // the seeds are pushed with atomics, so their order changes between runs. Only
+    // their number is copied to the host, and the used entries are sorted on the device
+    int32_t n_seeds;
+    alpaka::memcpy(queue,
+                   clue::make_host_view(&n_seeds, 1),
+                   clue::make_device_view(alpaka::getDev(queue), &m_seeds->m_size, 1));
+    alpaka::wait(queue);
+    clue::bitonicSort<Acc1D>(
+        queue, m_seeds->m_data, static_cast<uint32_t>(n_seeds), clue::Ascending{});
+  }
+
+  template <uint8_t Ndim>
+  void CLUEAlgoAlpaka<Ndim>::assign_clusters(PointsAlpaka<Ndim>& dev_points,
+                                             Queue queue,
+                                             std::size_t block_size) {
+    // the index of the clusters is the position of their seed
+    if (reproducible_) {
+      sort_seeds(queue);
+    }
 
     // We change the working division when assigning the clusters
     const Idx grid_size_seeds = clue::divide_up_by(reserve, block_size);
@@ -250,26 +922,851 @@ namespace ALPAKA_ACCELERATOR_NAMESPACE_CLUE {
                         m_followers,
                         dev_points.view());
     alpaka::wait(queue);
+  }
 
+  template <uint8_t Ndim>
+  void CLUEAlgoAlpaka<Ndim>::copy_results(PointsSoA<Ndim>& h_points,
+                                          PointsAlpaka<Ndim>& dev_points,
+                                          Queue queue) {
+    const auto device = alpaka::getDev(queue);
+    const auto nPoints = h_points.nPoints();
 #ifdef CLUE_DEBUG
     alpaka::memcpy(queue,
                    clue::make_host_view(h_points.debugInfo().rho.data(), nPoints),
-                   clue::make_device_view(device, dev_points.view()->rho, nPoints));
+                   clue::make_device_view(device, dev_points.rho(), nPoints));
     alpaka::memcpy(queue,
-                   clue::make_host_view(h_points.debugInfo().rho.data(), nPoints),
-                   clue::make_device_view(device, dev_points.view()->delta, nPoints));
+                   clue::make_host_view(h_points.debugInfo().delta.data(), nPoints),
+                   clue::make_device_view(device, dev_points.delta(), nPoints));
     alpaka::memcpy(
         queue,
         clue::make_host_view(h_points.debugInfo().nearestHigher.data(), nPoints),
-        clue::make_device_view(device, dev_points.view()->nearest_higher, nPoints));
+        clue::make_device_view(device, dev_points.nearestHigher(), nPoints));
 #endif
 
+    if (dev_points.nStored() == static_cast<int>(nPoints)) {
+      // the cluster indexes are followed by the seed flags in both the buffers
+      alpaka::memcpy(queue,
+                     clue::make_host_view(h_points.clusterIndexes(), 2 * nPoints),
+                     clue::make_device_view(
+                         device, dev_points.clusterIndexes(), 2 * nPoints),
+                     2 * nPoints);
+    } else {
+      // the results of the ghosts are stored after the ones of the points
+      alpaka::memcpy(queue,
+                     clue::make_host_view(h_points.clusterIndexes(), nPoints),
+                     clue::make_device_view(
+                         device, dev_points.clusterIndexes(), nPoints));
+      alpaka::memcpy(queue,
+                     clue::make_host_view(h_points.isSeed(), nPoints),
+                     clue::make_device_view(device, dev_points.isSeed(), nPoints));
+    }
+    alpaka::wait(queue);
+  }
+
+  template <uint8_t Ndim>
+  template <typename KernelType>
+  void CLUEAlgoAlpaka<Ndim>::make_clusters(PointsSoA<Ndim>& h_points,
+                                           PointsAlpaka<Ndim>& dev_points,
+                                           const KernelType& kernel,
+                                           Queue queue,
+                                           std::size_t block_size) {
+    const auto& wrapped = h_points.wrapped();
+    if (haloWrapping_ and
+        std::any_of(wrapped.begin(), wrapped.end(), [](auto w) { return w != 0; })) {
+      make_clusters_halo(h_points, kernel, queue, block_size);
+      return;
+    }
+    lastRun_ = RunKind::points;
+
+    const auto nPoints = h_points.nPoints();
+    setupTiles(queue, h_points);
+    if (nPoints <= fusedMaxPoints_) {
+      // the fused kernel resets the seeds and followers itself
+      copyPoints(h_points, dev_points, queue, block_size);
+      run_fused(dev_points, kernel, queue, block_size, nPoints);
+      copy_results(h_points, dev_points, queue);
+      return;
+    }
+    setupPoints(h_points, dev_points, queue, block_size);
+
+    // fill the tiles
+    d_tiles->fill(queue, dev_points, nPoints);
+
+    calculate_local_density(dev_points, kernel, queue, block_size, nPoints);
+    calculate_nearest_higher_and_classify(dev_points, queue, block_size, nPoints);
+    assign_clusters(dev_points, queue, block_size);
+
+    copy_results(h_points, dev_points, queue);
+  }
+
+  template <uint8_t Ndim>
+  template <typename KernelType>
+  void CLUEAlgoAlpaka<Ndim>::make_clusters_halo(PointsSoA<Ndim>& h_points,
+                                                const KernelType& kernel,
+                                                Queue queue,
+                                                std::size_t block_size) {
+    lastRun_ = RunKind::halo;
+    const auto nPoints = h_points.nPoints();
+    const auto& wrapped = h_points.wrapped();
+    const float width{std::max(dc_, dm_)};
+
+    auto min_max = clue::make_host_buffer<CoordinateExtremes<Ndim>>(queue);
+    auto tile_sizes = clue::make_host_buffer<float[Ndim]>(queue);
+    calculate_tile_size(min_max.data(), tile_sizes.data(), h_points, 1);
+    const auto halo = buildHalo<Ndim>(h_points, *min_max, width);
+    const auto nGhosts = static_cast<uint32_t>(halo.origins.size());
+    const auto nStored = nPoints + nGhosts;
+
+    // the tiles cover the points and their ghosts, and are never wrapped
+    const auto nPerDim = resizeTiles(queue, nStored);
+    const std::array<uint8_t, Ndim> not_wrapped{};
+    for (size_t dim{}; dim != Ndim; ++dim) {
+      if (wrapped[dim]) {
+        min_max->min(dim) -= width;
+        min_max->max(dim) += width;
+      }
+      tile_sizes.data()[dim] = min_max->range(dim) / nPerDim;
+    }
+    alpaka::memcpy(queue, d_tiles->minMax(), min_max);
+    alpaka::memcpy(queue, d_tiles->tileSize(), tile_sizes);
+    alpaka::memcpy(
+        queue, d_tiles->wrapped(), clue::make_host_view(not_wrapped.data(), Ndim));
+    wrappedTiles_ = false;
+
+    if (!d_halo_points.has_value() or !d_halo_points->fits(nPoints, nGhosts)) {
+      d_halo_points = std::make_optional<PointsAlpaka<Ndim>>(queue, nPoints, nGhosts);
+    } else {
+      d_halo_points->resize(queue, nPoints, nGhosts);
+    }
+    auto& halo_points = *d_halo_points;
+    copyPoints(halo.input.data(), nStored, halo_points, queue, block_size);
+    alpaka::memcpy(queue,
+                   halo_points.ghost_origin,
+                   clue::make_host_view(halo.origins.data(), nGhosts),
+                   nGhosts);
+    alpaka::wait(queue);
+
+    resetClusters(queue, nPoints, block_size);
+    d_tiles->fill(queue, halo_points, nStored);
+
+    // only the real points are searched for, while the ghosts take their densities
+    calculate_local_density(halo_points, kernel, queue, block_size, nPoints);
+    if (nGhosts > 0) {
+      const Idx grid_size = clue::divide_up_by(nGhosts, block_size);
+      alpaka::exec<Acc1D>(queue,
+                          clue::make_workdiv<Acc1D>(grid_size, block_size),
+                          KernelCopyGhostDensity{},
+                          halo_points.view(),
+                          nGhosts);
+    }
+    calculate_nearest_higher_and_classify(halo_points, queue, block_size, nPoints);
+    assign_clusters(halo_points, queue, block_size);
+
+    copy_results(h_points, halo_points, queue);
+  }
+
+  template <uint8_t Ndim>
+  template <typename KernelType>
+  void CLUEAlgoAlpaka<Ndim>::make_clusters(PointsSoA<Ndim>& h_points,
+                                           PointsAlpaka<Ndim>& dev_points,
+                                           const KernelType& kernel,
+                                           Queue queue,
+                                           std::size_t block_size,
+                                           const std::string& checkpoint_path) {
+    lastRun_ = RunKind::points;
+    setupTiles(queue, h_points);
+    setupPoints(h_points, dev_points, queue, block_size);
+    const auto nPoints = h_points.nPoints();
+    // a checkpoint is only resumed by a run on the same input
+    const auto key = inputHash(h_points, kernel);
+
+    using clue::Stage;
+    auto save = [&](Stage stage) {
+      save_checkpoint(checkpoint_path, stage, key, dev_points, queue, nPoints);
+    };
+    const auto completed =
+        load_checkpoint(checkpoint_path, key, dev_points, queue, nPoints);
+    if (completed < Stage::tiles) {
+      d_tiles->fill(queue, dev_points, nPoints);
+      save(Stage::tiles);
+    }
+    if (completed < Stage::density) {
+      calculate_local_density(dev_points, kernel, queue, block_size, nPoints);
+      save(Stage::density);
+    }
+    if (completed < Stage::nearest_higher) {
+      calculate_nearest_higher(dev_points, queue, block_size, nPoints);
+      save(Stage::nearest_higher);
+    }
+    if (completed < Stage::classification) {
+      find_clusters(dev_points, queue, block_size, nPoints);
+      save(Stage::classification);
+    }
+    if (completed < Stage::assignment) {
+      assign_clusters(dev_points, queue, block_size);
+      save(Stage::assignment);
+    }
+
+    copy_results(h_points, dev_points, queue);
+  }
+
+  template <uint8_t Ndim>
+  template <typename KernelType>
+  void CLUEAlgoAlpaka<Ndim>::make_clusters(PointsSoA<Ndim>& h_points,
+                                           PointsAlpaka<Ndim>& dev_points,
+                                           const uint32_t* selected,
+                                           uint32_t n_selected,
+                                           const KernelType& kernel,
+                                           Queue queue,
+                                           std::size_t block_size) {
+    lastRun_ = RunKind::subset;
+    const auto nPoints = h_points.nPoints();
+    if (nPoints == 0) {
+      return;
+    }
+    Idx grid_size = clue::divide_up_by(nPoints, block_size);
+    auto working_div = clue::make_workdiv<Acc1D>(grid_size, block_size);
+    alpaka::exec<Acc1D>(
+        queue, working_div, KernelResetResults{}, dev_points.view(), nPoints);
+    if (n_selected == 0) {
+      copy_results(h_points, dev_points, queue);
+      return;
+    }
+
+    // the selected points are gathered on the device, so the coordinates are never
+    // transferred again
+    if (!d_subset_points.has_value() or !d_subset_points->fits(n_selected)) {
+      d_subset_points = std::make_optional<PointsAlpaka<Ndim>>(queue, n_selected);
+    } else {
+      d_subset_points->resize(queue, n_selected);
+    }
+    auto& subset_points = *d_subset_points;
+    grid_size = clue::divide_up_by(n_selected, block_size);
+    working_div = clue::make_workdiv<Acc1D>(grid_size, block_size);
+    alpaka::exec<Acc1D>(queue,
+                        working_div,
+                        KernelGatherPoints<Ndim>{},
+                        dev_points.view(),
+                        subset_points.view(),
+                        selected,
+                        n_selected);
+
+    setupSubsetTiles(queue, h_points, subset_points, n_selected, block_size);
+    if (n_selected <= fusedMaxPoints_) {
+      // the fused kernel resets the seeds and followers itself
+      run_fused(subset_points, kernel, queue, block_size, n_selected);
+    } else {
+      resetClusters(queue, n_selected, block_size);
+      d_tiles->fill(queue, subset_points, n_selected);
+      calculate_local_density(subset_points, kernel, queue, block_size, n_selected);
+      calculate_nearest_higher_and_classify(
+          subset_points, queue, block_size, n_selected);
+      assign_clusters(subset_points, queue, block_size);
+    }
+
+    alpaka::exec<Acc1D>(queue,
+                        working_div,
+                        KernelScatterResults{},
+                        subset_points.view(),
+                        dev_points.view(),
+                        selected,
+                        n_selected);
+    copy_results(h_points, dev_points, queue);
+  }
+
+  template <uint8_t Ndim>
+  template <typename KernelType>
+  void CLUEAlgoAlpaka<Ndim>::make_clusters(PointsSoA<Ndim>& h_points,
+                                           PointsAlpaka<Ndim>& dev_points,
+                                           const uint8_t* mask,
+                                           const KernelType& kernel,
+                                           Queue queue,
+                                           std::size_t block_size) {
+    const auto nPoints = h_points.nPoints();
+    if (nPoints == 0) {
+      lastRun_ = RunKind::subset;
+      return;
+    }
+    if (!d_selected.has_value() or alpaka::getExtentProduct(*d_selected) < nPoints) {
+      d_selected = clue::make_device_buffer<uint32_t[]>(queue, nPoints);
+      d_mask_positions = clue::make_device_buffer<uint32_t[]>(queue, nPoints);
+    }
+
+    // the position of each selected point in the subset is given by the inclusive
+    // scan of the flags, so the selected points keep their order
+    const Idx grid_size = clue::divide_up_by(nPoints, block_size);
+    const auto working_div = clue::make_workdiv<Acc1D>(grid_size, block_size);
+    alpaka::exec<Acc1D>(queue,
+                        working_div,
+                        KernelMaskToCounts{},
+                        mask,
+                        (*d_selected).data(),
+                        nPoints);
+    clue::inclusivePrefixScan<Acc1D>(
+        queue, (*d_selected).data(), (*d_mask_positions).data(), nPoints);
+
+    // the number of selected points is the last element of the scan
+    auto n_selected = clue::make_host_buffer<uint32_t[]>(queue, 1);
     alpaka::memcpy(queue,
-                   clue::make_host_view(h_points.clusterIndexes(), 2 * nPoints),
+                   n_selected,
+                   clue::make_device_view(alpaka::getDev(queue),
+                                          (*d_mask_positions).data() + nPoints - 1,
+                                          1));
+    alpaka::exec<Acc1D>(queue,
+                        working_div,
+                        KernelCompactMask{},
+                        mask,
+                        (*d_mask_positions).data(),
+                        (*d_selected).data(),
+                        nPoints);
+    alpaka::wait(queue);
+
+    make_clusters(h_points,
+                  dev_points,
+                  (*d_selected).data(),
+                  n_selected.data()[0],
+                  kernel,
+                  queue,
+                  block_size);
+  }
+
+  template <uint8_t Ndim>
+  template <typename KernelType>
+  void CLUEAlgoAlpaka<Ndim>::make_clusters(PointsSoA<Ndim>& h_points,
+                                           PointsAlpaka<Ndim>& dev_points,
+                                           const KernelType& kernel,
+                                           Queue queue,
+                                           std::size_t block_size,
+                                           clue::ResultCache& cache) {
+    const auto key = inputHash(h_points, kernel);
+    // the cluster indexes are followed by the seed flags in the results buffer
+    const auto results_size = 2 * static_cast<std::size_t>(h_points.nPoints());
+    if (cache.find(key, h_points.clusterIndexes(), results_size)) {
+      // the results weren't computed on the device
+      lastRun_ = RunKind::none;
+      return;
+    }
+
+    make_clusters(h_points, dev_points, kernel, queue, block_size);
+    cache.store(key, h_points.clusterIndexes(), results_size);
+  }
+
+  template <uint8_t Ndim>
+  template <typename KernelType>
+  uint64_t CLUEAlgoAlpaka<Ndim>::inputHash(const PointsSoA<Ndim>& h_points,
+                                           const KernelType& kernel) const {
+    // the weights follow the coordinates in the input buffer
+    auto key = clue::hash_bytes(h_points.coords(),
+                                (Ndim + 1) * h_points.nPoints() * sizeof(float));
+
+    // the toggles and the backend change the order of the floating point sums and of
+    // the seeds, so without the reproducible mode they can change the results
+    const float parameters[] = {dc_,
+                                rhoc_,
+                                dm_,
+                                static_cast<float>(pointsPerTile_),
+                                static_cast<float>(reproducible_),
+                                static_cast<float>(haloWrapping_),
+                                static_cast<float>(fusedMaxPoints_),
+                                static_cast<float>(tilePairs_),
+                                static_cast<float>(cacheNeighbours_)};
+    key = clue::hash_combine(key, clue::hash_bytes(parameters, sizeof(parameters)));
+    const auto backend = alpaka::getAccName<Acc1D>();
+    key = clue::hash_combine(key, clue::hash_bytes(backend.data(), backend.size()));
+    const auto wrapping = h_points.wrapped();
+    key = clue::hash_combine(key, clue::hash_bytes(wrapping.data(), Ndim));
+    static_assert(clue::HashedKernel<KernelType>,
+                  "The kernels of the cached and checkpointed runs must provide hash");
+    key = clue::hash_combine(key, kernel.hash());
+    return clue::hash_combine(key, Ndim);
+  }
+
+  template <uint8_t Ndim>
+  void CLUEAlgoAlpaka<Ndim>::save_checkpoint(const std::string& path,
+                                             clue::Stage stage,
+                                             uint64_t input_hash,
+                                             PointsAlpaka<Ndim>& dev_points,
+                                             Queue queue,
+                                             uint32_t n_points) {
+    // the checkpoint is written to a temporary file which then replaces the previous
+    // one, so that a valid checkpoint is always available if the run is interrupted
+    const auto tmp_path = clue::unique_tmp_path(path);
+    {
+      std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+      if (!out) {
+        throw std::runtime_error("Could not open the checkpoint file " +
+                                 tmp_path.string());
+      }
+      const auto header = clue::make_checkpoint_header(
+          Ndim, n_points, dc_, rhoc_, dm_, pointsPerTile_, input_hash, stage);
+      clue::write_array(out, &header, 1);
+      d_tiles->save(out, queue, n_points);
+      dev_points.save(out, queue, n_points);
+
+      if (stage >= clue::Stage::classification) {
+        auto h_seeds = clue::make_host_buffer<VecArray<int32_t, reserve>>(queue);
+        alpaka::memcpy(queue, h_seeds, *d_seeds);
+        alpaka::wait(queue);
+        const int32_t n_seeds = h_seeds->size();
+        clue::write_array(out, &n_seeds, 1);
+        clue::write_array(out, h_seeds->data(), n_seeds);
+      }
+      // the followers are only produced by the classification and read by the
+      // assignment
+      if (stage == clue::Stage::classification) {
+        clue::write_device_array(out, queue, m_followers, n_points);
+      }
+    }
+    std::filesystem::rename(tmp_path, path);
+  }
+
+  template <uint8_t Ndim>
+  clue::Stage CLUEAlgoAlpaka<Ndim>::load_checkpoint(const std::string& path,
+                                                    uint64_t input_hash,
+                                                    PointsAlpaka<Ndim>& dev_points,
+                                                    Queue queue,
+                                                    uint32_t n_points) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+      return clue::Stage::none;
+    }
+    const auto header = clue::read_checkpoint_header(in);
+    const auto expected = clue::make_checkpoint_header(
+        Ndim, n_points, dc_, rhoc_, dm_, pointsPerTile_, input_hash, clue::Stage::none);
+    // a checkpoint written for different points or parameters is ignored
+    if (!header.has_value() or !header->compatible(expected)) {
+      return clue::Stage::none;
+    }
+    // the device points and the followers, which have one list per point, must hold
+    // all the points of the checkpoint
+    if (dev_points.nStored() != static_cast<int>(n_points) or
+        (header->stage == clue::Stage::classification and n_points > reserve)) {
+      throw std::runtime_error("The points of the checkpoint don't fit in the buffers");
+    }
+
+    d_tiles->load(in, queue, n_points);
+    dev_points.load(in, queue, n_points);
+    if (header->stage >= clue::Stage::classification) {
+      auto h_seeds = clue::make_host_buffer<VecArray<int32_t, reserve>>(queue);
+      int32_t n_seeds;
+      clue::read_array(in, &n_seeds, 1);
+      if (n_seeds < 0 or n_seeds > reserve) {
+        throw std::runtime_error("The checkpoint is truncated or corrupted");
+      }
+      h_seeds->resize(n_seeds);
+      clue::read_array(in, h_seeds->data(), n_seeds);
+      alpaka::memcpy(queue, *d_seeds, h_seeds);
+    }
+    if (header->stage == clue::Stage::classification) {
+      clue::read_device_array(in, queue, m_followers, n_points);
+    }
+    return header->stage;
+  }
+
+  template <uint8_t Ndim>
+  template <typename KernelType>
+  void CLUEAlgoAlpaka<Ndim>::run_stages(clue::Stage last_stage,
+                                        PointsSoA<Ndim>& h_points,
+                                        PointsAlpaka<Ndim>& dev_points,
+                                        const KernelType& kernel,
+                                        Queue queue,
+                                        std::size_t block_size) {
+    using clue::Stage;
+    if (last_stage == Stage::none) {
+      return;
+    }
+    if (last_stage == Stage::assignment) {
+      make_clusters(h_points, dev_points, kernel, queue, block_size);
+      return;
+    }
+    lastRun_ = RunKind::partial;
+
+    const auto nPoints = h_points.nPoints();
+    setupTiles(queue, h_points);
+    copyPoints(h_points, dev_points, queue, block_size);
+    d_tiles->fill(queue, dev_points, nPoints);
+    if (last_stage >= Stage::density) {
+      // the neighbours are only cached when they are reused by the following stage
+      const bool cache_neighbours{cacheNeighbours_};
+      cacheNeighbours_ = cacheNeighbours_ and last_stage >= Stage::nearest_higher;
+      calculate_local_density(dev_points, kernel, queue, block_size, nPoints);
+      cacheNeighbours_ = cache_neighbours;
+    }
+    if (last_stage >= Stage::nearest_higher) {
+      calculate_nearest_higher(dev_points, queue, block_size, nPoints);
+    }
+    if (last_stage >= Stage::classification) {
+      const Idx grid_size = clue::divide_up_by(nPoints, block_size);
+      const auto working_div = clue::make_workdiv<Acc1D>(grid_size, block_size);
+      alpaka::exec<Acc1D>(queue,
+                          working_div,
+                          KernelClassifyPoints{},
+                          dev_points.view(),
+                          dm_,
+                          dc_,
+                          rhoc_,
+                          nPoints);
+      copy_results(h_points, dev_points, queue);
+    }
+    alpaka::wait(queue);
+  }
+
+  template <uint8_t Ndim>
+  void CLUEAlgoAlpaka<Ndim>::resume_nearest_higher(std::span<const float> rho,
+                                                   PointsAlpaka<Ndim>& dev_points,
+                                                   Queue queue,
+                                                   std::size_t block_size) {
+    const auto nPoints = static_cast<uint32_t>(dev_points.nPoints());
+    if (rho.size() != nPoints) {
+      throw std::invalid_argument("The number of densities must match the points");
+    }
+    // the assignment is left to the caller
+    lastRun_ = RunKind::partial;
+    alpaka::memcpy(
+        queue,
+        clue::make_device_view(alpaka::getDev(queue), dev_points.rho(), nPoints),
+        clue::make_host_view(rho.data(), nPoints));
+    calculate_nearest_higher(dev_points, queue, block_size, nPoints);
+    alpaka::wait(queue);
+  }
+
+  template <uint8_t Ndim>
+  template <typename KernelType>
+  clue::ClusterHierarchy CLUEAlgoAlpaka<Ndim>::make_cluster_hierarchy(
+      PointsSoA<Ndim>& h_points,
+      PointsAlpaka<Ndim>& dev_points,
+      std::span<const float> radii,
+      const KernelType& kernel,
+      Queue queue,
+      std::size_t block_size) {
+    const auto n_scales = static_cast<int32_t>(radii.size());
+    if (n_scales == 0 or n_scales > max_scales) {
+      throw std::invalid_argument("The number of scales must be between 1 and " +
+                                  std::to_string(max_scales));
+    }
+    if (!std::ranges::is_sorted(radii)) {
+      throw std::invalid_argument("The radii of the scales must be in ascending order");
+    }
+    // the outlier distance of each scale is scaled with dm / dc
+    if (dc_ <= 0.f) {
+      throw std::invalid_argument("The critical distance must be positive");
+    }
+    // the points on the device keep the clusters of the coarsest scale
+    lastRun_ = RunKind::hierarchy;
+
+    const auto nPoints = h_points.nPoints();
+    setupTiles(queue, h_points);
+    copyPoints(h_points, dev_points, queue, block_size);
+    d_tiles->fill(queue, dev_points, nPoints);
+
+    ScaleRadii scale_radii{};
+    scale_radii.n_scales = n_scales;
+    for (int32_t scale{}; scale != n_scales; ++scale) {
+      scale_radii.dc_sq[scale] = radii[scale] * radii[scale];
+    }
+    auto rho_scales = clue::make_device_buffer<float[]>(queue, n_scales * nPoints);
+    const Idx grid_size = clue::divide_up_by(nPoints, block_size);
+    const auto working_div = clue::make_workdiv<Acc1D>(grid_size, block_size);
+    auto launch = [&](auto accumulator) {
+      alpaka::exec<Acc1D>(queue,
+                          working_div,
+                          KernelCalculateMultiScaleDensity{},
+                          m_tiles,
+                          dev_points.view(),
+                          kernel,
+                          scale_radii,
+                          rho_scales.data(),
+                          nPoints,
+                          accumulator);
+    };
+    if (reproducible_) {
+      launch(FixedPointAccumulator{fixed_point_scale});
+    } else {
+      launch(FloatAccumulator{});
+    }
+
+    clue::ClusterHierarchy hierarchy;
+    hierarchy.radii.assign(radii.begin(), radii.end());
+    const auto device = alpaka::getDev(queue);
+    m_neighbourCache.reset();
+    m_tileInteractions.reset();
+    for (int32_t scale{}; scale != n_scales; ++scale) {
+      const float dc{radii[scale]};
+      const float dm{radii[scale] * dm_ / dc_};
+      alpaka::memcpy(
+          queue,
+          clue::make_device_view(device, dev_points.rho(), nPoints),
+          clue::make_device_view(device, rho_scales.data() + scale * nPoints, nPoints));
+      resetClusters(queue, nPoints, block_size);
+      calculate_nearest_higher_and_classify(
+          dev_points, queue, block_size, nPoints, dc, dm);
+      assign_clusters(dev_points, queue, block_size);
+      copy_results(h_points, dev_points, queue);
+
+      hierarchy.cluster_indexes.emplace_back(h_points.clusterIndexes(),
+                                             h_points.clusterIndexes() + nPoints);
+      hierarchy.is_seed.emplace_back(h_points.isSeed(), h_points.isSeed() + nPoints);
+    }
+
+    for (int32_t scale{}; scale < n_scales - 1; ++scale) {
+      hierarchy.parents.push_back(clue::compute_parents(
+          hierarchy.cluster_indexes[scale], hierarchy.cluster_indexes[scale + 1]));
+    }
+    std::copy(hierarchy.cluster_indexes[0].begin(),
+              hierarchy.cluster_indexes[0].end(),
+              h_points.clusterIndexes());
+    std::copy(
+        hierarchy.is_seed[0].begin(), hierarchy.is_seed[0].end(), h_points.isSeed());
+    return hierarchy;
+  }
+
+  template <uint8_t Ndim>
+  clue::ClusterGraph CLUEAlgoAlpaka<Ndim>::make_cluster_graph(
+      const PointsSoA<Ndim>& h_points,
+      PointsAlpaka<Ndim>& dev_points,
+      float distance,
+      Queue queue,
+      std::size_t block_size) {
+    if (!d_tiles.has_value()) {
+      throw std::logic_error("The cluster graph requires the tiles of a clustering");
+    }
+    if (lastRun_ != RunKind::points) {
+      throw std::logic_error(
+          "The cluster graph requires a complete clustering of all the points");
+    }
+    const auto nPoints = h_points.nPoints();
+    const auto n_clusters = static_cast<uint32_t>(
+        nPoints == 0 ? 0
+                     : clue::compute_nclusters(
+                           std::span<const int>{h_points.clusterIndexes(), nPoints}));
+    clue::ClusterGraph graph;
+    graph.offsets.assign(n_clusters + 1, 0u);
+    if (n_clusters == 0) {
+      return graph;
+    }
+
+    // list the clusters touched by each point
+    auto counts = clue::make_device_buffer<uint32_t[]>(queue, nPoints);
+    auto positions = clue::make_device_buffer<uint32_t[]>(queue, nPoints);
+    const Idx grid_size = clue::divide_up_by(nPoints, block_size);
+    const auto working_div = clue::make_workdiv<Acc1D>(grid_size, block_size);
+    alpaka::exec<Acc1D>(queue,
+                        working_div,
+                        KernelCountContacts<Ndim>{},
+                        m_tiles,
+                        dev_points.view(),
+                        counts.data(),
+                        distance,
+                        nPoints);
+    clue::inclusivePrefixScan<Acc1D>(queue, counts.data(), positions.data(), nPoints);
+
+    const auto device = alpaka::getDev(queue);
+    auto total = clue::make_host_buffer<uint32_t[]>(queue, 1);
+    alpaka::memcpy(
+        queue, total, clue::make_device_view(device, positions.data() + nPoints - 1, 1));
+    alpaka::wait(queue);
+    const auto n_contacts = total.data()[0];
+    if (n_contacts == 0) {
+      return graph;
+    }
+    auto contact_clusters = clue::make_device_buffer<int32_t[]>(queue, n_contacts);
+    auto contact_neighbours = clue::make_device_buffer<int32_t[]>(queue, n_contacts);
+    auto contact_points = clue::make_device_buffer<uint32_t[]>(queue, n_contacts);
+    auto contact_distances = clue::make_device_buffer<float[]>(queue, n_contacts);
+    auto contact_weights = clue::make_device_buffer<float[]>(queue, n_contacts);
+    const ClusterContacts contacts{contact_clusters.data(),
+                                   contact_neighbours.data(),
+                                   contact_points.data(),
+                                   contact_distances.data(),
+                                   contact_weights.data()};
+    alpaka::exec<Acc1D>(queue,
+                        working_div,
+                        KernelFillContacts<Ndim>{},
+                        m_tiles,
+                        dev_points.view(),
+                        counts.data(),
+                        positions.data(),
+                        contacts,
+                        distance,
+                        nPoints);
+
+    // group the contacts by cluster, giving the offsets of the clusters, and sort them
+    // by cluster and neighbour, so that the ones with the same neighbour are merged
+    clue::AssociationMap<Device> cluster_contacts(n_contacts, n_clusters, queue);
+    cluster_contacts.template fill<Acc1D>(
+        n_contacts, GetContactCluster{contact_clusters.data()}, queue);
+    clue::bitonicSort<Acc1D>(queue,
+                             cluster_contacts.indexes().data(),
+                             n_contacts,
+                             ContactOrder{contacts},
+                             static_cast<uint32_t>(block_size));
+    auto edge_counts = clue::make_device_buffer<uint32_t[]>(queue, n_clusters);
+    auto edge_positions = clue::make_device_buffer<uint32_t[]>(queue, n_clusters);
+    alpaka::memset(queue, edge_counts, 0);
+    alpaka::exec<Acc1D>(
+        queue,
+        clue::make_workdiv<Acc1D>(clue::divide_up_by(n_contacts, block_size), block_size),
+        KernelCountClusterEdges{},
+        cluster_contacts.indexes().data(),
+        contacts,
+        edge_counts.data(),
+        n_contacts);
+    clue::inclusivePrefixScan<Acc1D>(
+        queue, edge_counts.data(), edge_positions.data(), n_clusters);
+
+    alpaka::memcpy(
+        queue,
+        total,
+        clue::make_device_view(device, edge_positions.data() + n_clusters - 1, 1));
+    alpaka::wait(queue);
+    const auto n_edges = total.data()[0];
+    auto edge_offsets = clue::make_device_buffer<uint32_t[]>(queue, n_clusters + 1);
+    auto edge_neighbours = clue::make_device_buffer<int32_t[]>(queue, n_edges);
+    auto edge_distances = clue::make_device_buffer<float[]>(queue, n_edges);
+    auto edge_weights = clue::make_device_buffer<float[]>(queue, n_edges);
+    const Idx cluster_grid_size = clue::divide_up_by(n_clusters, block_size);
+    alpaka::exec<Acc1D>(queue,
+                        clue::make_workdiv<Acc1D>(cluster_grid_size, block_size),
+                        KernelFillClusterEdges{},
+                        cluster_contacts.offsets().data(),
+                        cluster_contacts.indexes().data(),
+                        contacts,
+                        edge_counts.data(),
+                        edge_positions.data(),
+                        edge_offsets.data(),
+                        edge_neighbours.data(),
+                        edge_distances.data(),
+                        edge_weights.data(),
+                        n_clusters);
+
+    graph.neighbours.resize(n_edges);
+    graph.min_distances.resize(n_edges);
+    graph.boundary_weights.resize(n_edges);
+    alpaka::memcpy(queue,
+                   clue::make_host_view(graph.offsets.data(), n_clusters + 1),
+                   edge_offsets);
+    alpaka::memcpy(
+        queue, clue::make_host_view(graph.neighbours.data(), n_edges), edge_neighbours);
+    alpaka::memcpy(
+        queue, clue::make_host_view(graph.min_distances.data(), n_edges), edge_distances);
+    alpaka::memcpy(queue,
+                   clue::make_host_view(graph.boundary_weights.data(), n_edges),
+                   edge_weights);
+    alpaka::wait(queue);
+    return graph;
+  }
+
+  template <uint8_t Ndim>
+  template <typename TReduction>
+  std::vector<typename TReduction::value_type> CLUEAlgoAlpaka<Ndim>::reduce_clusters(
+      const PointsSoA<Ndim>& h_points,
+      PointsAlpaka<Ndim>& dev_points,
+      const TReduction& reduction,
+      Queue queue,
+      std::size_t block_size) {
+    if (lastRun_ != RunKind::points) {
+      throw std::logic_error(
+          "The reduction requires a complete clustering of all the points");
+    }
+    using value_type = typename TReduction::value_type;
+    const auto nPoints = h_points.nPoints();
+    const auto n_clusters = static_cast<uint32_t>(
+        nPoints == 0 ? 0
+                     : clue::compute_nclusters(
+                           std::span<const int>{h_points.clusterIndexes(), nPoints}));
+    std::vector<value_type> values(n_clusters);
+    if (n_clusters == 0) {
+      return values;
+    }
+
+    // sort the points by cluster, leaving the outliers in the last bin
+    clue::AssociationMap<Device> cluster_points(nPoints, n_clusters + 1, queue);
+    cluster_points.template fill<Acc1D>(
+        nPoints, GetClusterBin{dev_points.clusterIndexes(), n_clusters}, queue);
+
+    // split the clusters in chunks, which are numbered by the scan of their number
+    const Idx grid_size = clue::divide_up_by(n_clusters, block_size);
+    const auto working_div = clue::make_workdiv<Acc1D>(grid_size, block_size);
+    auto d_chunks = clue::make_device_buffer<uint32_t[]>(queue, n_clusters);
+    auto d_chunk_offsets = clue::make_device_buffer<uint32_t[]>(queue, n_clusters);
+    alpaka::exec<Acc1D>(queue,
+                        working_div,
+                        KernelCountReductionChunks{},
+                        cluster_points.offsets().data(),
+                        d_chunks.data(),
+                        n_clusters);
+    clue::inclusivePrefixScan<Acc1D>(
+        queue, d_chunks.data(), d_chunk_offsets.data(), n_clusters);
+    auto n_chunks = clue::make_host_buffer<uint32_t[]>(queue, 1);
+    alpaka::memcpy(queue,
+                   n_chunks,
+                   clue::make_device_view(alpaka::getDev(queue),
+                                          d_chunk_offsets.data() + n_clusters - 1,
+                                          1));
+    alpaka::wait(queue);
+
+    auto d_chunk_values =
+        clue::make_device_buffer<value_type[]>(queue, n_chunks.data()[0]);
+    alpaka::exec<Acc1D>(
+        queue,
+        clue::make_workdiv<Acc1D>(n_chunks.data()[0], reduction_chunk_size),
+        KernelReduceClusterChunks<Ndim>{},
+        dev_points.view(),
+        cluster_points.offsets().data(),
+        cluster_points.indexes().data(),
+        d_chunk_offsets.data(),
+        reduction,
+        d_chunk_values.data(),
+        n_clusters);
+    auto d_values = clue::make_device_buffer<value_type[]>(queue, n_clusters);
+    alpaka::exec<Acc1D>(queue,
+                        working_div,
+                        KernelCombineClusterChunks<TReduction>{},
+                        d_chunk_offsets.data(),
+                        reduction,
+                        d_chunk_values.data(),
+                        d_values.data(),
+                        n_clusters);
+    alpaka::memcpy(queue, clue::make_host_view(values.data(), n_clusters), d_values);
+    alpaka::wait(queue);
+    return values;
+  }
+
+  template <uint8_t Ndim>
+  std::vector<float> CLUEAlgoAlpaka<Ndim>::getDensity(PointsAlpaka<Ndim>& dev_points,
+                                                      Queue queue) const {
+    std::vector<float> rho(dev_points.nPoints());
+    alpaka::memcpy(queue,
+                   clue::make_host_view(rho.data(), rho.size()),
+                   clue::make_device_view(
+                       alpaka::getDev(queue), dev_points.rho(), rho.size()));
+    alpaka::wait(queue);
+    return rho;
+  }
+
+  template <uint8_t Ndim>
+  std::vector<float> CLUEAlgoAlpaka<Ndim>::getDelta(PointsAlpaka<Ndim>& dev_points,
+                                                    Queue queue) const {
+    std::vector<float> delta(dev_points.nPoints());
+    alpaka::memcpy(queue,
+                   clue::make_host_view(delta.data(), delta.size()),
                    clue::make_device_view(
-                       device, dev_points.result_buffer.data() + nPoints, 2 * nPoints),
-                   2 * nPoints);
+                       alpaka::getDev(queue), dev_points.delta(), delta.size()));
+    alpaka::wait(queue);
+    return delta;
+  }
+
+  template <uint8_t Ndim>
+  std::vector<int> CLUEAlgoAlpaka<Ndim>::getNearestHigher(
+      PointsAlpaka<Ndim>& dev_points, Queue queue) const {
+    std::vector<int> nearest_higher(dev_points.nPoints());
+    alpaka::memcpy(queue,
+                   clue::make_host_view(nearest_higher.data(), nearest_higher.size()),
+                   clue::make_device_view(alpaka::getDev(queue),
+                                          dev_points.nearestHigher(),
+                                          nearest_higher.size()));
     alpaka::wait(queue);
+    return nearest_higher;
   }
 
   template <uint8_t Ndim>
@@ -0,0 +1,534 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <alpaka/mem/view/Traits.hpp>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "AlpakaCore/bitonicSort.hpp"
+#include "DataFormats/alpaka/PointsAlpaka.hpp"
+#include "DataFormats/alpaka/TilesAlpaka.hpp"
+#include "CLUE/CLUEAlpakaKernels.hpp"
+#include "CLUE/CLUEAlpakaKernelsDynamic.hpp"
+#include "CLUE/CLUEAlpakaKernelsSubset.hpp"
+#include "CLUE/ConvolutionalKernel.hpp"
+#include "CLUE/LSH.hpp"
+#include "CLUE/Projection.hpp"
+
+using clue::VecArray;
+
+namespace ALPAKA_ACCELERATOR_NAMESPACE_CLUE {
+
+  // Version of the algorithm where the number of dimensions of the points is only
+  // known at runtime. The points are tiled on their first TileDim coordinates, and the
+  // distances are computed over all the dimensions, so the same neighbours are found
+  // as by CLUEAlgoAlpaka<Ndim> for non-periodic coordinates. The results can only
+  // differ by the rounding of the densities, whose terms are summed in another order.
+  // The host buffers have the same layout used by PointsSoA, i.e. the coordinates
+  // followed by the weights for the floats and the cluster indexes followed by the
+  // seed flags for the integers. The number of dimensions of the points must be at
+  // least TileDim, and none of the coordinates can be periodic.
+  // Optionally, the points can be tiled on their projection on TileDim orthonormal
+  // directions, either random or the principal components of the data, which are
+  // computed on the device before the tiles are filled. The projection is computed in
+  // single precision, so a neighbour within a few ulps of the radius can be missed.
+  // For points with many dimensions, the tiles can also be replaced by an approximate
+  // neighbour search based on locality-sensitive hashing.
+  template <uint8_t TileDim>
+  class CLUEAlgoAlpakaDynamic {
+  public:
+    explicit CLUEAlgoAlpakaDynamic(float dc, float rhoc, float dm, int pPBin)
+        : dc_{dc}, rhoc_{rhoc}, dm_{dm}, pointsPerTile_{pPBin} {}
+
+    TilesAlpakaView<TileDim>* m_tiles;
+    // the seeds and the followers are allocated by the first run
+    VecArray<int32_t, reserve>* m_seeds{nullptr};
+    VecArray<int32_t, max_followers>* m_followers{nullptr};
+
+    // Throws std::invalid_argument if any of the coordinates is flagged as periodic
+    // in wrapping
+    template <typename KernelType>
+    void make_clusters(const float* h_coords,
+                       int* h_results,
+                       int32_t ndim,
+                       uint32_t n_points,
+                       const KernelType& kernel,
+                       Queue queue,
+                       std::size_t block_size,
+                       std::span<const uint8_t> wrapping = {});
+
+    // Choose the coordinates used for tiling the points. With Projection::none the
+    // leading TileDim coordinates are used.
+    void setProjection(clue::Projection projection, uint32_t seed = 0) {
+      projection_ = projection;
+      projectionSeed_ = seed;
+    }
+
+    // Search the neighbours with locality-sensitive hashing instead of the tiles. The
+    // results are approximate, because some neighbours can be missed.
+    void useLSH(const clue::LSHParameters& params) { lsh_ = params; }
+
+    // When enabled, the results don't depend on the order in which the points are
+    // visited, as for CLUEAlgoAlpaka::reproducibleResults. This applies to the
+    // densities found both with the tiles and with locality-sensitive hashing.
+    void reproducibleResults(bool enable) { reproducible_ = enable; }
+
+  private:
+    float dc_;
+    float rhoc_;
+    float dm_;
+    // average number of points found in a tile
+    int pointsPerTile_;
+    clue::Projection projection_{clue::Projection::none};
+    uint32_t projectionSeed_{0};
+    std::optional<clue::LSHParameters> lsh_;
+    bool reproducible_{false};
+
+    // internal buffers
+    std::optional<TilesAlpaka<TileDim>> d_tiles;
+    std::optional<clue::device_buffer<Device, VecArray<int32_t, reserve>>> d_seeds;
+    std::optional<clue::device_buffer<Device, clue::VecArray<int32_t, max_followers>[]>>
+        d_followers;
+    std::optional<PointsAlpakaDynamic> d_points;
+    std::optional<clue::device_buffer<Device, float[]>> d_projected_coords;
+    std::optional<clue::AssociationMap<Device>> d_lsh_tables;
+    std::optional<clue::device_buffer<Device, uint32_t[]>> d_lsh_buckets;
+
+    void setupClusters(Queue queue);
+    void sort_seeds(Queue queue);
+
+    void setupTiles(Queue queue,
+                    const float* tiling_coords,
+                    uint32_t n_points,
+                    std::size_t block_size);
+    void setupPoints(const float* h_coords,
+                     int32_t ndim,
+                     uint32_t n_points,
+                     Queue queue,
+                     std::size_t block_size);
+    std::vector<float> principalComponents(Queue queue,
+                                           int32_t ndim,
+                                           uint32_t n_points,
+                                           std::size_t block_size);
+    const float* projectPoints(Queue queue,
+                               int32_t ndim,
+                               uint32_t n_points,
+                               std::size_t block_size);
+
+    // compute the density and the nearest-higher of the points
+    template <typename KernelType>
+    void searchTiles(int32_t ndim,
+                     uint32_t n_points,
+                     const KernelType& kernel,
+                     Queue queue,
+                     std::size_t block_size);
+    template <typename KernelType>
+    void searchLSH(int32_t ndim,
+                   uint32_t n_points,
+                   const KernelType& kernel,
+                   Queue queue,
+                   std::size_t block_size);
+  };
+
+  template <uint8_t TileDim>
+  void CLUEAlgoAlpakaDynamic<TileDim>::setupClusters(Queue queue) {
+    if (d_seeds.has_value()) {
+      return;
+    }
+    d_seeds = clue::make_device_buffer<VecArray<int32_t, reserve>>(queue);
+    d_followers =
+        clue::make_device_buffer<VecArray<int32_t, max_followers>[]>(queue, reserve);
+
+    m_seeds = (*d_seeds).data();
+    m_followers = (*d_followers).data();
+  }
+
+  template <uint8_t TileDim>
+  void CLUEAlgoAlpakaDynamic<TileDim>::sort_seeds(Queue queue) {
+    // the seeds are pushed with atomics, so their order changes between runs. Only
+    // their number is copied to the host, and the used entries are sorted on the device
+    int32_t n_seeds;
+    alpaka::memcpy(queue,
+                   clue::make_host_view(&n_seeds, 1),
+                   clue::make_device_view(alpaka::getDev(queue), &m_seeds->m_size, 1));
+    alpaka::wait(queue);
+    clue::bitonicSort<Acc1D>(
+        queue, m_seeds->m_data, static_cast<uint32_t>(n_seeds), clue::Ascending{});
+  }
+
+  template <uint8_t TileDim>
+  void CLUEAlgoAlpakaDynamic<TileDim>::setupTiles(Queue queue,
+                                                  const float* tiling_coords,
+                                                  uint32_t n_points,
+                                                  std::size_t block_size) {
+    auto nTiles =
+        static_cast<int32_t>(std::ceil(n_points / static_cast<float>(pointsPerTile_)));
+    const auto nPerDim = static_cast<int32_t>(std::ceil(std::pow(nTiles, 1. / TileDim)));
+    nTiles = static_cast<int32_t>(std::pow(nPerDim, TileDim));
+
+    if (!d_tiles.has_value()) {
+      d_tiles = std::make_optional<TilesAlpaka<TileDim>>(queue, n_points, nTiles);
+      m_tiles = d_tiles->view();
+    }
+    // check if tiles are large enough for current data
+    if (!(alpaka::trait::GetExtents<clue::device_buffer<Device, uint32_t[]>>{}(
+              d_tiles->indexes())[0u] >= n_points) or
+        !(alpaka::trait::GetExtents<clue::device_buffer<Device, uint32_t[]>>{}(
+              d_tiles->offsets())[0u] > nTiles)) {
+      d_tiles->initialize(n_points, nTiles, nPerDim, queue);
+    } else {
+      d_tiles->reset(n_points, nTiles, nPerDim, queue);
+    }
+
+    // the tiles only cover the TileDim tiling coordinates, whose extremes are computed
+    // on the device
+    auto min_max = clue::make_host_buffer<CoordinateExtremes<TileDim>>(queue);
+    for (size_t dim{}; dim != TileDim; ++dim) {
+      min_max->min(dim) = std::numeric_limits<float>::max();
+      min_max->max(dim) = std::numeric_limits<float>::lowest();
+    }
+    alpaka::memcpy(queue, d_tiles->minMax(), min_max);
+    const Idx grid_size = clue::divide_up_by(n_points, block_size);
+    alpaka::exec<Acc1D>(queue,
+                        clue::make_workdiv<Acc1D>(grid_size, block_size),
+                        KernelCalculateTilingExtremes<TileDim>{},
+                        tiling_coords,
+                        d_tiles->minMax().data(),
+                        n_points);
+    alpaka::exec<Acc1D>(queue,
+                        clue::make_workdiv<Acc1D>(1, TileDim),
+                        KernelCalculateTileSizes<TileDim>{},
+                        d_tiles->minMax().data(),
+                        d_tiles->tileSize().data(),
+                        nPerDim);
+
+    // the periodic coordinates are rejected by make_clusters
+    std::array<uint8_t, TileDim> wrapping{};
+    alpaka::memcpy(
+        queue, d_tiles->wrapped(), clue::make_host_view(wrapping.data(), TileDim));
+    alpaka::wait(queue);
+  }
+
+  template <uint8_t TileDim>
+  void CLUEAlgoAlpakaDynamic<TileDim>::setupPoints(const float* h_coords,
+                                                   int32_t ndim,
+                                                   uint32_t n_points,
+                                                   Queue queue,
+                                                   std::size_t block_size) {
+    if (!d_points.has_value() or d_points->nDim() != ndim or
+        alpaka::trait::GetExtents<clue::device_buffer<Device, int[]>>{}(
+            d_points->result_buffer)[0u] != 3 * n_points) {
+      d_points = std::make_optional<PointsAlpakaDynamic>(queue, n_points, ndim);
+    }
+
+    const auto copyExtent = (ndim + 1) * n_points;
+    alpaka::memcpy(queue,
+                   d_points->input_buffer,
+                   clue::make_host_view(h_coords, copyExtent),
+                   copyExtent);
+
+    setupClusters(queue);
+    alpaka::memset(queue, *d_seeds, 0x00);
+    const Idx grid_size = clue::divide_up_by(n_points, block_size);
+    const auto working_div = clue::make_workdiv<Acc1D>(grid_size, block_size);
+    alpaka::exec<Acc1D>(
+        queue, working_div, KernelResetFollowers{}, m_followers, n_points);
+  }
+
+  template <uint8_t TileDim>
+  std::vector<float> CLUEAlgoAlpakaDynamic<TileDim>::principalComponents(
+      Queue queue, int32_t ndim, uint32_t n_points, std::size_t block_size) {
+    auto& dev_points = *d_points;
+    const auto n_chunks = std::min(
+        clue::pca_max_chunks,
+        static_cast<uint32_t>(clue::divide_up_by(n_points, clue::pca_chunk_points)));
+    const auto n_means = static_cast<uint32_t>(ndim);
+    const auto n_covariances = static_cast<uint32_t>(ndim * (ndim + 1) / 2);
+    auto d_partial_sums =
+        clue::make_device_buffer<double[]>(queue, n_chunks * n_covariances);
+    auto d_means = clue::make_device_buffer<double[]>(queue, n_means);
+    auto d_covariance = clue::make_device_buffer<double[]>(queue, n_covariances);
+
+    const Idx grid_size_means = clue::divide_up_by(n_chunks * n_means, block_size);
+    alpaka::exec<Acc1D>(queue,
+                        clue::make_workdiv<Acc1D>(grid_size_means, block_size),
+                        KernelChunkSums{},
+                        dev_points.view(),
+                        d_partial_sums.data(),
+                        ndim,
+                        n_chunks);
+    alpaka::exec<Acc1D>(queue,
+                        clue::make_workdiv<Acc1D>(clue::divide_up_by(n_means, block_size),
+                                                  block_size),
+                        KernelCombineChunks{},
+                        d_partial_sums.data(),
+                        d_means.data(),
+                        1. / n_points,
+                        n_means,
+                        n_chunks);
+    const Idx grid_size_covariance =
+        clue::divide_up_by(n_chunks * n_covariances, block_size);
+    alpaka::exec<Acc1D>(queue,
+                        clue::make_workdiv<Acc1D>(grid_size_covariance, block_size),
+                        KernelChunkCovariance{},
+                        dev_points.view(),
+                        d_means.data(),
+                        d_partial_sums.data(),
+                        ndim,
+                        n_chunks);
+    alpaka::exec<Acc1D>(
+        queue,
+        clue::make_workdiv<Acc1D>(clue::divide_up_by(n_covariances, block_size),
+                                  block_size),
+        KernelCombineChunks{},
+        d_partial_sums.data(),
+        d_covariance.data(),
+        1. / n_points,
+        n_covariances,
+        n_chunks);
+
+    // the eigenvectors of the small covariance matrix are computed on the host
+    std::vector<double> upper_triangle(n_covariances);
+    alpaka::memcpy(queue,
+                   clue::make_host_view(upper_triangle.data(), n_covariances),
+                   d_covariance);
+    alpaka::wait(queue);
+    std::vector<double> covariance(ndim * ndim);
+    for (int32_t a{}, index{}; a != ndim; ++a) {
+      for (int32_t b{a}; b != ndim; ++b, ++index) {
+        covariance[a * ndim + b] = upper_triangle[index];
+        covariance[b * ndim + a] = upper_triangle[index];
+      }
+    }
+    return clue::principalComponentsBasis(covariance, ndim, TileDim);
+  }
+
+  template <uint8_t TileDim>
+  const float* CLUEAlgoAlpakaDynamic<TileDim>::projectPoints(Queue queue,
+                                                             int32_t ndim,
+                                                             uint32_t n_points,
+                                                             std::size_t block_size) {
+    auto& dev_points = *d_points;
+
+    const auto basis = projection_ == clue::Projection::pca
+                           ? principalComponents(queue, ndim, n_points, block_size)
+                           : clue::randomProjectionBasis(ndim, TileDim, projectionSeed_);
+
+    if (!d_projected_coords.has_value() or
+        alpaka::trait::GetExtents<clue::device_buffer<Device, float[]>>{}(
+            *d_projected_coords)[0u] < TileDim * n_points) {
+      d_projected_coords = clue::make_device_buffer<float[]>(queue, TileDim * n_points);
+    }
+    auto d_basis = clue::make_device_buffer<float[]>(queue, TileDim * ndim);
+    alpaka::memcpy(queue, d_basis, clue::make_host_view(basis.data(), TileDim * ndim));
+
+    const Idx grid_size = clue::divide_up_by(n_points, block_size);
+    alpaka::exec<Acc1D>(queue,
+                        clue::make_workdiv<Acc1D>(grid_size, block_size),
+                        KernelProjectPoints{},
+                        dev_points.view(),
+                        d_basis.data(),
+                        (*d_projected_coords).data(),
+                        ndim,
+                        static_cast<int32_t>(TileDim));
+    // the basis is released at the end of the scope
+    alpaka::wait(queue);
+
+    return (*d_projected_coords).data();
+  }
+
+  template <uint8_t TileDim>
+  template <typename KernelType>
+  void CLUEAlgoAlpakaDynamic<TileDim>::searchTiles(int32_t ndim,
+                                                   uint32_t n_points,
+                                                   const KernelType& kernel,
+                                                   Queue queue,
+                                                   std::size_t block_size) {
+    auto& dev_points = *d_points;
+
+    const float* tiling_coords = dev_points.input_buffer.data();
+    if (projection_ != clue::Projection::none) {
+      tiling_coords = projectPoints(queue, ndim, n_points, block_size);
+    }
+    setupTiles(queue, tiling_coords, n_points, block_size);
+    d_tiles->fill(queue, tiling_coords, n_points);
+
+    const Idx grid_size = clue::divide_up_by(n_points, block_size);
+    auto working_div = clue::make_workdiv<Acc1D>(grid_size, block_size);
+    auto launch_density = [&](auto accumulator) {
+      alpaka::exec<Acc1D>(queue,
+                          working_div,
+                          KernelCalculateLocalDensityDynamic{},
+                          m_tiles,
+                          dev_points.view(),
+                          tiling_coords,
+                          kernel,
+                          dc_,
+                          ndim,
+                          n_points,
+                          accumulator);
+    };
+    if (reproducible_) {
+      launch_density(FixedPointAccumulator{fixed_point_scale});
+    } else {
+      launch_density(FloatAccumulator{});
+    }
+    alpaka::exec<Acc1D>(queue,
+                        working_div,
+                        KernelCalculateNearestHigherDynamic{},
+                        m_tiles,
+                        dev_points.view(),
+                        tiling_coords,
+                        dm_,
+                        ndim,
+                        n_points);
+  }
+
+  template <uint8_t TileDim>
+  template <typename KernelType>
+  void CLUEAlgoAlpakaDynamic<TileDim>::searchLSH(int32_t ndim,
+                                                 uint32_t n_points,
+                                                 const KernelType& kernel,
+                                                 Queue queue,
+                                                 std::size_t block_size) {
+    auto& dev_points = *d_points;
+    const auto& params = *lsh_;
+    const auto bucket_width = params.bucket_width > 0.f ? params.bucket_width
+                                                        : 4.f * std::max(dc_, dm_);
+    // on average each bucket contains a single point in each table
+    const auto n_buckets = n_points;
+    const auto n_elements = params.n_tables * n_points;
+
+    const auto functions = clue::generateLSHFunctions(params, ndim, bucket_width);
+    auto d_functions = clue::make_device_buffer<float[]>(queue, functions.size());
+    alpaka::memcpy(
+        queue, d_functions, clue::make_host_view(functions.data(), functions.size()));
+
+    if (!d_lsh_buckets.has_value() or
+        alpaka::trait::GetExtents<clue::device_buffer<Device, uint32_t[]>>{}(
+            *d_lsh_buckets)[0u] != n_elements) {
+      d_lsh_buckets = clue::make_device_buffer<uint32_t[]>(queue, n_elements);
+      d_lsh_tables = std::make_optional<clue::AssociationMap<Device>>(
+          n_elements, params.n_tables * n_buckets, queue);
+    }
+
+    const Idx grid_size = clue::divide_up_by(n_points, block_size);
+    auto working_div = clue::make_workdiv<Acc1D>(grid_size, block_size);
+    alpaka::exec<Acc1D>(queue,
+                        working_div,
+                        KernelComputeLSHBuckets{},
+                        dev_points.view(),
+                        d_functions.data(),
+                        (*d_lsh_buckets).data(),
+                        bucket_width,
+                        ndim,
+                        params.n_tables,
+                        params.n_hashes,
+                        n_buckets);
+    d_lsh_tables->template fill<Acc1D>(
+        n_elements, GetLSHBucket{(*d_lsh_buckets).data()}, queue);
+
+    auto launch_density = [&](auto accumulator) {
+      alpaka::exec<Acc1D>(queue,
+                          working_div,
+                          KernelCalculateLocalDensityLSH{},
+                          d_lsh_tables->view(),
+                          (*d_lsh_buckets).data(),
+                          dev_points.view(),
+                          kernel,
+                          dc_,
+                          ndim,
+                          params.n_tables,
+                          n_points,
+                          accumulator);
+    };
+    if (reproducible_) {
+      launch_density(FixedPointAccumulator{fixed_point_scale});
+    } else {
+      launch_density(FloatAccumulator{});
+    }
+    alpaka::exec<Acc1D>(queue,
+                        working_div,
+                        KernelCalculateNearestHigherLSH{},
+                        d_lsh_tables->view(),
+                        (*d_lsh_buckets).data(),
+                        dev_points.view(),
+                        dm_,
+                        ndim,
+                        params.n_tables,
+                        n_points);
+    alpaka::wait(queue);
+  }
+
+  template <uint8_t TileDim>
+  template <typename KernelType>
+  void CLUEAlgoAlpakaDynamic<TileDim>::make_clusters(const float* h_coords,
+                                                     int* h_results,
+                                                     int32_t ndim,
+                                                     uint32_t n_points,
+                                                     const KernelType& kernel,
+                                                     Queue queue,
+                                                     std::size_t block_size,
+                                                     std::span<const uint8_t> wrapping) {
+    if (ndim < TileDim) {
+      throw std::invalid_argument("The points must have at least " +
+                                  std::to_string(TileDim) + " dimensions");
+    }
+    if (std::ranges::any_of(wrapping, [](auto w) { return w != 0; })) {
+      throw std::invalid_argument(
+          "The periodic coordinates are not supported with a runtime number of "
+          "dimensions");
+    }
+    const auto device = alpaka::getDev(queue);
+    setupPoints(h_coords, ndim, n_points, queue, block_size);
+    auto& dev_points = *d_points;
+
+    if (lsh_.has_value()) {
+      searchLSH(ndim, n_points, kernel, queue, block_size);
+    } else {
+      searchTiles(ndim, n_points, kernel, queue, block_size);
+    }
+
+    const Idx grid_size = clue::divide_up_by(n_points, block_size);
+    auto working_div = clue::make_workdiv<Acc1D>(grid_size, block_size);
+    // the classification of the points doesn't depend on their dimensionality
+    alpaka::exec<Acc1D>(queue,
+                        working_div,
+                        KernelFindClusters<TileDim>{},
+                        m_seeds,
+                        m_followers,
+                        dev_points.view(),
+                        dm_,
+                        dc_,
+                        rhoc_,
+                        n_points);
+
+    // the index of the clusters is the position of their seed
+    if (reproducible_) {
+      sort_seeds(queue);
+    }
+    const Idx grid_size_seeds = clue::divide_up_by(reserve, block_size);
+    auto working_div_seeds = clue::make_workdiv<Acc1D>(grid_size_seeds, block_size);
+    alpaka::exec<Acc1D>(queue,
+                        working_div_seeds,
+                        KernelAssignClusters<TileDim>{},
+                        m_seeds,
+                        m_followers,
+                        dev_points.view());
+
+    alpaka::memcpy(queue,
+                   clue::make_host_view(h_results, 2 * n_points),
+                   clue::make_device_view(
+                       device, dev_points.result_buffer.data() + n_points, 2 * n_points),
+                   2 * n_points);
+    alpaka::wait(queue);
+  }
+
+}  // namespace ALPAKA_ACCELERATOR_NAMESPACE_CLUE
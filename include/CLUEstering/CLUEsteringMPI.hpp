@@ -0,0 +1,437 @@
+#pragma once
+
+#include <mpi.h>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "CLUEstering.hpp"
+
+namespace clue {
+
+  // Converts a number of elements, or an offset in elements, to the int of the MPI
+  // interface
+  inline int mpiCount(std::size_t count) {
+    if (count > static_cast<std::size_t>(std::numeric_limits<int>::max())) {
+      throw std::overflow_error(
+          "The number of elements exchanged exceeds the range of the MPI counts");
+    }
+    return static_cast<int>(count);
+  }
+
+  // Sends send[r] to the rank r and returns the elements received from all the ranks,
+  // ordered by rank. The number of elements received from each rank is written in
+  // recv_counts, if given. The counts and the displacements are in elements of a
+  // contiguous datatype of sizeof(T) bytes, so that the messages aren't limited to
+  // 2 GB but to 2^31 elements.
+  template <typename T>
+  std::vector<T> alltoallv(MPI_Comm comm,
+                           const std::vector<std::vector<T>>& send,
+                           std::vector<int>* recv_counts = nullptr) {
+    int size;
+    MPI_Comm_size(comm, &size);
+    std::vector<int> send_counts(size), counts(size);
+    std::vector<int> send_displs(size), recv_displs(size);
+    for (int r{}; r != size; ++r) {
+      send_counts[r] = mpiCount(send[r].size());
+    }
+    MPI_Alltoall(send_counts.data(), 1, MPI_INT, counts.data(), 1, MPI_INT, comm);
+
+    std::vector<T> send_buffer;
+    for (int r{}; r != size; ++r) {
+      send_displs[r] = mpiCount(send_buffer.size());
+      send_buffer.insert(send_buffer.end(), send[r].begin(), send[r].end());
+    }
+    std::size_t total_count{};
+    for (int r{}; r != size; ++r) {
+      recv_displs[r] = mpiCount(total_count);
+      total_count += counts[r];
+    }
+    std::vector<T> recv_buffer(total_count);
+
+    MPI_Datatype type;
+    MPI_Type_contiguous(static_cast<int>(sizeof(T)), MPI_BYTE, &type);
+    MPI_Type_commit(&type);
+    MPI_Alltoallv(send_buffer.data(),
+                  send_counts.data(),
+                  send_displs.data(),
+                  type,
+                  recv_buffer.data(),
+                  counts.data(),
+                  recv_displs.data(),
+                  type,
+                  comm);
+    MPI_Type_free(&type);
+
+    if (recv_counts != nullptr) {
+      *recv_counts = std::move(counts);
+    }
+    return recv_buffer;
+  }
+
+  // Sends the keys in requests[r] to the rank r, which replies to each of them with
+  // answer(key). The replies are returned in the same order as the requests, grouped
+  // by rank.
+  template <typename TReply, typename TAnswer>
+  std::vector<TReply> query(MPI_Comm comm,
+                            const std::vector<std::vector<int64_t>>& requests,
+                            TAnswer&& answer) {
+    int size;
+    MPI_Comm_size(comm, &size);
+    std::vector<int> recv_counts;
+    const auto keys = alltoallv(comm, requests, &recv_counts);
+
+    std::vector<std::vector<TReply>> replies(size);
+    std::size_t k{};
+    for (int r{}; r != size; ++r) {
+      replies[r].reserve(recv_counts[r]);
+      for (int i{}; i != recv_counts[r]; ++i, ++k) {
+        replies[r].push_back(answer(keys[k]));
+      }
+    }
+    return alltoallv(comm, replies);
+  }
+
+}  // namespace clue
+
+// Distributed version of the algorithm, where the points are spread over the
+// processes of an MPI communicator, in any way. The points are partitioned in slabs
+// along the coordinate with the largest range, with about the same number of points
+// per process, and each process also receives as ghosts the points of the other
+// slabs within max(dc, dm) from its own. Each process then runs CLUEAlgoAlpaka on its
+// points and ghosts: the densities of its points are complete, the ones of the ghosts
+// are taken from the processes owning them, and then the nearest highers are found.
+// The chains of nearest highers crossing the slabs are followed by exchanging the
+// state of their ends between the processes, until all the points reach a seed or an
+// outlier. The points are sorted by their global index, i.e. their position in the
+// concatenation of the points of all the processes by rank, so the ties are broken as
+// in a single process run on all the points. Periodic coordinates are not supported.
+namespace ALPAKA_ACCELERATOR_NAMESPACE_CLUE {
+
+  template <uint8_t Ndim>
+  struct DistributedPoint {
+    float coords[Ndim];
+    float weight;
+    int64_t id;
+    // rank and index that the point had in the input
+    int32_t origin_rank;
+    uint32_t origin_index;
+    // rank that owns the point, the point is a ghost in all the others
+    int32_t owner;
+  };
+
+  template <uint8_t Ndim>
+  class CLUEAlgoMPI {
+  public:
+    explicit CLUEAlgoMPI(
+        float dc, float rhoc, float dm, int pPBin, Queue queue, MPI_Comm comm)
+        : algo_{dc, rhoc, dm, pPBin, queue}, dc_{dc}, rhoc_{rhoc}, dm_{dm}, comm_{comm} {}
+
+    // The algorithm run by each process, which can be used for setting its options
+    CLUEAlgoAlpaka<Ndim>& localAlgo() { return algo_; }
+
+    // Collective call, where each process passes its own points and receives in them
+    // the results. The cluster indexes are global, i.e. shared by all the processes.
+    template <typename KernelType>
+    void make_clusters(PointsSoA<Ndim>& h_points,
+                       const KernelType& kernel,
+                       Queue queue,
+                       std::size_t block_size);
+
+  private:
+    // number of bins of the histogram used for partitioning the points, per process
+    static constexpr int32_t bins_per_rank{64};
+
+    CLUEAlgoAlpaka<Ndim> algo_;
+    float dc_;
+    float rhoc_;
+    float dm_;
+    MPI_Comm comm_;
+
+    // Sends each point to the process owning it and to the ones where it's a ghost,
+    // and returns the points received, sorted by global index
+    std::vector<DistributedPoint<Ndim>> distributePoints(const PointsSoA<Ndim>& h_points);
+  };
+
+  template <uint8_t Ndim>
+  std::vector<DistributedPoint<Ndim>> CLUEAlgoMPI<Ndim>::distributePoints(
+      const PointsSoA<Ndim>& h_points) {
+    int rank, size;
+    MPI_Comm_rank(comm_, &rank);
+    MPI_Comm_size(comm_, &size);
+    const auto nPoints = h_points.nPoints();
+    const float* coords = h_points.coords();
+
+    int64_t n_local{nPoints}, first_id{};
+    MPI_Exscan(&n_local, &first_id, 1, MPI_INT64_T, MPI_SUM, comm_);
+    if (rank == 0) {
+      first_id = 0;
+    }
+
+    std::array<float, Ndim> min_coords, max_coords;
+    min_coords.fill(std::numeric_limits<float>::max());
+    max_coords.fill(std::numeric_limits<float>::lowest());
+    for (uint32_t dim{}; dim != Ndim; ++dim) {
+      for (uint32_t i{}; i != nPoints; ++i) {
+        min_coords[dim] = std::min(min_coords[dim], coords[i + dim * nPoints]);
+        max_coords[dim] = std::max(max_coords[dim], coords[i + dim * nPoints]);
+      }
+    }
+    MPI_Allreduce(MPI_IN_PLACE, min_coords.data(), Ndim, MPI_FLOAT, MPI_MIN, comm_);
+    MPI_Allreduce(MPI_IN_PLACE, max_coords.data(), Ndim, MPI_FLOAT, MPI_MAX, comm_);
+    uint32_t slab_dim{};
+    for (uint32_t dim{1}; dim != Ndim; ++dim) {
+      if (max_coords[dim] - min_coords[dim] >
+          max_coords[slab_dim] - min_coords[slab_dim]) {
+        slab_dim = dim;
+      }
+    }
+
+    // the slabs are made of the bins of a global histogram of the coordinate, with
+    // each rank taking the bins where the cumulative count reaches its share
+    const int32_t n_bins{bins_per_rank * size};
+    const float min_coord{min_coords[slab_dim]};
+    const float range{max_coords[slab_dim] - min_coord};
+    auto getBin = [&](float coord) {
+      if (!(range > 0.f)) {
+        return 0;
+      }
+      const auto bin = static_cast<int32_t>((coord - min_coord) / range * n_bins);
+      return std::clamp(bin, 0, n_bins - 1);
+    };
+    std::vector<int64_t> histogram(n_bins, 0);
+    for (uint32_t i{}; i != nPoints; ++i) {
+      ++histogram[getBin(coords[i + slab_dim * nPoints])];
+    }
+    MPI_Allreduce(MPI_IN_PLACE, histogram.data(), n_bins, MPI_INT64_T, MPI_SUM, comm_);
+    int64_t n_total{};
+    for (auto count : histogram) {
+      n_total += count;
+    }
+
+    std::vector<int32_t> bin_owner(n_bins);
+    std::vector<float> slab_min(size, std::numeric_limits<float>::max());
+    std::vector<float> slab_max(size, std::numeric_limits<float>::lowest());
+    int64_t cumulative{};
+    for (int32_t bin{}; bin != n_bins; ++bin) {
+      const auto owner = static_cast<int32_t>(
+          std::min<int64_t>(size - 1, n_total > 0 ? cumulative * size / n_total : 0));
+      cumulative += histogram[bin];
+      bin_owner[bin] = owner;
+      slab_min[owner] = std::min(slab_min[owner], min_coord + bin * range / n_bins);
+      slab_max[owner] = std::max(slab_max[owner], min_coord + (bin + 1) * range / n_bins);
+    }
+
+    // the width of the halo is enlarged by the rounding errors of the binning
+    const float tolerance{4.f * std::numeric_limits<float>::epsilon() *
+                          (std::abs(min_coords[slab_dim]) +
+                           std::abs(max_coords[slab_dim]))};
+    const float width{std::max(dc_, dm_) + tolerance};
+    std::vector<std::vector<DistributedPoint<Ndim>>> send(size);
+    for (uint32_t i{}; i != nPoints; ++i) {
+      DistributedPoint<Ndim> point;
+      for (uint32_t dim{}; dim != Ndim; ++dim) {
+        point.coords[dim] = coords[i + dim * nPoints];
+      }
+      point.weight = h_points.weights()[i];
+      point.id = first_id + i;
+      point.origin_rank = rank;
+      point.origin_index = i;
+      point.owner = bin_owner[getBin(point.coords[slab_dim])];
+      for (int r{}; r != size; ++r) {
+        if (r == point.owner or (point.coords[slab_dim] >= slab_min[r] - width and
+                                 point.coords[slab_dim] <= slab_max[r] + width)) {
+          send[r].push_back(point);
+        }
+      }
+    }
+
+    auto points = clue::alltoallv(comm_, send);
+    std::sort(points.begin(), points.end(), [](const auto& a, const auto& b) {
+      return a.id < b.id;
+    });
+    return points;
+  }
+
+  template <uint8_t Ndim>
+  template <typename KernelType>
+  void CLUEAlgoMPI<Ndim>::make_clusters(PointsSoA<Ndim>& h_points,
+                                        const KernelType& kernel,
+                                        Queue queue,
+                                        std::size_t block_size) {
+    const auto& wrapped = h_points.wrapped();
+    if (std::any_of(wrapped.begin(), wrapped.end(), [](auto w) { return w != 0; })) {
+      throw std::invalid_argument(
+          "Periodic coordinates are not supported by the distributed clustering");
+    }
+    int rank, size;
+    MPI_Comm_rank(comm_, &rank);
+    MPI_Comm_size(comm_, &size);
+
+    const auto points = distributePoints(h_points);
+    const auto n_points = static_cast<uint32_t>(points.size());
+    std::unordered_map<int64_t, uint32_t> owned_index;
+    for (uint32_t i{}; i != n_points; ++i) {
+      if (points[i].owner == rank) {
+        owned_index.emplace(points[i].id, i);
+      }
+    }
+
+    // the points and the ghosts are clustered together, but only the densities of
+    // the points are complete
+    std::vector<float> input((Ndim + 1) * n_points);
+    std::vector<int> results(2 * n_points);
+    for (uint32_t i{}; i != n_points; ++i) {
+      for (uint32_t dim{}; dim != Ndim; ++dim) {
+        input[i + dim * n_points] = points[i].coords[dim];
+      }
+      input[i + Ndim * n_points] = points[i].weight;
+    }
+    PointsSoA<Ndim> local_points(input.data(), results.data(), PointInfo<Ndim>{n_points});
+    PointsAlpaka<Ndim> d_points(queue, n_points);
+    std::vector<float> rho;
+    std::vector<float> delta;
+    std::vector<int> nearest_higher;
+    if (n_points > 0) {
+      algo_.run_stages(
+          clue::Stage::density, local_points, d_points, kernel, queue, block_size);
+      rho = algo_.getDensity(d_points, queue);
+    }
+
+    // the densities of the ghosts are taken from their owners
+    std::vector<std::vector<int64_t>> requests(size);
+    std::vector<std::vector<uint32_t>> ghosts(size);
+    for (uint32_t i{}; i != n_points; ++i) {
+      if (points[i].owner != rank) {
+        requests[points[i].owner].push_back(points[i].id);
+        ghosts[points[i].owner].push_back(i);
+      }
+    }
+    const auto ghost_rho = clue::query<float>(
+        comm_, requests, [&](int64_t id) { return rho[owned_index.at(id)]; });
+    std::size_t k{};
+    for (int r{}; r != size; ++r) {
+      for (auto i : ghosts[r]) {
+        rho[i] = ghost_rho[k++];
+      }
+    }
+    if (n_points > 0) {
+      algo_.resume_nearest_higher(rho, d_points, queue, block_size);
+      delta = algo_.getDelta(d_points, queue);
+      nearest_higher = algo_.getNearestHigher(d_points, queue);
+    }
+
+    // the seeds are numbered in order of global index, after the ones of the
+    // previous ranks
+    std::vector<uint8_t> is_seed(n_points, 0);
+    int32_t n_seeds{}, first_cluster{};
+    for (uint32_t i{}; i != n_points; ++i) {
+      if (points[i].owner == rank and delta[i] > dc_ and rho[i] >= rhoc_) {
+        is_seed[i] = 1;
+        ++n_seeds;
+      }
+    }
+    MPI_Exscan(&n_seeds, &first_cluster, 1, MPI_INT32_T, MPI_SUM, comm_);
+    if (rank == 0) {
+      first_cluster = 0;
+    }
+
+    // The state of each point is either its cluster, when it's resolved, or the
+    // point ending its chain of nearest highers in this process, which is a ghost
+    // owned by another process. Outliers and their followers have cluster -1.
+    constexpr int32_t unresolved{std::numeric_limits<int32_t>::min()};
+    struct ChainState {
+      int32_t cluster;
+      int64_t next_id;
+      int32_t next_rank;
+    };
+    std::vector<ChainState> state(n_points, ChainState{unresolved, -1, -1});
+    for (uint32_t i{}; i != n_points; ++i) {
+      if (is_seed[i]) {
+        state[i].cluster = first_cluster++;
+      } else if (points[i].owner == rank and delta[i] > dm_ and rho[i] < rhoc_) {
+        state[i].cluster = -1;
+      }
+    }
+    std::vector<uint32_t> chain;
+    for (uint32_t i{}; i != n_points; ++i) {
+      if (points[i].owner != rank) {
+        continue;
+      }
+      // follow the chain up to a resolved point or a ghost
+      auto j = i;
+      while (state[j].cluster == unresolved and state[j].next_rank < 0 and
+             points[j].owner == rank) {
+        chain.push_back(j);
+        const auto nh = nearest_higher[j];
+        if (nh < 0) {
+          state[j].cluster = -1;
+          break;
+        }
+        j = nh;
+      }
+      const auto end = state[j];
+      for (auto c : chain) {
+        if (points[j].owner != rank) {
+          state[c] = ChainState{unresolved, points[j].id, points[j].owner};
+        } else {
+          state[c] = end;
+        }
+      }
+      chain.clear();
+    }
+
+    // the chains crossing the slabs are resolved by pointer jumping, where each
+    // point takes the state of the end of its chain until they all reach a cluster
+    while (true) {
+      int32_t n_pending{};
+      std::vector<std::vector<int64_t>> pending_requests(size);
+      std::vector<std::vector<uint32_t>> pending(size);
+      for (uint32_t i{}; i != n_points; ++i) {
+        if (points[i].owner == rank and state[i].cluster == unresolved) {
+          pending_requests[state[i].next_rank].push_back(state[i].next_id);
+          pending[state[i].next_rank].push_back(i);
+          ++n_pending;
+        }
+      }
+      MPI_Allreduce(MPI_IN_PLACE, &n_pending, 1, MPI_INT32_T, MPI_SUM, comm_);
+      if (n_pending == 0) {
+        break;
+      }
+      const auto ends = clue::query<ChainState>(
+          comm_, pending_requests, [&](int64_t id) { return state[owned_index.at(id)]; });
+      k = 0;
+      for (int r{}; r != size; ++r) {
+        for (auto i : pending[r]) {
+          state[i] = ends[k++];
+        }
+      }
+    }
+
+    // the results are sent back to the processes that passed the points
+    struct Result {
+      uint32_t index;
+      int32_t cluster;
+      int32_t is_seed;
+    };
+    std::vector<std::vector<Result>> send(size);
+    for (uint32_t i{}; i != n_points; ++i) {
+      if (points[i].owner == rank) {
+        send[points[i].origin_rank].push_back(
+            Result{points[i].origin_index, state[i].cluster, is_seed[i]});
+      }
+    }
+    for (const auto& result : clue::alltoallv(comm_, send)) {
+      h_points.clusterIndexes()[result.index] = result.cluster;
+      h_points.isSeed()[result.index] = result.is_seed;
+    }
+  }
+
+}  // namespace ALPAKA_ACCELERATOR_NAMESPACE_CLUE
@@ -132,7 +132,7 @@ namespace clue {
     template <typename TQueue, typename = std::enable_if_t<alpaka::isQueue<TQueue>>>
     ALPAKA_FN_HOST void initialize(size_t nelements, size_t nbins, TQueue queue) {
       m_indexes = make_device_buffer<uint32_t[]>(queue, nelements);
-      m_offsets = make_device_buffer<uint32_t[]>(queue, nbins);
+      m_offsets = make_device_buffer<uint32_t[]>(queue, nbins + 1);
       alpaka::memset(queue, m_offsets, 0);
       m_nbins = nbins;
 
@@ -214,25 +214,12 @@ namespace clue {
                          sizes_buffer.data(),
                          size);
 
-      // prepare prefix scan
-      auto block_counter = make_device_buffer<int32_t>(queue);
-      alpaka::memset(queue, block_counter, 0);
-
-      const auto blocksize_multiblockscan = 1024;
-      auto gridsize_multiblockscan = divide_up_by(m_nbins, blocksize_multiblockscan);
-      const auto workdiv_multiblockscan =
-          make_workdiv<TAcc>(gridsize_multiblockscan, blocksize_multiblockscan);
-      const auto dev = alpaka::getDev(queue);
-      auto warp_size = alpaka::getPreferredWarpSize(dev);
-      alpaka::exec<TAcc>(queue,
-                         workdiv_multiblockscan,
-                         multiBlockPrefixScan<uint32_t>{},
-                         sizes_buffer.data(),
-                         m_offsets.data() + 1,
-                         m_nbins,
-                         gridsize_multiblockscan,
-                         block_counter.data(),
-                         warp_size);
+      // compute the offsets of the bins with a prefix scan of their sizes, which
+      // on the CPU backends is done with a blocked scan instead of the GPU one
+      inclusivePrefixScan<TAcc>(queue,
+                                sizes_buffer.data(),
+                                m_offsets.data() + 1,
+                                static_cast<uint32_t>(m_nbins));
 
       // fill associator
       auto temp_offsets = make_device_buffer<uint32_t[]>(queue, m_nbins + 1);
@@ -1,15 +1,55 @@
 #ifndef Points_Alpaka_h
 #define Points_Alpaka_h
 
+#include <cassert>
 #include <cstdint>
+#include <istream>
 #include <memory>
+#include <ostream>
 
 #include "../../AlpakaCore/alpakaConfig.hpp"
 #include "../../AlpakaCore/alpakaMemory.hpp"
 #include "../Points.hpp"
+#include "../../utility/checkpoint.hpp"
 
 namespace ALPAKA_ACCELERATOR_NAMESPACE_CLUE {
 
+  // Number of points in each block of the AoSoA layout of the coordinates, where each
+  // block stores the coordinates of all the dimensions of its points contiguously, so
+  // that all the coordinates of a point are read from one or two cache lines. Zero
+  // keeps the SoA layout, where each dimension is stored contiguously for all the
+  // points. It only applies to the points with a number of dimensions known at
+  // compile time.
+#ifndef CLUE_POINTS_AOSOA_BLOCK
+#define CLUE_POINTS_AOSOA_BLOCK 0
+#endif
+  constexpr uint32_t aosoa_block{CLUE_POINTS_AOSOA_BLOCK};
+  static_assert(aosoa_block == 0 or aosoa_block == 8 or aosoa_block == 16,
+                "CLUE_POINTS_AOSOA_BLOCK must be 0, 8 or 16");
+
+  // Index of the coordinate dim of the point i in the coordinates of n points
+  template <uint8_t Ndim>
+  ALPAKA_FN_HOST_ACC inline constexpr uint32_t coordIndex(uint32_t i,
+                                                          uint32_t dim,
+                                                          [[maybe_unused]] uint32_t n) {
+#if CLUE_POINTS_AOSOA_BLOCK
+    return (i / aosoa_block) * aosoa_block * Ndim + dim * aosoa_block + i % aosoa_block;
+#else
+    return i + dim * n;
+#endif
+  }
+
+  // Number of elements taken by the coordinates of n points, which with the AoSoA
+  // layout are padded to a whole number of blocks
+  template <uint8_t Ndim>
+  inline constexpr uint32_t coordsSize(uint32_t n) {
+#if CLUE_POINTS_AOSOA_BLOCK
+    return Ndim * ((n + aosoa_block - 1) / aosoa_block * aosoa_block);
+#else
+    return Ndim * n;
+#endif
+  }
+
   class PointsAlpakaView {
   public:
     float* coords;
@@ -20,42 +60,160 @@ namespace ALPAKA_ACCELERATOR_NAMESPACE_CLUE {
     int* cluster_index;
     int* is_seed;
     int n;
+    // The ghost copies of the points near the periodic boundaries are stored after
+    // the n_real points, and ghost_origin contains the index of the point that each
+    // of them replicates
+    const uint32_t* ghost_origin;
+    int n_real;
   };
 
+  // Index of the point replicated by the point j, which is j itself if it isn't a ghost
+  ALPAKA_FN_HOST_ACC inline uint32_t originalIndex(const PointsAlpakaView* dev_points,
+                                                   uint32_t j) {
+    const auto n_real = static_cast<uint32_t>(dev_points->n_real);
+    return j < n_real ? j : dev_points->ghost_origin[j - n_real];
+  }
+
   template <uint8_t Ndim>
   class PointsAlpaka {
   public:
     PointsAlpaka() = delete;
     explicit PointsAlpaka(Queue stream, int n_points)
-        : input_buffer{clue::make_device_buffer<float[]>(stream, (Ndim + 3) * n_points)},
+        : PointsAlpaka(stream, n_points, 0) {}
+    // Also allocates the space for n_ghosts ghost copies of the points, which are
+    // stored after them in all the buffers
+    explicit PointsAlpaka(Queue stream, int n_points, int n_ghosts)
+        : input_buffer{clue::make_device_buffer<float[]>(stream,
+                                                         inputSize(n_points + n_ghosts))},
+          result_buffer{
+              clue::make_device_buffer<int[]>(stream, 3 * (n_points + n_ghosts))},
+          ghost_origin{clue::make_device_buffer<uint32_t[]>(stream, n_ghosts)},
+          view_dev{clue::make_device_buffer<PointsAlpakaView>(stream)},
+          m_npoints{n_points},
+          m_nstored{n_points + n_ghosts},
+          m_capacity{n_points + n_ghosts},
+          m_ghost_capacity{n_ghosts} {
+      setView(stream);
+    }
+
+    PointsAlpaka(const PointsAlpaka&) = delete;
+    PointsAlpaka& operator=(const PointsAlpaka&) = delete;
+    PointsAlpaka(PointsAlpaka&&) = default;
+    PointsAlpaka& operator=(PointsAlpaka&&) = default;
+    ~PointsAlpaka() = default;
+
+    clue::device_buffer<Device, float[]> input_buffer;
+    clue::device_buffer<Device, int[]> result_buffer;
+    clue::device_buffer<Device, uint32_t[]> ghost_origin;
+
+    PointsAlpakaView* view() { return view_dev.data(); }
+    int nPoints() const { return m_npoints; }
+    // Number of points stored, including the ghosts
+    int nStored() const { return m_nstored; }
+
+    // Whether the buffers can be reused for n_points points and n_ghosts ghosts
+    bool fits(int n_points, int n_ghosts = 0) const {
+      return n_points + n_ghosts <= m_capacity and n_ghosts <= m_ghost_capacity;
+    }
+    // Reuses the buffers for n_points points and n_ghosts ghosts, which must fit in
+    // them. The buffers are laid out as if they had been allocated for these points.
+    void resize(Queue stream, int n_points, int n_ghosts = 0) {
+      assert(fits(n_points, n_ghosts));
+      m_npoints = n_points;
+      m_nstored = n_points + n_ghosts;
+      setView(stream);
+    }
+
+    // Device buffers of the results of the intermediate stages
+    float* rho() { return input_buffer.data() + coordsSize<Ndim>(m_nstored) + m_nstored; }
+    float* delta() {
+      return input_buffer.data() + coordsSize<Ndim>(m_nstored) + 2 * m_nstored;
+    }
+    int* nearestHigher() { return result_buffer.data(); }
+    int* clusterIndexes() { return result_buffer.data() + m_nstored; }
+    int* isSeed() { return result_buffer.data() + 2 * m_nstored; }
+
+    // Number of elements of the input buffer, which contains the coordinates followed
+    // by the weights, the densities and the deltas
+    static constexpr uint32_t inputSize(uint32_t n_points) {
+      return coordsSize<Ndim>(n_points) + 3 * n_points;
+    }
+
+    // Write all the buffers of the points to a checkpoint, or read them from it
+    void save(std::ostream& out, Queue queue, uint32_t n_points) {
+      clue::write_device_array(out, queue, input_buffer.data(), inputSize(n_points));
+      clue::write_device_array(out, queue, result_buffer.data(), 3 * n_points);
+    }
+    void load(std::istream& in, Queue queue, uint32_t n_points) {
+      clue::read_device_array(in, queue, input_buffer.data(), inputSize(n_points));
+      clue::read_device_array(in, queue, result_buffer.data(), 3 * n_points);
+    }
+
+  private:
+    clue::device_buffer<Device, PointsAlpakaView> view_dev;
+    int m_npoints;
+    int m_nstored;
+    int m_capacity;
+    int m_ghost_capacity;
+
+    void setView(Queue stream) {
+      const auto coords_size = coordsSize<Ndim>(m_nstored);
+      auto view_host = clue::make_host_buffer<PointsAlpakaView>(stream);
+      view_host->coords = input_buffer.data();
+      view_host->weight = input_buffer.data() + coords_size;
+      view_host->rho = input_buffer.data() + coords_size + m_nstored;
+      view_host->delta = input_buffer.data() + coords_size + 2 * m_nstored;
+      view_host->nearest_higher = result_buffer.data();
+      view_host->cluster_index = result_buffer.data() + m_nstored;
+      view_host->is_seed = result_buffer.data() + 2 * m_nstored;
+      view_host->n = m_nstored;
+      view_host->ghost_origin = ghost_origin.data();
+      view_host->n_real = m_npoints;
+
+      alpaka::memcpy(stream, view_dev, view_host);
+    }
+  };
+
+  // Points whose number of dimensions is only known at runtime. The buffers have the
+  // same layout as the ones of PointsAlpaka, so they share the same view.
+  class PointsAlpakaDynamic {
+  public:
+    PointsAlpakaDynamic() = delete;
+    explicit PointsAlpakaDynamic(Queue stream, int n_points, int n_dim)
+        : input_buffer{clue::make_device_buffer<float[]>(stream, (n_dim + 3) * n_points)},
           result_buffer{clue::make_device_buffer<int[]>(stream, 3 * n_points)},
-          view_dev{clue::make_device_buffer<PointsAlpakaView>(stream)} {
+          view_dev{clue::make_device_buffer<PointsAlpakaView>(stream)},
+          m_ndim{n_dim} {
       auto view_host = clue::make_host_buffer<PointsAlpakaView>(stream);
       view_host->coords = input_buffer.data();
-      view_host->weight = input_buffer.data() + Ndim * n_points;
-      view_host->rho = input_buffer.data() + (Ndim + 1) * n_points;
-      view_host->delta = input_buffer.data() + (Ndim + 2) * n_points;
+      view_host->weight = input_buffer.data() + n_dim * n_points;
+      view_host->rho = input_buffer.data() + (n_dim + 1) * n_points;
+      view_host->delta = input_buffer.data() + (n_dim + 2) * n_points;
       view_host->nearest_higher = result_buffer.data();
       view_host->cluster_index = result_buffer.data() + n_points;
       view_host->is_seed = result_buffer.data() + 2 * n_points;
       view_host->n = n_points;
+      view_host->ghost_origin = nullptr;
+      view_host->n_real = n_points;
 
       alpaka::memcpy(stream, view_dev, view_host);
     }
 
-    PointsAlpaka(const PointsAlpaka&) = delete;
-    PointsAlpaka& operator=(const PointsAlpaka&) = delete;
-    PointsAlpaka(PointsAlpaka&&) = default;
-    PointsAlpaka& operator=(PointsAlpaka&&) = default;
-    ~PointsAlpaka() = default;
+    PointsAlpakaDynamic(const PointsAlpakaDynamic&) = delete;
+    PointsAlpakaDynamic& operator=(const PointsAlpakaDynamic&) = delete;
+    PointsAlpakaDynamic(PointsAlpakaDynamic&&) = default;
+    PointsAlpakaDynamic& operator=(PointsAlpakaDynamic&&) = default;
+    ~PointsAlpakaDynamic() = default;
 
     clue::device_buffer<Device, float[]> input_buffer;
     clue::device_buffer<Device, int[]> result_buffer;
 
     PointsAlpakaView* view() { return view_dev.data(); }
+    int nDim() const { return m_ndim; }
 
   private:
     clue::device_buffer<Device, PointsAlpakaView> view_dev;
+    int m_ndim;
   };
 }  // namespace ALPAKA_ACCELERATOR_NAMESPACE_CLUE
 
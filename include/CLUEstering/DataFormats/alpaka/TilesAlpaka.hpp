@@ -5,6 +5,9 @@
 #include <alpaka/alpaka.hpp>
 #include <cstddef>
 #include <cstdint>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
 #include <stdint.h>
 
 #include "../../AlpakaCore/alpakaWorkDiv.hpp"
@@ -12,6 +15,7 @@
 #include "../../AlpakaCore/alpakaMemory.hpp"
 #include "AlpakaVecArray.hpp"
 #include "AssociationMap.hpp"
+#include "../../utility/checkpoint.hpp"
 
 using clue::VecArray;
 
@@ -248,7 +252,7 @@ namespace ALPAKA_ACCELERATOR_NAMESPACE_CLUE {
       ALPAKA_FN_ACC uint32_t operator()(const TAcc& acc, uint32_t index) const {
         float coords[Ndim];
         for (auto dim = 0; dim < Ndim; ++dim) {
-          coords[dim] = pointsView->coords[index + dim * pointsView->n];
+          coords[dim] = pointsView->coords[coordIndex<Ndim>(index, dim, pointsView->n)];
         }
 
         auto bin = tilesView->getGlobalBin(acc, coords);
@@ -256,11 +260,35 @@ namespace ALPAKA_ACCELERATOR_NAMESPACE_CLUE {
       }
     };
 
+    // Computes the bin from the leading Ndim rows of a SoA buffer of coordinates, which
+    // can contain more dimensions than the ones used for tiling
+    struct GetGlobalBinFromCoords {
+      const float* coords;
+      uint32_t n_points;
+      TilesAlpakaView<Ndim>* tilesView;
+
+      template <typename TAcc>
+      ALPAKA_FN_ACC uint32_t operator()(const TAcc& acc, uint32_t index) const {
+        float tiling_coords[Ndim];
+        for (auto dim = 0; dim < Ndim; ++dim) {
+          tiling_coords[dim] = coords[index + dim * n_points];
+        }
+
+        return tilesView->getGlobalBin(acc, tiling_coords);
+      }
+    };
+
     ALPAKA_FN_HOST void fill(Queue queue, PointsAlpaka<Ndim>& d_points, size_t size) {
       auto dev = alpaka::getDev(queue);
       auto pointsView = d_points.view();
       m_assoc.fill<Acc1D>(size, GetGlobalBin{pointsView, m_view.data()}, queue);
     }
+    ALPAKA_FN_HOST void fill(Queue queue, const float* d_coords, size_t size) {
+      m_assoc.fill<Acc1D>(size,
+                          GetGlobalBinFromCoords{
+                              d_coords, static_cast<uint32_t>(size), m_view.data()},
+                          queue);
+    }
 
     ALPAKA_FN_HOST inline clue::device_buffer<Device, CoordinateExtremes<Ndim>> minMax()
         const {
@@ -297,6 +325,38 @@ namespace ALPAKA_ACCELERATOR_NAMESPACE_CLUE {
       return m_assoc.indexes(dev, assoc_id);
     }
 
+    // Writes the geometry of the tiles and the content of the association map to a
+    // checkpoint
+    ALPAKA_FN_HOST void save(std::ostream& out, Queue queue, uint32_t npoints) {
+      clue::write_array(out, &m_ntiles, 1);
+      clue::write_array(out, &m_nperdim, 1);
+      clue::write_device_array(
+          out, queue, reinterpret_cast<float*>(m_minmax.data()), 2 * Ndim);
+      clue::write_device_array(out, queue, m_tilesizes.data(), Ndim);
+      clue::write_device_array(out, queue, m_wrapped.data(), Ndim);
+      clue::write_device_array(out, queue, m_assoc.offsets().data(), m_ntiles + 1);
+      clue::write_device_array(out, queue, m_assoc.indexes().data(), npoints);
+    }
+
+    // Reads the tiles from a checkpoint. The tiles must have already been set up with
+    // the same number of tiles used when the checkpoint was written.
+    ALPAKA_FN_HOST void load(std::istream& in, Queue queue, uint32_t npoints) {
+      int32_t ntiles;
+      int32_t nperdim;
+      clue::read_array(in, &ntiles, 1);
+      clue::read_array(in, &nperdim, 1);
+      if (ntiles != m_ntiles or nperdim != m_nperdim) {
+        throw std::runtime_error(
+            "The tiles in the checkpoint are not compatible with the current ones");
+      }
+      clue::read_device_array(
+          in, queue, reinterpret_cast<float*>(m_minmax.data()), 2 * Ndim);
+      clue::read_device_array(in, queue, m_tilesizes.data(), Ndim);
+      clue::read_device_array(in, queue, m_wrapped.data(), Ndim);
+      clue::read_device_array(in, queue, m_assoc.offsets().data(), m_ntiles + 1);
+      clue::read_device_array(in, queue, m_assoc.indexes().data(), npoints);
+    }
+
   private:
     clue::AssociationMap<Device> m_assoc;
     clue::device_buffer<Device, CoordinateExtremes<Ndim>> m_minmax;
@@ -0,0 +1,82 @@
+#include "CLUEstering.hpp"
+#include "CLUEsteringDynamic.hpp"
+#include "utility/read_csv.hpp"
+#include "utility/validation.hpp"
+#include <alpaka/alpaka.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+
+using namespace ALPAKA_ACCELERATOR_NAMESPACE_CLUE;
+
+static_assert(aosoa_block != 0, "The test must be built with CLUE_POINTS_AOSOA_BLOCK");
+
+namespace {
+
+  const float dc{20.f}, rhoc{10.f}, outlier{20.f};
+  const int pPBin{128};
+  const std::size_t block_size{256};
+
+  // Runs the static algorithm, which stores the coordinates in the AoSoA layout
+  std::vector<int> run(Queue queue, std::vector<float>& coords) {
+    const auto n_points = static_cast<uint32_t>(coords.size() / 3);
+    std::vector<int> results(2 * n_points);
+    PointsSoA<2> h_points(coords.data(), results.data(), PointInfo<2>{n_points});
+    PointsAlpaka<2> d_points(queue, n_points);
+    CLUEAlgoAlpaka<2> algo(dc, rhoc, outlier, pPBin, queue);
+    algo.make_clusters(h_points, d_points, FlatKernel{.5f}, queue, block_size);
+    results.resize(n_points);
+    return results;
+  }
+
+  // Runs the dynamic algorithm, which keeps the SoA layout
+  std::vector<int> run_soa(Queue queue, std::vector<float>& coords) {
+    const auto n_points = static_cast<uint32_t>(coords.size() / 3);
+    std::vector<int> results(2 * n_points);
+    CLUEAlgoAlpakaDynamic<2> algo(dc, rhoc, outlier, pPBin);
+    algo.make_clusters(
+        coords.data(), results.data(), 2, n_points, FlatKernel{.5f}, queue, block_size);
+    results.resize(n_points);
+    return results;
+  }
+
+  // Keeps the first n_points points
+  std::vector<float> first_points(const std::vector<float>& coords,
+                                  std::size_t n_points) {
+    const auto n_all = coords.size() / 3;
+    std::vector<float> first(3 * n_points);
+    for (std::size_t dim = 0; dim < 3; ++dim) {
+      for (std::size_t i = 0; i < n_points; ++i) {
+        first[dim * n_points + i] = coords[dim * n_all + i];
+      }
+    }
+    return first;
+  }
+
+}  // namespace
+
+TEST_CASE("Test that the AoSoA layout gives the clusters of the SoA layout") {
+  const auto dev_acc = alpaka::getDevByIdx(alpaka::Platform<Acc1D>{}, 0u);
+  Queue queue(dev_acc);
+
+  auto coords = read_csv<float, 2>("./sissa.csv");
+  const auto n_points = coords.size() / 3;
+  auto truth = read_output<2>("./sissa_1000_truth.csv");
+  auto result = run(queue, coords);
+  CHECK(clue::validate_results(std::span{result.data(), n_points},
+                               std::span{truth.data(), n_points}));
+
+  // the last block of the coordinates is only partially filled
+  const std::size_t block{aosoa_block};
+  for (std::size_t n_first : {block - 1, block + 1, n_points - 3}) {
+    auto first = first_points(coords, n_first);
+    auto expected = run_soa(queue, first);
+    auto result_first = run(queue, first);
+    CHECK(clue::validate_results(std::span{result_first.data(), n_first},
+                                 std::span{expected.data(), n_first}));
+  }
+}
@@ -0,0 +1,140 @@
+#include "CLUEstering.hpp"
+#include "utility/checkpoint.hpp"
+#include "utility/read_csv.hpp"
+#include "utility/validation.hpp"
+#include <alpaka/alpaka.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+
+using namespace ALPAKA_ACCELERATOR_NAMESPACE_CLUE;
+
+namespace {
+
+  const float dc{20.f}, rhoc{10.f}, outlier{20.f};
+  const int pPBin{128};
+  const std::size_t block_size{256};
+
+  std::vector<int> run(Queue queue,
+                       std::vector<float>& coords,
+                       const std::string& checkpoint_path = "") {
+    const auto n_points = static_cast<uint32_t>(coords.size() / 3);
+    std::vector<int> results(2 * n_points);
+    PointsSoA<2> h_points(coords.data(), results.data(), PointInfo<2>{n_points});
+    PointsAlpaka<2> d_points(queue, n_points);
+    CLUEAlgoAlpaka<2> algo(dc, rhoc, outlier, pPBin, queue);
+    if (checkpoint_path.empty()) {
+      algo.make_clusters(h_points, d_points, FlatKernel{.5f}, queue, block_size);
+    } else {
+      algo.make_clusters(
+          h_points, d_points, FlatKernel{.5f}, queue, block_size, checkpoint_path);
+    }
+    results.resize(n_points);
+    return results;
+  }
+
+  // Rewinds the checkpoint to an earlier stage, as if the run had been interrupted
+  // after it. The buffers of the later stages are left in the file and ignored.
+  void rewind_checkpoint(const std::string& path, clue::Stage stage) {
+    std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+    file.seekp(offsetof(clue::CheckpointHeader, stage));
+    clue::write_array(file, &stage, 1);
+  }
+
+  // Overwrites the number of seeds of a checkpoint written after the assignment,
+  // which ends with the number of seeds followed by the seeds
+  void corrupt_seed_count(const std::string& path, int32_t n_seeds, int32_t count) {
+    const auto size = std::filesystem::file_size(path);
+    std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+    file.seekp(size - (n_seeds + 1) * sizeof(int32_t));
+    clue::write_array(file, &count, 1);
+  }
+
+}  // namespace
+
+TEST_CASE("Test resuming a run from its checkpoint") {
+  const auto dev_acc = alpaka::getDevByIdx(alpaka::Platform<Acc1D>{}, 0u);
+  Queue queue(dev_acc);
+
+  const auto path =
+      (std::filesystem::temp_directory_path() / "clue_test_checkpoint.bin").string();
+  std::filesystem::remove(path);
+
+  auto coords = read_csv<float, 2>("./sissa.csv");
+  const auto n_points = coords.size() / 3;
+  auto truth = read_output<2>("./sissa_1000_truth.csv");
+
+  auto results = run(queue, coords, path);
+  CHECK(std::filesystem::exists(path));
+  CHECK(clue::validate_results(results, std::span{truth.data(), n_points}));
+
+  // the followers are only written after the classification, so the checkpoint of the
+  // assignment can't be rewound to it
+  for (auto stage : {clue::Stage::tiles,
+                     clue::Stage::density,
+                     clue::Stage::nearest_higher,
+                     clue::Stage::assignment}) {
+    rewind_checkpoint(path, stage);
+    results = run(queue, coords, path);
+    CHECK(clue::validate_results(results, std::span{truth.data(), n_points}));
+  }
+  rewind_checkpoint(path, clue::Stage::classification);
+  CHECK_THROWS_AS(run(queue, coords, path), std::runtime_error);
+
+  std::filesystem::remove(path);
+}
+
+TEST_CASE("Test that a checkpoint with too many seeds is rejected") {
+  const auto dev_acc = alpaka::getDevByIdx(alpaka::Platform<Acc1D>{}, 0u);
+  Queue queue(dev_acc);
+
+  const auto path =
+      (std::filesystem::temp_directory_path() / "clue_test_seeds.bin").string();
+  std::filesystem::remove(path);
+
+  auto coords = read_csv<float, 2>("./sissa.csv");
+  const auto results = run(queue, coords, path);
+  const auto n_seeds = clue::compute_nclusters(std::span{results});
+  corrupt_seed_count(path, n_seeds, reserve + 1);
+  CHECK_THROWS_AS(run(queue, coords, path), std::runtime_error);
+  corrupt_seed_count(path, n_seeds, -1);
+  CHECK_THROWS_AS(run(queue, coords, path), std::runtime_error);
+
+  std::filesystem::remove(path);
+}
+
+TEST_CASE("Test that a checkpoint isn't resumed for a different input") {
+  const auto dev_acc = alpaka::getDevByIdx(alpaka::Platform<Acc1D>{}, 0u);
+  Queue queue(dev_acc);
+
+  const auto path =
+      (std::filesystem::temp_directory_path() / "clue_test_foreign.bin").string();
+  std::filesystem::remove(path);
+
+  auto coords = read_csv<float, 2>("./sissa.csv");
+  const auto n_points = coords.size() / 3;
+  // same number of points and parameters, but the points are in the reverse order
+  auto foreign_coords = coords;
+  for (std::size_t column{}; column != 3; ++column) {
+    std::reverse(foreign_coords.begin() + column * n_points,
+                 foreign_coords.begin() + (column + 1) * n_points);
+  }
+  const auto expected = run(queue, foreign_coords);
+
+  const auto results = run(queue, coords, path);
+  auto foreign_results = run(queue, foreign_coords, path);
+  CHECK(clue::validate_results(foreign_results, expected));
+  // the checkpoint now belongs to the second input, so the first one is rerun
+  auto rerun = run(queue, coords, path);
+  CHECK(clue::validate_results(rerun, results));
+
+  std::filesystem::remove(path);
+}
@@ -0,0 +1,102 @@
+#include "CLUEstering.hpp"
+#include <alpaka/alpaka.hpp>
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <numbers>
+#include <vector>
+
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+
+using namespace ALPAKA_ACCELERATOR_NAMESPACE_CLUE;
+
+TEST_CASE("Test the cluster graph of a hand-built layout") {
+  const auto dev_acc = alpaka::getDevByIdx(alpaka::Platform<Acc1D>{}, 0u);
+  Queue queue(dev_acc);
+
+  // a hub cluster at the origin, made of a seed and a follower, surrounded by
+  // n_around clusters on a circle, each one made of a seed and a follower just
+  // outside it. All the points around are within the distance from both points of the
+  // hub, which touch more than max_contacts clusters with two points each, and each
+  // cluster around touches the three closest on each side.
+  const uint32_t n_around{20};
+  const uint32_t n_points{2 * n_around + 2};
+  const float radius{10.f}, distance{10.5f};
+  std::vector<float> coords(3 * n_points);
+  for (uint32_t k = 0; k < n_around; ++k) {
+    const auto angle = 2.f * std::numbers::pi_v<float> * k / n_around;
+    coords[k] = radius * std::cos(angle);
+    coords[n_points + k] = radius * std::sin(angle);
+    coords[2 * n_points + k] = 10.f + k;
+    coords[n_around + k] = (radius + .1f) * std::cos(angle);
+    coords[n_points + n_around + k] = (radius + .1f) * std::sin(angle);
+    coords[2 * n_points + n_around + k] = 1.f;
+  }
+  const uint32_t hub{2 * n_around}, follower{2 * n_around + 1};
+  coords[2 * n_points + hub] = 50.f;
+  coords[n_points + follower] = .2f;
+  coords[2 * n_points + follower] = 1.f;
+
+  std::vector<int> results(2 * n_points);
+  PointsSoA<2> h_points(coords.data(), results.data(), PointInfo<2>{n_points});
+  PointsAlpaka<2> d_points(queue, n_points);
+  CLUEAlgoAlpaka<2> algo(1.f, 2.f, 1.f, 128, queue);
+  algo.make_clusters(h_points, d_points, FlatKernel{.5f}, queue, 256);
+  const auto graph = algo.make_cluster_graph(h_points, d_points, distance, queue, 256);
+
+  REQUIRE(results[follower] == results[hub]);
+  for (uint32_t k = 0; k < n_around; ++k) {
+    REQUIRE(results[n_around + k] == results[k]);
+  }
+  REQUIRE(graph.nClusters() == static_cast<int32_t>(n_around + 1));
+  CHECK(graph.offsets.front() == 0u);
+  CHECK(graph.offsets.back() == 2 * n_around + 6 * n_around);
+
+  const auto weight = [&](uint32_t i) { return coords[2 * n_points + i]; };
+  const auto hub_cluster = results[hub];
+  const auto hub_neighbours = graph.neighboursOf(hub_cluster);
+  REQUIRE(hub_neighbours.size() == n_around);
+  for (std::size_t e = 1; e < hub_neighbours.size(); ++e) {
+    CHECK(hub_neighbours[e - 1] < hub_neighbours[e]);
+  }
+
+  for (uint32_t k = 0; k < n_around; ++k) {
+    const auto cluster = results[k];
+    const auto neighbours = graph.neighboursOf(cluster);
+    REQUIRE(neighbours.size() == 7);
+    for (std::size_t e = 1; e < neighbours.size(); ++e) {
+      CHECK(neighbours[e - 1] < neighbours[e]);
+    }
+
+    for (uint32_t e = graph.offsets[cluster]; e < graph.offsets[cluster + 1]; ++e) {
+      const auto neighbour = graph.neighbours[e];
+      if (neighbour == hub_cluster) {
+        const auto to_follower =
+            std::hypot(coords[k], coords[n_points + k] - coords[n_points + follower]);
+        CHECK(graph.min_distances[e] == doctest::Approx(std::min(radius, to_follower)));
+        CHECK(graph.boundary_weights[e] ==
+              doctest::Approx(weight(k) + weight(n_around + k) + weight(hub) +
+                              weight(follower)));
+        continue;
+      }
+      // the steps between the clusters around go from 1 to 3 on either side, and
+      // the closest pair is made of their seeds
+      uint32_t other{0};
+      while (results[other] != neighbour) {
+        ++other;
+      }
+      const auto step = std::min((other + n_around - k) % n_around,
+                                 (k + n_around - other) % n_around);
+      CHECK(step >= 1);
+      CHECK(step <= 3);
+      const auto chord =
+          2.f * radius * std::sin(std::numbers::pi_v<float> * step / n_around);
+      CHECK(graph.min_distances[e] == doctest::Approx(chord));
+      CHECK(graph.boundary_weights[e] ==
+            doctest::Approx(weight(k) + weight(n_around + k) + weight(other) +
+                            weight(n_around + other)));
+    }
+  }
+}
@@ -0,0 +1,101 @@
+#include "CLUEstering.hpp"
+#include "CLUEsteringDynamic.hpp"
+#include "utility/read_csv.hpp"
+#include "utility/validation.hpp"
+#include <alpaka/alpaka.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+
+using namespace ALPAKA_ACCELERATOR_NAMESPACE_CLUE;
+
+namespace {
+
+  const float dc{20.f}, rhoc{10.f}, outlier{20.f};
+  const int pPBin{128};
+  const std::size_t block_size{256};
+
+  // Adds to the two-dimensional points Ndim - 2 coordinates spread over a few times
+  // the critical distance, so that the extra dimensions change the neighbours
+  template <uint8_t Ndim>
+  std::vector<float> extend_points(const std::vector<float>& coords) {
+    const auto n_points = coords.size() / 3;
+    std::vector<float> extended((Ndim + 1) * n_points);
+    std::copy(coords.begin(), coords.begin() + 2 * n_points, extended.begin());
+    for (std::size_t dim = 2; dim < Ndim; ++dim) {
+      for (std::size_t i = 0; i < n_points; ++i) {
+        extended[dim * n_points + i] = static_cast<float>((i * (dim + 3)) % 5) * dc;
+      }
+    }
+    std::copy(coords.begin() + 2 * n_points,
+              coords.end(),
+              extended.begin() + Ndim * n_points);
+    return extended;
+  }
+
+  template <uint8_t Ndim>
+  void check_dynamic(Queue queue, std::vector<float> coords) {
+    const auto n_points = static_cast<uint32_t>(coords.size() / (Ndim + 1));
+
+    std::vector<int> results(2 * n_points);
+    PointsSoA<Ndim> h_points(coords.data(), results.data(), PointInfo<Ndim>{n_points});
+    CLUEAlgoAlpaka<Ndim> algo(dc, rhoc, outlier, pPBin, queue);
+    algo.make_clusters(h_points, FlatKernel{.5f}, queue, block_size);
+
+    std::vector<int> dynamic_results(2 * n_points);
+    CLUEAlgoAlpakaDynamic<2> dynamic_algo(dc, rhoc, outlier, pPBin);
+    dynamic_algo.make_clusters(coords.data(),
+                               dynamic_results.data(),
+                               Ndim,
+                               n_points,
+                               FlatKernel{.5f},
+                               queue,
+                               block_size);
+
+    CHECK(clue::validate_results(std::span{dynamic_results.data(), n_points},
+                                 std::span{results.data(), n_points}));
+  }
+
+}  // namespace
+
+TEST_CASE("Test that the dynamic algorithm gives the results of the static one") {
+  const auto dev_acc = alpaka::getDevByIdx(alpaka::Platform<Acc1D>{}, 0u);
+  Queue queue(dev_acc);
+
+  auto coords = read_csv<float, 2>("./sissa.csv");
+  check_dynamic<2>(queue, coords);
+  check_dynamic<3>(queue, extend_points<3>(coords));
+  check_dynamic<5>(queue, extend_points<5>(coords));
+}
+
+TEST_CASE("Test that the dynamic algorithm rejects the inputs it doesn't support") {
+  const auto dev_acc = alpaka::getDevByIdx(alpaka::Platform<Acc1D>{}, 0u);
+  Queue queue(dev_acc);
+
+  auto coords = read_csv<float, 2>("./sissa.csv");
+  const auto n_points = static_cast<uint32_t>(coords.size() / 3);
+  std::vector<int> results(2 * n_points);
+  CLUEAlgoAlpakaDynamic<2> algo(dc, rhoc, outlier, pPBin);
+
+  CHECK_THROWS_AS(
+      algo.make_clusters(
+          coords.data(), results.data(), 1, n_points, FlatKernel{.5f}, queue, block_size),
+      std::invalid_argument);
+
+  const std::array<uint8_t, 2> wrapping{0, 1};
+  CHECK_THROWS_AS(algo.make_clusters(coords.data(),
+                                     results.data(),
+                                     2,
+                                     n_points,
+                                     FlatKernel{.5f},
+                                     queue,
+                                     block_size,
+                                     wrapping),
+                  std::invalid_argument);
+}
@@ -0,0 +1,60 @@
+#include "CLUEstering.hpp"
+#include "utility/read_csv.hpp"
+#include "utility/validation.hpp"
+#include <alpaka/alpaka.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+
+using namespace ALPAKA_ACCELERATOR_NAMESPACE_CLUE;
+
+namespace {
+
+  std::vector<int> run(Queue queue,
+                       std::vector<float>& coords,
+                       uint32_t fused_points,
+                       bool reproducible) {
+    const auto n_points = static_cast<uint32_t>(coords.size() / 3);
+    std::vector<int> results(2 * n_points);
+    PointsSoA<2> h_points(coords.data(), results.data(), PointInfo<2>{n_points});
+    PointsAlpaka<2> d_points(queue, n_points);
+
+    const float dc{20.f}, rhoc{10.f}, outlier{20.f};
+    const int pPBin{128};
+    CLUEAlgoAlpaka<2> algo(dc, rhoc, outlier, pPBin, queue);
+    algo.fuseSmallEvents(fused_points);
+    algo.reproducibleResults(reproducible);
+
+    const std::size_t block_size{256};
+    algo.make_clusters(h_points, d_points, FlatKernel{.5f}, queue, block_size);
+    return results;
+  }
+
+}  // namespace
+
+TEST_CASE("Test that the fused kernel gives the results of the separate stages") {
+  const auto dev_acc = alpaka::getDevByIdx(alpaka::Platform<Acc1D>{}, 0u);
+  Queue queue(dev_acc);
+
+  auto coords = read_csv<float, 2>("./sissa.csv");
+  const auto n_points = coords.size() / 3;
+  auto truth = read_output<2>("./sissa_1000_truth.csv");
+
+  for (bool reproducible : {false, true}) {
+    auto unfused = run(queue, coords, 0, reproducible);
+    auto fused = run(queue, coords, fused_max_points, reproducible);
+    CHECK(clue::validate_results(std::span{fused.data(), n_points},
+                                 std::span{unfused.data(), n_points}));
+    CHECK(clue::validate_results(std::span{fused.data(), n_points},
+                                 std::span{truth.data(), n_points}));
+    // the seeds are the same points
+    CHECK(std::equal(fused.begin() + n_points,
+                     fused.end(),
+                     unfused.begin() + n_points,
+                     unfused.end()));
+  }
+}
@@ -0,0 +1,78 @@
+#include "CLUEstering.hpp"
+#include "utility/read_csv.hpp"
+#include "utility/validation.hpp"
+#include <alpaka/alpaka.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+
+using namespace ALPAKA_ACCELERATOR_NAMESPACE_CLUE;
+
+namespace {
+
+  const float dc{20.f}, rhoc{10.f}, outlier{20.f};
+  const int pPBin{128};
+  const std::size_t block_size{256};
+
+  std::vector<int> run(Queue queue,
+                       CLUEAlgoAlpaka<2>& algo,
+                       std::vector<float>& coords,
+                       const std::array<uint8_t, 2>& wrapping) {
+    const auto n_points = static_cast<uint32_t>(coords.size() / 3);
+    std::vector<int> results(2 * n_points);
+    PointsSoA<2> h_points(
+        coords.data(), results.data(), PointInfo<2>{n_points, wrapping});
+    algo.make_clusters(h_points, FlatKernel{.5f}, queue, block_size);
+    results.resize(n_points);
+    return results;
+  }
+
+  // Keeps the points with even index, which changes the number of ghosts
+  std::vector<float> half_points(const std::vector<float>& coords) {
+    const auto n_points = coords.size() / 3;
+    const auto n_half = (n_points + 1) / 2;
+    std::vector<float> half(3 * n_half);
+    for (std::size_t dim = 0; dim < 3; ++dim) {
+      for (std::size_t i = 0; i < n_half; ++i) {
+        half[dim * n_half + i] = coords[dim * n_points + 2 * i];
+      }
+    }
+    return half;
+  }
+
+}  // namespace
+
+// The wrapped run searches the nearest higher without wrapping the coordinates, so at
+// this distance no point has its nearest higher across the boundary and the two runs
+// must find the same clusters
+TEST_CASE("Test that the halo wrapping gives the clusters of the wrapped tiles") {
+  const auto dev_acc = alpaka::getDevByIdx(alpaka::Platform<Acc1D>{}, 0u);
+  Queue queue(dev_acc);
+
+  auto coords = read_csv<float, 2>("./sissa.csv");
+  auto half = half_points(coords);
+  for (const auto wrapping :
+       {std::array<uint8_t, 2>{1, 0}, std::array<uint8_t, 2>{0, 1},
+        std::array<uint8_t, 2>{1, 1}}) {
+    CLUEAlgoAlpaka<2> wrapped_algo(dc, rhoc, outlier, pPBin, queue);
+    CLUEAlgoAlpaka<2> halo_algo(dc, rhoc, outlier, pPBin, queue);
+    halo_algo.haloWrapping(true);
+
+    auto expected = run(queue, wrapped_algo, coords, wrapping);
+    auto result = run(queue, halo_algo, coords, wrapping);
+    CHECK(clue::validate_results(std::span{result.data(), result.size()},
+                                 std::span{expected.data(), expected.size()}));
+
+    // the buffers of the points and of their ghosts are reused by the following runs
+    auto expected_half = run(queue, wrapped_algo, half, wrapping);
+    auto result_half = run(queue, halo_algo, half, wrapping);
+    CHECK(clue::validate_results(std::span{result_half.data(), result_half.size()},
+                                 std::span{expected_half.data(), expected_half.size()}));
+    CHECK(run(queue, halo_algo, coords, wrapping) == result);
+  }
+}
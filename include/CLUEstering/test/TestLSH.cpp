@@ -0,0 +1,89 @@
+#include "CLUEsteringDynamic.hpp"
+#include "utility/read_csv.hpp"
+#include "utility/validation.hpp"
+#include <alpaka/alpaka.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+
+using namespace ALPAKA_ACCELERATOR_NAMESPACE_CLUE;
+
+namespace {
+
+  const float dc{20.f}, rhoc{10.f}, outlier{20.f};
+  const int pPBin{128};
+  const int32_t ndim{16};
+
+  // Embeds the two-dimensional points in a random plane of ndim dimensions, which
+  // keeps their distances
+  std::vector<float> embed_points(const std::vector<float>& coords) {
+    const auto n_points = coords.size() / 3;
+    const auto basis = clue::randomProjectionBasis(ndim, 2, 7);
+    std::vector<float> embedded((ndim + 1) * n_points);
+    for (std::size_t i = 0; i < n_points; ++i) {
+      for (int32_t dim = 0; dim < ndim; ++dim) {
+        embedded[i + dim * n_points] =
+            coords[i] * basis[dim] + coords[i + n_points] * basis[ndim + dim];
+      }
+      embedded[i + ndim * n_points] = coords[i + 2 * n_points];
+    }
+    return embedded;
+  }
+
+  std::vector<int> run(Queue queue,
+                       std::vector<float>& coords,
+                       std::optional<clue::LSHParameters> lsh,
+                       bool reproducible,
+                       std::size_t block_size) {
+    const auto n_points = static_cast<uint32_t>(coords.size() / (ndim + 1));
+    std::vector<int> results(2 * n_points);
+    CLUEAlgoAlpakaDynamic<2> algo(dc, rhoc, outlier, pPBin);
+    if (lsh.has_value()) {
+      algo.useLSH(*lsh);
+    }
+    algo.reproducibleResults(reproducible);
+    algo.make_clusters(coords.data(),
+                       results.data(),
+                       ndim,
+                       n_points,
+                       FlatKernel{.5f},
+                       queue,
+                       block_size);
+    return results;
+  }
+
+}  // namespace
+
+TEST_CASE("Test that the hashing finds the clusters of the exact search") {
+  const auto dev_acc = alpaka::getDevByIdx(alpaka::Platform<Acc1D>{}, 0u);
+  Queue queue(dev_acc);
+
+  auto coords = embed_points(read_csv<float, 2>("./sissa.csv"));
+  const auto n_points = coords.size() / (ndim + 1);
+
+  const clue::LSHParameters lsh{.n_tables = 16, .n_hashes = 2, .seed = 1};
+  for (bool reproducible : {false, true}) {
+    auto exact = run(queue, coords, std::nullopt, reproducible, 256);
+    auto hashed = run(queue, coords, lsh, reproducible, 256);
+    CHECK(clue::validate_results(std::span{hashed.data(), n_points},
+                                 std::span{exact.data(), n_points}));
+  }
+}
+
+TEST_CASE("Test that the hashing gives reproducible results") {
+  const auto dev_acc = alpaka::getDevByIdx(alpaka::Platform<Acc1D>{}, 0u);
+  Queue queue(dev_acc);
+
+  auto coords = embed_points(read_csv<float, 2>("./sissa.csv"));
+
+  const clue::LSHParameters lsh{.n_tables = 4, .n_hashes = 2, .seed = 1};
+  auto reference = run(queue, coords, lsh, true, 256);
+  for (std::size_t block_size : {32, 64, 1024}) {
+    CHECK(run(queue, coords, lsh, true, block_size) == reference);
+  }
+}
@@ -0,0 +1,75 @@
+#include "CLUEsteringMPI.hpp"
+#include "utility/read_csv.hpp"
+#include "utility/validation.hpp"
+#include <alpaka/alpaka.hpp>
+
+#include <vector>
+
+#define DOCTEST_CONFIG_IMPLEMENT
+#include "doctest.h"
+
+using namespace ALPAKA_ACCELERATOR_NAMESPACE_CLUE;
+
+// Each process takes a contiguous block of the points, which are spread over all the
+// space, so that their global indexes are the same as in the file. Run with
+// mpirun -np 4 ./mpi.out
+TEST_CASE("Test distributed clustering") {
+  const auto dev_acc = alpaka::getDevByIdx(alpaka::Platform<Acc1D>{}, 0u);
+  Queue queue(dev_acc);
+
+  int rank, size;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+  auto coords = read_csv<float, 2>("./sissa.csv");
+  const auto n_points = static_cast<uint32_t>(coords.size() / 3);
+  const uint32_t first = static_cast<uint64_t>(n_points) * rank / size;
+  const uint32_t last = static_cast<uint64_t>(n_points) * (rank + 1) / size;
+  const auto n_local = last - first;
+  std::vector<float> local_coords;
+  for (uint32_t dim{}; dim != 3; ++dim) {
+    local_coords.insert(local_coords.end(),
+                        coords.begin() + first + dim * n_points,
+                        coords.begin() + last + dim * n_points);
+  }
+  std::vector<int> results(2 * n_local);
+
+  PointsSoA<2> h_points(local_coords.data(), results.data(), PointInfo<2>{n_local});
+
+  const float dc{20.f}, rhoc{10.f}, outlier{20.f};
+  const int pPBin{128};
+  CLUEAlgoMPI<2> algo(dc, rhoc, outlier, pPBin, queue, MPI_COMM_WORLD);
+
+  const std::size_t block_size{256};
+  algo.make_clusters(h_points, FlatKernel{.5f}, queue, block_size);
+
+  // collect the cluster indexes of all the points
+  std::vector<int> counts(size), displs(size);
+  const int count = static_cast<int>(n_local);
+  MPI_Allgather(&count, 1, MPI_INT, counts.data(), 1, MPI_INT, MPI_COMM_WORLD);
+  for (int r{1}; r != size; ++r) {
+    displs[r] = displs[r - 1] + counts[r - 1];
+  }
+  std::vector<int> cluster_indexes(n_points);
+  MPI_Allgatherv(results.data(),
+                 count,
+                 MPI_INT,
+                 cluster_indexes.data(),
+                 counts.data(),
+                 displs.data(),
+                 MPI_INT,
+                 MPI_COMM_WORLD);
+
+  auto truth = read_output<2>("./sissa_1000_truth.csv");
+
+  CHECK(clue::validate_results(std::span{cluster_indexes.data(), n_points},
+                               std::span{truth.data(), n_points}));
+}
+
+int main(int argc, char** argv) {
+  MPI_Init(&argc, &argv);
+  doctest::Context context(argc, argv);
+  const int result = context.run();
+  MPI_Finalize();
+  return result;
+}
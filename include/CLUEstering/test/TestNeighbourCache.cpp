@@ -0,0 +1,53 @@
+#include "CLUEstering.hpp"
+#include "utility/read_csv.hpp"
+#include "utility/validation.hpp"
+#include <alpaka/alpaka.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+
+using namespace ALPAKA_ACCELERATOR_NAMESPACE_CLUE;
+
+namespace {
+
+  const float rhoc{10.f};
+  const int pPBin{128};
+  const std::size_t block_size{256};
+
+  std::vector<int> run(Queue queue, std::vector<float>& coords, float dc, bool cache) {
+    const auto n_points = static_cast<uint32_t>(coords.size() / 3);
+    std::vector<int> results(2 * n_points);
+    PointsSoA<2> h_points(coords.data(), results.data(), PointInfo<2>{n_points});
+    PointsAlpaka<2> d_points(queue, n_points);
+    // the cache is only used when the outlier distance doesn't exceed dc
+    CLUEAlgoAlpaka<2> algo(dc, rhoc, dc, pPBin, queue);
+    algo.cacheNeighbours(cache);
+    algo.make_clusters(h_points, d_points, FlatKernel{.5f}, queue, block_size);
+    return results;
+  }
+
+}  // namespace
+
+// At the larger distance many points have more than max_neighbours neighbours, which
+// are searched again in the tiles instead of being read from the cache
+TEST_CASE("Test that the neighbour cache doesn't change the clusters") {
+  const auto dev_acc = alpaka::getDevByIdx(alpaka::Platform<Acc1D>{}, 0u);
+  Queue queue(dev_acc);
+
+  auto coords = read_csv<float, 2>("./sissa.csv");
+  const auto n_points = coords.size() / 3;
+  auto truth = read_output<2>("./sissa_1000_truth.csv");
+  for (float dc : {20.f, 60.f}) {
+    auto expected = run(queue, coords, dc, false);
+    auto result = run(queue, coords, dc, true);
+    CHECK(result == expected);
+    if (dc == 20.f) {
+      CHECK(clue::validate_results(std::span{result.data(), n_points},
+                                   std::span{truth.data(), n_points}));
+    }
+  }
+}
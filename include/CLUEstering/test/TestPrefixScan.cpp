@@ -0,0 +1,43 @@
+#include "AlpakaCore/prefixScan.hpp"
+#include "CLUEstering.hpp"
+#include <alpaka/alpaka.hpp>
+
+#include <cstdint>
+#include <vector>
+
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+
+using namespace ALPAKA_ACCELERATOR_NAMESPACE_CLUE;
+
+// The CPU backends scan blocks of 4096 elements and the GPU backends blocks of 1024,
+// so the sizes around both cover the empty, partial and multiple blocks
+TEST_CASE("Test the inclusive prefix scan against a serial scan") {
+  const auto dev_acc = alpaka::getDevByIdx(alpaka::Platform<Acc1D>{}, 0u);
+  Queue queue(dev_acc);
+
+  const std::vector<uint32_t> sizes{
+      0u, 1u, 1023u, 1024u, 1025u, 4095u, 4096u, 4097u, 5u * 4096u + 17u};
+  for (uint32_t size : sizes) {
+    std::vector<uint32_t> input(size);
+    for (uint32_t i = 0; i < size; ++i) {
+      input[i] = (i * 7u + 3u) % 11u;
+    }
+    std::vector<uint32_t> expected(size);
+    uint32_t sum{0};
+    for (uint32_t i = 0; i < size; ++i) {
+      sum += input[i];
+      expected[i] = sum;
+    }
+
+    auto d_input = clue::make_device_buffer<uint32_t[]>(queue, size);
+    auto d_output = clue::make_device_buffer<uint32_t[]>(queue, size);
+    alpaka::memcpy(queue, d_input, clue::make_host_view(input.data(), size));
+    clue::inclusivePrefixScan<Acc1D>(queue, d_input.data(), d_output.data(), size);
+    std::vector<uint32_t> output(size);
+    alpaka::memcpy(queue, clue::make_host_view(output.data(), size), d_output);
+    alpaka::wait(queue);
+
+    CHECK(output == expected);
+  }
+}
@@ -0,0 +1,75 @@
+#include "CLUEstering.hpp"
+#include "utility/read_csv.hpp"
+#include "utility/validation.hpp"
+#include <alpaka/alpaka.hpp>
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+
+using namespace ALPAKA_ACCELERATOR_NAMESPACE_CLUE;
+
+TEST_CASE("Test the reductions of the clusters against the host") {
+  const auto dev_acc = alpaka::getDevByIdx(alpaka::Platform<Acc1D>{}, 0u);
+  Queue queue(dev_acc);
+
+  auto coords = read_csv<float, 2>("./sissa.csv");
+  const auto n_points = static_cast<uint32_t>(coords.size() / 3);
+  const float* weights = coords.data() + 2 * n_points;
+
+  // at both distances the largest clusters have more than reduction_chunk_size
+  // points, so they are reduced by several blocks
+  for (float dc : {20.f, 80.f}) {
+    std::vector<int> results(2 * n_points);
+    PointsSoA<2> h_points(coords.data(), results.data(), PointInfo<2>{n_points});
+    PointsAlpaka<2> d_points(queue, n_points);
+    CLUEAlgoAlpaka<2> algo(dc, 10.f, dc, 128, queue);
+    algo.make_clusters(h_points, d_points, FlatKernel{.5f}, queue, 256);
+
+    const auto weight_sums =
+        algo.reduce_clusters(h_points, d_points, WeightSum{}, queue, 256);
+    const auto centroids =
+        algo.reduce_clusters(h_points, d_points, Centroid<2>{}, queue, 256);
+    const auto max_weights =
+        algo.reduce_clusters(h_points, d_points, MaxWeightPoint{}, queue, 256);
+
+    const auto n_clusters =
+        clue::compute_nclusters(std::span<const int>{results.data(), n_points});
+    REQUIRE(weight_sums.size() == static_cast<std::size_t>(n_clusters));
+    REQUIRE(centroids.size() == static_cast<std::size_t>(n_clusters));
+    REQUIRE(max_weights.size() == static_cast<std::size_t>(n_clusters));
+
+    std::vector<double> weight(n_clusters), x(n_clusters), y(n_clusters);
+    std::vector<int> max_weight_point(n_clusters, -1);
+    for (uint32_t i = 0; i < n_points; ++i) {
+      const auto cluster = results[i];
+      if (cluster < 0) {
+        continue;
+      }
+      weight[cluster] += weights[i];
+      x[cluster] += weights[i] * coords[i];
+      y[cluster] += weights[i] * coords[n_points + i];
+      // the points are visited by index, so the ties go to the smallest one
+      const auto current = max_weight_point[cluster];
+      if (current < 0 or weights[i] > weights[current]) {
+        max_weight_point[cluster] = i;
+      }
+    }
+
+    for (int cluster = 0; cluster < n_clusters; ++cluster) {
+      CHECK(std::abs(weight_sums[cluster] - weight[cluster]) <= 1e-4 * weight[cluster]);
+      CHECK(std::abs(centroids[cluster].weight - weight[cluster]) <=
+            1e-4 * weight[cluster]);
+      CHECK(std::abs(centroids[cluster].coords[0] - x[cluster] / weight[cluster]) <=
+            1e-3);
+      CHECK(std::abs(centroids[cluster].coords[1] - y[cluster] / weight[cluster]) <=
+            1e-3);
+      CHECK(max_weights[cluster].index == max_weight_point[cluster]);
+      CHECK(max_weights[cluster].weight == weights[max_weight_point[cluster]]);
+    }
+  }
+}
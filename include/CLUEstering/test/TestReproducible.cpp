@@ -0,0 +1,60 @@
+#include "CLUEstering.hpp"
+#include "utility/read_csv.hpp"
+#include <alpaka/alpaka.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+
+using namespace ALPAKA_ACCELERATOR_NAMESPACE_CLUE;
+
+namespace {
+
+  const float dc{20.f}, rhoc{10.f}, outlier{20.f};
+
+  struct Result {
+    std::vector<int> labels;
+    std::vector<float> densities;
+  };
+
+  Result run(Queue queue,
+             std::vector<float>& coords,
+             int points_per_tile,
+             bool tile_pairs,
+             std::size_t block_size) {
+    const auto n_points = static_cast<uint32_t>(coords.size() / 3);
+    std::vector<int> results(2 * n_points);
+    PointsSoA<2> h_points(coords.data(), results.data(), PointInfo<2>{n_points});
+    PointsAlpaka<2> d_points(queue, n_points);
+    CLUEAlgoAlpaka<2> algo(dc, rhoc, outlier, points_per_tile, queue);
+    algo.reproducibleResults(true);
+    algo.tileInteractionLists(tile_pairs);
+    algo.make_clusters(
+        h_points, d_points, GaussianKernel{0.f, 10.f, 1.f}, queue, block_size);
+    return Result{results, algo.getDensity(d_points, queue)};
+  }
+
+}  // namespace
+
+// The size of the tiles and the tile interaction lists change the order in which the
+// neighbours are visited, and the block size changes the order in which the seeds
+// are found, while the reproducible mode must give the same densities and labels
+TEST_CASE("Test that the reproducible mode doesn't depend on the neighbour order") {
+  const auto dev_acc = alpaka::getDevByIdx(alpaka::Platform<Acc1D>{}, 0u);
+  Queue queue(dev_acc);
+
+  auto coords = read_csv<float, 2>("./sissa.csv");
+  const auto reference = run(queue, coords, 128, false, 256);
+  for (int points_per_tile : {16, 128, 512}) {
+    for (bool tile_pairs : {false, true}) {
+      for (std::size_t block_size : {32, 256, 1024}) {
+        const auto result = run(queue, coords, points_per_tile, tile_pairs, block_size);
+        CHECK(result.densities == reference.densities);
+        CHECK(result.labels == reference.labels);
+      }
+    }
+  }
+}
@@ -0,0 +1,97 @@
+#include "CLUEstering.hpp"
+#include "CLUEsteringDynamic.hpp"
+#include "utility/read_csv.hpp"
+#include <alpaka/alpaka.hpp>
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+
+using namespace ALPAKA_ACCELERATOR_NAMESPACE_CLUE;
+
+namespace {
+
+  const float dc{20.f}, rhoc{10.f}, outlier{20.f};
+  const int pPBin{128};
+  const std::size_t block_size{256};
+
+  struct Result {
+    std::vector<int> labels;
+    std::vector<float> densities;
+  };
+
+  // Runs the static algorithm, whose densities use the batch overload of the kernel
+  template <typename KernelType>
+  Result run(Queue queue, std::vector<float>& coords, const KernelType& kernel) {
+    const auto n_points = static_cast<uint32_t>(coords.size() / 3);
+    std::vector<int> results(2 * n_points);
+    PointsSoA<2> h_points(coords.data(), results.data(), PointInfo<2>{n_points});
+    PointsAlpaka<2> d_points(queue, n_points);
+    CLUEAlgoAlpaka<2> algo(dc, rhoc, outlier, pPBin, queue);
+    algo.make_clusters(h_points, d_points, kernel, queue, block_size);
+    results.resize(n_points);
+    return Result{results, algo.getDensity(d_points, queue)};
+  }
+
+  // Runs the dynamic algorithm, whose densities use the scalar overload of the kernel
+  template <typename KernelType>
+  std::vector<int> run_dynamic(Queue queue,
+                               std::vector<float>& coords,
+                               const KernelType& kernel) {
+    const auto n_points = static_cast<uint32_t>(coords.size() / 3);
+    std::vector<int> results(2 * n_points);
+    CLUEAlgoAlpakaDynamic<2> algo(dc, rhoc, outlier, pPBin);
+    algo.make_clusters(
+        coords.data(), results.data(), 2, n_points, kernel, queue, block_size);
+    results.resize(n_points);
+    return results;
+  }
+
+  template <typename KernelType>
+  void check_kernel(Queue queue, std::vector<float>& coords, const KernelType& kernel) {
+    const auto expected = run(queue, coords, kernel);
+    const auto result = run(queue, coords, RuntimeKernel{kernel});
+    CHECK(result.labels == expected.labels);
+    CHECK(result.densities == expected.densities);
+
+    CHECK(run_dynamic(queue, coords, RuntimeKernel{kernel}) ==
+          run_dynamic(queue, coords, kernel));
+  }
+
+}  // namespace
+
+TEST_CASE("Test that a runtime kernel gives the results of the kernel it wraps") {
+  const auto dev_acc = alpaka::getDevByIdx(alpaka::Platform<Acc1D>{}, 0u);
+  Queue queue(dev_acc);
+
+  auto coords = read_csv<float, 2>("./sissa.csv");
+  check_kernel(queue, coords, FlatKernel{.5f});
+  check_kernel(queue, coords, ExponentialKernel{.1f, 1.f});
+  check_kernel(queue, coords, GaussianKernel{0.f, 10.f, 1.f});
+  check_kernel(queue, coords, GaussianKernel{5.f, 10.f, 1.f});
+}
+
+TEST_CASE("Test that the density of a sum of kernels is the sum of their densities") {
+  const auto dev_acc = alpaka::getDevByIdx(alpaka::Platform<Acc1D>{}, 0u);
+  Queue queue(dev_acc);
+
+  auto coords = read_csv<float, 2>("./sissa.csv");
+  const auto n_points = coords.size() / 3;
+  const FlatKernel flat{.5f};
+  const GaussianKernel gaussian{0.f, 10.f, 1.f};
+  const auto flat_densities = run(queue, coords, flat).densities;
+  const auto gaussian_densities = run(queue, coords, gaussian).densities;
+  const auto sum_densities =
+      run(queue, coords, RuntimeKernel{flat} + RuntimeKernel{gaussian}).densities;
+
+  // the point itself is counted once in the density of the sum
+  for (std::size_t i = 0; i < n_points; ++i) {
+    const auto expected =
+        flat_densities[i] + gaussian_densities[i] - coords[2 * n_points + i];
+    CHECK(std::abs(sum_densities[i] - expected) <= 1e-4f * expected);
+  }
+}
@@ -0,0 +1,127 @@
+#include "CLUEstering.hpp"
+#include "utility/read_csv.hpp"
+#include "utility/validation.hpp"
+#include <alpaka/alpaka.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+
+using namespace ALPAKA_ACCELERATOR_NAMESPACE_CLUE;
+
+namespace {
+
+  const float dc{20.f}, rhoc{10.f}, outlier{20.f};
+  const int pPBin{128};
+  const std::size_t block_size{256};
+
+  // Clusters on their own the selected points, copied to a separate buffer
+  std::vector<int> run_extracted(Queue queue,
+                                 const std::vector<float>& coords,
+                                 const std::vector<uint32_t>& selected) {
+    const auto n_points = static_cast<uint32_t>(coords.size() / 3);
+    const auto n_selected = static_cast<uint32_t>(selected.size());
+    std::vector<float> extracted(3 * n_selected);
+    for (uint32_t i = 0; i < n_selected; ++i) {
+      for (int dim = 0; dim < 3; ++dim) {
+        extracted[i + dim * n_selected] = coords[selected[i] + dim * n_points];
+      }
+    }
+
+    std::vector<int> results(2 * n_selected);
+    PointsSoA<2> h_points(extracted.data(), results.data(), PointInfo<2>{n_selected});
+    CLUEAlgoAlpaka<2> algo(dc, rhoc, outlier, pPBin, queue);
+    algo.make_clusters(h_points, FlatKernel{.5f}, queue, block_size);
+    return results;
+  }
+
+  void check_subset(const std::vector<int>& results,
+                    const std::vector<int>& expected,
+                    const std::vector<uint8_t>& mask) {
+    const auto n_points = mask.size();
+    std::vector<int> subset_ids;
+    for (std::size_t i = 0; i < n_points; ++i) {
+      if (mask[i]) {
+        subset_ids.push_back(results[i]);
+      } else {
+        CHECK(results[i] == -1);
+        CHECK(results[n_points + i] == 0);
+      }
+    }
+    CHECK(clue::validate_results(
+        std::span{subset_ids.data(), subset_ids.size()},
+        std::span{expected.data(), subset_ids.size()}));
+  }
+
+}  // namespace
+
+TEST_CASE("Test that a subset gives the results of its points clustered alone") {
+  const auto dev_acc = alpaka::getDevByIdx(alpaka::Platform<Acc1D>{}, 0u);
+  Queue queue(dev_acc);
+
+  auto coords = read_csv<float, 2>("./sissa.csv");
+  const auto n_points = static_cast<uint32_t>(coords.size() / 3);
+  std::vector<int> results(2 * n_points);
+  PointsSoA<2> h_points(coords.data(), results.data(), PointInfo<2>{n_points});
+  PointsAlpaka<2> d_points(queue, n_points);
+
+  CLUEAlgoAlpaka<2> algo(dc, rhoc, outlier, pPBin, queue);
+  algo.uploadPoints(h_points, d_points, queue, block_size);
+
+  auto d_mask = clue::make_device_buffer<uint8_t[]>(queue, n_points);
+  auto d_selected = clue::make_device_buffer<uint32_t[]>(queue, n_points);
+
+  // the subsets shrink and grow again, so that the buffers of the previous run
+  // are reused
+  for (uint32_t stride : {2u, 5u, 3u}) {
+    std::vector<uint8_t> mask(n_points);
+    std::vector<uint32_t> selected;
+    for (uint32_t i = 0; i < n_points; ++i) {
+      mask[i] = i % stride != 0;
+      if (mask[i]) {
+        selected.push_back(i);
+      }
+    }
+    const auto n_selected = static_cast<uint32_t>(selected.size());
+    const auto expected = run_extracted(queue, coords, selected);
+
+    alpaka::memcpy(queue, d_mask, clue::make_host_view(mask.data(), n_points));
+    algo.make_clusters(
+        h_points, d_points, d_mask.data(), FlatKernel{.5f}, queue, block_size);
+    check_subset(results, expected, mask);
+
+    alpaka::memcpy(
+        queue, d_selected, clue::make_host_view(selected.data(), n_selected));
+    algo.make_clusters(h_points,
+                       d_points,
+                       d_selected.data(),
+                       n_selected,
+                       FlatKernel{.5f},
+                       queue,
+                       block_size);
+    check_subset(results, expected, mask);
+  }
+
+  // an empty selection clusters none of the points
+  algo.make_clusters(
+      h_points, d_points, d_selected.data(), 0, FlatKernel{.5f}, queue, block_size);
+  check_subset(results, {}, std::vector<uint8_t>(n_points, 0));
+}
+
+TEST_CASE("Test a mask over an empty set of points") {
+  const auto dev_acc = alpaka::getDevByIdx(alpaka::Platform<Acc1D>{}, 0u);
+  Queue queue(dev_acc);
+
+  std::vector<float> coords;
+  std::vector<int> results;
+  PointsSoA<2> h_points(coords.data(), results.data(), PointInfo<2>{0});
+  PointsAlpaka<2> d_points(queue, 0);
+
+  CLUEAlgoAlpaka<2> algo(dc, rhoc, outlier, pPBin, queue);
+  algo.uploadPoints(h_points, d_points, queue, block_size);
+  CHECK_NOTHROW(algo.make_clusters(
+      h_points, d_points, nullptr, FlatKernel{.5f}, queue, block_size));
+}
@@ -0,0 +1,64 @@
+#include "CLUEstering.hpp"
+#include "utility/read_csv.hpp"
+#include "utility/validation.hpp"
+#include <alpaka/alpaka.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+
+using namespace ALPAKA_ACCELERATOR_NAMESPACE_CLUE;
+
+namespace {
+
+  const float rhoc{10.f}, outlier{20.f};
+  const std::size_t block_size{256};
+
+  std::vector<int> run(Queue queue,
+                       std::vector<float>& coords,
+                       float dc,
+                       int points_per_tile,
+                       bool tile_pairs) {
+    const auto n_points = static_cast<uint32_t>(coords.size() / 3);
+    std::vector<int> results(2 * n_points);
+    PointsSoA<2> h_points(coords.data(), results.data(), PointInfo<2>{n_points});
+    PointsAlpaka<2> d_points(queue, n_points);
+    CLUEAlgoAlpaka<2> algo(dc, rhoc, outlier, points_per_tile, queue);
+    algo.tileInteractionLists(tile_pairs);
+    algo.make_clusters(h_points, d_points, FlatKernel{.5f}, queue, block_size);
+    return results;
+  }
+
+}  // namespace
+
+// The size of the tiles changes the number of tiles in each interaction list and the
+// number of blocks of points in each tile
+TEST_CASE("Test that the tile interaction lists don't change the clusters") {
+  const auto dev_acc = alpaka::getDevByIdx(alpaka::Platform<Acc1D>{}, 0u);
+  Queue queue(dev_acc);
+
+  auto coords = read_csv<float, 2>("./sissa.csv");
+  const auto n_points = coords.size() / 3;
+  auto truth = read_output<2>("./sissa_1000_truth.csv");
+  for (float dc : {20.f, 60.f}) {
+    for (int points_per_tile : {16, 128, 512}) {
+      auto expected = run(queue, coords, dc, points_per_tile, false);
+      auto result = run(queue, coords, dc, points_per_tile, true);
+      // the seeds are enumerated in a different order, so only the clusters match
+      CHECK(clue::validate_results(std::span{result.data(), n_points},
+                                   std::span{expected.data(), n_points}));
+      CHECK(std::equal(result.begin() + n_points,
+                       result.end(),
+                       expected.begin() + n_points,
+                       expected.end()));
+      if (dc == 20.f) {
+        CHECK(clue::validate_results(std::span{result.data(), n_points},
+                                     std::span{truth.data(), n_points}));
+      }
+    }
+  }
+}
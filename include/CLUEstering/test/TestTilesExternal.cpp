@@ -19,7 +19,7 @@ TEST_CASE("Test clustering using externally defined Tiles") {
   const auto n_points = coords.size() / 3;
   std::vector<int> results(2 * n_points);
 
-  PointsSoA<2> h_points(coords.data(), results.data(), PointShape<2>{n_points});
+  PointsSoA<2> h_points(coords.data(), results.data(), PointInfo<2>{n_points});
   PointsAlpaka<2> d_points(queue, n_points);
 
   const float dc{20.f}, rhoc{10.f}, outlier{20.f};
@@ -47,7 +47,7 @@ TEST_CASE("Test clustering using Tiles from allocated buffer") {
   const auto n_points = coords.size() / 3;
   std::vector<int> results(2 * n_points);
 
-  PointsSoA<2> h_points(coords.data(), results.data(), PointShape<2>{n_points});
+  PointsSoA<2> h_points(coords.data(), results.data(), PointInfo<2>{n_points});
   PointsAlpaka<2> d_points(queue, n_points);
 
   const float dc{20.f}, rhoc{10.f}, outlier{20.f};
@@ -77,7 +77,7 @@ TEST_CASE("Test clustering using Tiles from allocated large buffer") {
   const auto n_points = coords.size() / 3;
   std::vector<int> results(2 * n_points);
 
-  PointsSoA<2> h_points(coords.data(), results.data(), PointShape<2>{n_points});
+  PointsSoA<2> h_points(coords.data(), results.data(), PointInfo<2>{n_points});
   PointsAlpaka<2> d_points(queue, n_points);
 
   const float dc{20.f}, rhoc{10.f}, outlier{20.f};
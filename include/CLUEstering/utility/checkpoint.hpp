@@ -0,0 +1,139 @@
+#pragma once
+
+#include <alpaka/alpaka.hpp>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <optional>
+#include <ostream>
+#include <stdexcept>
+#include <vector>
+
+#include "../AlpakaCore/alpakaMemory.hpp"
+
+// Binary checkpoints of the intermediate state of the algorithm, which allow to resume
+// a run from the last stage that was completed.
+// A checkpoint starts with a header, that identifies the format, the parameters, the
+// hash of the input and the last completed stage, followed by the buffers written by
+// that stage and the previous ones. The buffers are written with the native layout
+// and endianness, so a checkpoint can only be read by the same build of the library.
+namespace clue {
+
+  // Stages of the algorithm, in the order in which they are run
+  enum class Stage : uint8_t {
+    none = 0,
+    tiles,
+    density,
+    nearest_higher,
+    classification,
+    assignment
+  };
+
+  struct CheckpointHeader {
+    static constexpr char magic_string[8] = {'C', 'L', 'U', 'E', 'C', 'K', 'P', 'T'};
+    static constexpr uint32_t current_version{2};
+
+    char magic[8];
+    uint32_t version;
+    uint32_t ndim;
+    uint32_t n_points;
+    float dc;
+    float rhoc;
+    float dm;
+    int32_t points_per_tile;
+    // hash of the coordinates, the weights and all the parameters of the clustering
+    uint64_t input_hash;
+    Stage stage;
+
+    // Returns true if the checkpoint was written for the same points and parameters
+    bool compatible(const CheckpointHeader& other) const {
+      return std::memcmp(magic, other.magic, sizeof(magic)) == 0 and
+             version == other.version and ndim == other.ndim and
+             n_points == other.n_points and dc == other.dc and rhoc == other.rhoc and
+             dm == other.dm and points_per_tile == other.points_per_tile and
+             input_hash == other.input_hash;
+    }
+  };
+
+  inline CheckpointHeader make_checkpoint_header(uint32_t ndim,
+                                                 uint32_t n_points,
+                                                 float dc,
+                                                 float rhoc,
+                                                 float dm,
+                                                 int32_t points_per_tile,
+                                                 uint64_t input_hash,
+                                                 Stage stage) {
+    CheckpointHeader header{};
+    std::memcpy(header.magic, CheckpointHeader::magic_string, sizeof(header.magic));
+    header.version = CheckpointHeader::current_version;
+    header.ndim = ndim;
+    header.n_points = n_points;
+    header.dc = dc;
+    header.rhoc = rhoc;
+    header.dm = dm;
+    header.points_per_tile = points_per_tile;
+    header.input_hash = input_hash;
+    header.stage = stage;
+    return header;
+  }
+
+  template <typename T>
+  inline void write_array(std::ostream& out, const T* data, std::size_t size) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    out.write(reinterpret_cast<const char*>(data), size * sizeof(T));
+    if (!out) {
+      throw std::runtime_error("Error while writing the checkpoint");
+    }
+  }
+
+  template <typename T>
+  inline void read_array(std::istream& in, T* data, std::size_t size) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    in.read(reinterpret_cast<char*>(data), size * sizeof(T));
+    if (!in) {
+      throw std::runtime_error("The checkpoint is truncated or corrupted");
+    }
+  }
+
+  // Returns the header of the checkpoint, or an empty optional if the stream doesn't
+  // contain a checkpoint
+  inline std::optional<CheckpointHeader> read_checkpoint_header(std::istream& in) {
+    CheckpointHeader header;
+    in.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!in or std::memcmp(header.magic,
+                           CheckpointHeader::magic_string,
+                           sizeof(header.magic)) != 0) {
+      return std::nullopt;
+    }
+    return header;
+  }
+
+  // Copies an array from the device and writes it to the stream
+  template <typename TQueue, typename T>
+  inline void write_device_array(std::ostream& out,
+                                 TQueue& queue,
+                                 const T* d_data,
+                                 std::size_t size) {
+    std::vector<T> h_data(size);
+    alpaka::memcpy(queue,
+                   make_host_view(h_data.data(), size),
+                   make_device_view(alpaka::getDev(queue), d_data, size));
+    alpaka::wait(queue);
+    write_array(out, h_data.data(), size);
+  }
+
+  // Reads an array from the stream and copies it to the device
+  template <typename TQueue, typename T>
+  inline void read_device_array(std::istream& in,
+                                TQueue& queue,
+                                T* d_data,
+                                std::size_t size) {
+    std::vector<T> h_data(size);
+    read_array(in, h_data.data(), size);
+    alpaka::memcpy(queue,
+                   make_device_view(alpaka::getDev(queue), d_data, size),
+                   make_host_view(h_data.data(), size));
+    alpaka::wait(queue);
+  }
+
+}  // namespace clue
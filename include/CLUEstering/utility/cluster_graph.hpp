@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Adjacency graph of the clusters, where two clusters are linked when a pair of their
+// points lies within a given distance. The graph is undirected, so each edge appears
+// in the lists of both its clusters.
+namespace clue {
+
+  struct ClusterGraph {
+    // the neighbours of the cluster c are at indexes offsets[c] to offsets[c + 1] of
+    // neighbours, in ascending order
+    std::vector<uint32_t> offsets;
+    std::vector<int32_t> neighbours;
+    // smallest distance between the points of the two clusters of each edge
+    std::vector<float> min_distances;
+    // sum of the weights of the points of the two clusters of each edge that are
+    // within the distance from the other cluster
+    std::vector<float> boundary_weights;
+
+    int32_t nClusters() const { return static_cast<int32_t>(offsets.size()) - 1; }
+    std::span<const int32_t> neighboursOf(int32_t cluster) const {
+      return std::span{neighbours}.subspan(offsets[cluster],
+                                           offsets[cluster + 1] - offsets[cluster]);
+    }
+  };
+
+}  // namespace clue
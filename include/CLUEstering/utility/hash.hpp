@@ -0,0 +1,116 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+// Fast non-cryptographic hashing of the input buffers, used as key of the result cache.
+// The buffer is split in chunks of fixed size, which are hashed in parallel and whose
+// hashes are then combined in order, so the result doesn't depend on the number of
+// threads. Each chunk is hashed with four independent lanes, which the compiler can
+// vectorise, following the structure of xxHash64.
+namespace clue {
+
+  namespace detail {
+
+    inline constexpr uint64_t prime1{0x9e3779b185ebca87ull};
+    inline constexpr uint64_t prime2{0xc2b2ae3d27d4eb4full};
+    inline constexpr uint64_t prime3{0x165667b19e3779f9ull};
+    inline constexpr uint64_t prime4{0x85ebca77c2b2ae63ull};
+
+    inline constexpr uint64_t rotl(uint64_t x, int r) {
+      return (x << r) | (x >> (64 - r));
+    }
+
+    inline constexpr uint64_t round(uint64_t lane, uint64_t word) {
+      return rotl(lane + word * prime2, 31) * prime1;
+    }
+
+    inline constexpr uint64_t avalanche(uint64_t h) {
+      h ^= h >> 33;
+      h *= prime2;
+      h ^= h >> 29;
+      h *= prime3;
+      h ^= h >> 32;
+      return h;
+    }
+
+    inline uint64_t hash_chunk(const std::byte* data, std::size_t size, uint64_t seed) {
+      constexpr std::size_t n_lanes{4};
+      uint64_t lanes[n_lanes] = {
+          seed + prime1 + prime2, seed + prime2, seed, seed - prime1};
+
+      const auto n_words = size / sizeof(uint64_t);
+      const auto n_stripes = n_words / n_lanes;
+      for (std::size_t stripe{}; stripe != n_stripes; ++stripe) {
+        uint64_t words[n_lanes];
+        std::memcpy(words, data + stripe * sizeof(words), sizeof(words));
+        for (std::size_t lane{}; lane != n_lanes; ++lane) {
+          lanes[lane] = round(lanes[lane], words[lane]);
+        }
+      }
+
+      uint64_t h{rotl(lanes[0], 1) + rotl(lanes[1], 7) + rotl(lanes[2], 12) +
+                 rotl(lanes[3], 18)};
+      for (std::size_t offset{n_stripes * n_lanes * sizeof(uint64_t)}; offset < size;
+           ++offset) {
+        h = rotl(h ^ (static_cast<uint64_t>(data[offset]) * prime4), 11) * prime1;
+      }
+      return avalanche(h + size);
+    }
+
+  }  // namespace detail
+
+  inline constexpr uint64_t hash_combine(uint64_t seed, uint64_t value) {
+    return detail::avalanche(detail::round(seed, value) + detail::prime4);
+  }
+
+  // Hashes a buffer using up to n_threads threads. If n_threads is zero, the number of
+  // hardware threads is used.
+  inline uint64_t hash_bytes(const void* data,
+                             std::size_t size,
+                             unsigned int n_threads = 0,
+                             uint64_t seed = 0) {
+    // the chunks are large enough for the threads to be worth spawning
+    constexpr std::size_t chunk_size{1 << 20};
+    const auto* bytes = static_cast<const std::byte*>(data);
+    if (size <= chunk_size) {
+      return detail::hash_chunk(bytes, size, seed);
+    }
+
+    const auto n_chunks = (size + chunk_size - 1) / chunk_size;
+    if (n_threads == 0) {
+      n_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    n_threads = static_cast<unsigned int>(
+        std::min<std::size_t>(n_chunks, static_cast<std::size_t>(n_threads)));
+
+    std::vector<uint64_t> chunk_hashes(n_chunks);
+    auto hash_chunks = [&](unsigned int thread) {
+      for (auto chunk = static_cast<std::size_t>(thread); chunk < n_chunks;
+           chunk += n_threads) {
+        const auto offset = chunk * chunk_size;
+        chunk_hashes[chunk] = detail::hash_chunk(
+            bytes + offset, std::min(chunk_size, size - offset), seed);
+      }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(n_threads - 1);
+    for (unsigned int thread{1}; thread < n_threads; ++thread) {
+      threads.emplace_back(hash_chunks, thread);
+    }
+    hash_chunks(0);
+    for (auto& thread : threads) {
+      thread.join();
+    }
+
+    return detail::hash_chunk(reinterpret_cast<const std::byte*>(chunk_hashes.data()),
+                              chunk_hashes.size() * sizeof(uint64_t),
+                              seed);
+  }
+
+}  // namespace clue
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "metrics.hpp"
+#include "validation.hpp"
+
+// Hierarchy of the clusters found at increasing scales, where each cluster is linked
+// to the cluster that contains it at the next coarser scale.
+namespace clue {
+
+  struct ClusterHierarchy {
+    // radii of the scales, in ascending order
+    std::vector<float> radii;
+    // cluster index and seed flag of each point at each scale
+    std::vector<std::vector<int>> cluster_indexes;
+    std::vector<std::vector<int>> is_seed;
+    // for each scale but the coarsest, the parent of each cluster at the next scale
+    std::vector<std::vector<int>> parents;
+  };
+
+  // Returns, for each cluster of the finer clustering, the cluster of the coarser one
+  // that contains most of its points, or -1 if all its points are outliers at the
+  // coarser scale. The ties are broken with the smallest index.
+  inline std::vector<int> compute_parents(std::span<const int> fine_clusters,
+                                          std::span<const int> coarse_clusters) {
+    if (fine_clusters.empty()) {
+      return {};
+    }
+    const auto table = contingency_table(fine_clusters, coarse_clusters);
+    const auto n_clusters = compute_nclusters(fine_clusters);
+
+    std::vector<int> parents(n_clusters, -1);
+    std::vector<int64_t> shared_points(n_clusters, 0);
+    for (const auto& [key, count] : table.cells) {
+      const auto fine = ContingencyTable::cluster_a(key);
+      const auto coarse = ContingencyTable::cluster_b(key);
+      if (fine < 0 or coarse < 0) {
+        continue;
+      }
+      if (count > shared_points[fine] or
+          (count == shared_points[fine] and coarse < parents[fine])) {
+        shared_points[fine] = count;
+        parents[fine] = coarse;
+      }
+    }
+    return parents;
+  }
+
+}  // namespace clue
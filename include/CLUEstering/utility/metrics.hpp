@@ -0,0 +1,187 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Metrics for comparing two clusterings of the same points, used for validating the
+// results against a reference. The outliers, which have cluster id -1, are treated as
+// a cluster of their own.
+namespace clue {
+
+  // Number of points shared by each pair of clusters of the two clusterings, together
+  // with the sizes of the clusters
+  struct ContingencyTable {
+    std::unordered_map<uint64_t, int64_t> cells;
+    std::unordered_map<int32_t, int64_t> sizes_a;
+    std::unordered_map<int32_t, int64_t> sizes_b;
+    int64_t n_points{};
+
+    static uint64_t key(int32_t cluster_a, int32_t cluster_b) {
+      return (static_cast<uint64_t>(static_cast<uint32_t>(cluster_a)) << 32) |
+             static_cast<uint32_t>(cluster_b);
+    }
+    static int32_t cluster_a(uint64_t key) { return static_cast<int32_t>(key >> 32); }
+    static int32_t cluster_b(uint64_t key) {
+      return static_cast<int32_t>(key & 0xffffffffu);
+    }
+  };
+
+  // Builds the contingency table by splitting the points in chunks, which are
+  // counted in parallel and then merged. If n_threads is zero, the number of hardware
+  // threads is used.
+  inline ContingencyTable contingency_table(std::span<const int> clusters_a,
+                                            std::span<const int> clusters_b,
+                                            unsigned int n_threads = 0) {
+    if (clusters_a.size() != clusters_b.size()) {
+      throw std::invalid_argument(
+          "The two clusterings must contain the same number of points");
+    }
+
+    const auto n_points = clusters_a.size();
+    if (n_threads == 0) {
+      n_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    // avoid spawning threads for chunks that are too small to be worth it
+    constexpr std::size_t min_chunk_size{1 << 16};
+    n_threads = static_cast<unsigned int>(std::clamp<std::size_t>(
+        n_points / min_chunk_size, 1, static_cast<std::size_t>(n_threads)));
+
+    std::vector<std::unordered_map<uint64_t, int64_t>> partial_cells(n_threads);
+    auto count_chunk = [&](unsigned int chunk) {
+      const auto begin = n_points * chunk / n_threads;
+      const auto end = n_points * (chunk + 1) / n_threads;
+      auto& cells = partial_cells[chunk];
+      for (auto i = begin; i != end; ++i) {
+        ++cells[ContingencyTable::key(clusters_a[i], clusters_b[i])];
+      }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(n_threads - 1);
+    for (unsigned int chunk{1}; chunk < n_threads; ++chunk) {
+      threads.emplace_back(count_chunk, chunk);
+    }
+    count_chunk(0);
+    for (auto& thread : threads) {
+      thread.join();
+    }
+
+    ContingencyTable table;
+    table.n_points = static_cast<int64_t>(n_points);
+    table.cells = std::move(partial_cells[0]);
+    for (unsigned int chunk{1}; chunk < n_threads; ++chunk) {
+      for (const auto& [key, count] : partial_cells[chunk]) {
+        table.cells[key] += count;
+      }
+    }
+    for (const auto& [key, count] : table.cells) {
+      table.sizes_a[ContingencyTable::cluster_a(key)] += count;
+      table.sizes_b[ContingencyTable::cluster_b(key)] += count;
+    }
+    return table;
+  }
+
+  inline double adjusted_rand_index(const ContingencyTable& table) {
+    auto pairs = [](int64_t n) { return 0.5 * static_cast<double>(n) * (n - 1); };
+
+    double index{};
+    for (const auto& [key, count] : table.cells) {
+      index += pairs(count);
+    }
+    double pairs_a{};
+    for (const auto& [cluster, size] : table.sizes_a) {
+      pairs_a += pairs(size);
+    }
+    double pairs_b{};
+    for (const auto& [cluster, size] : table.sizes_b) {
+      pairs_b += pairs(size);
+    }
+
+    const auto total_pairs = pairs(table.n_points);
+    if (total_pairs == 0.) {
+      return 1.;
+    }
+    const auto expected_index = pairs_a * pairs_b / total_pairs;
+    const auto max_index = 0.5 * (pairs_a + pairs_b);
+    // identical trivial clusterings, e.g. all the points in a single cluster
+    if (max_index == expected_index) {
+      return 1.;
+    }
+    return (index - expected_index) / (max_index - expected_index);
+  }
+
+  // Mutual information normalized by the arithmetic mean of the two entropies
+  inline double normalized_mutual_information(const ContingencyTable& table) {
+    const auto n = static_cast<double>(table.n_points);
+    auto entropy = [n](const std::unordered_map<int32_t, int64_t>& sizes) {
+      double h{};
+      for (const auto& [cluster, size] : sizes) {
+        const auto p = size / n;
+        h -= p * std::log(p);
+      }
+      return h;
+    };
+
+    double mutual_information{};
+    for (const auto& [key, count] : table.cells) {
+      const auto size_a = table.sizes_a.at(ContingencyTable::cluster_a(key));
+      const auto size_b = table.sizes_b.at(ContingencyTable::cluster_b(key));
+      mutual_information +=
+          count / n * std::log(n * count / (static_cast<double>(size_a) * size_b));
+    }
+
+    const auto mean_entropy = 0.5 * (entropy(table.sizes_a) + entropy(table.sizes_b));
+    if (mean_entropy == 0.) {
+      return 1.;
+    }
+    return std::max(0., mutual_information) / mean_entropy;
+  }
+
+  // For each cluster of the first clustering, the fraction of its points found in the
+  // cluster of the second clustering that shares most points with it. The vector is
+  // indexed by the cluster id and the outliers are not included.
+  inline std::vector<double> cluster_match_fractions(const ContingencyTable& table) {
+    int32_t n_clusters{};
+    for (const auto& [cluster, size] : table.sizes_a) {
+      n_clusters = std::max(n_clusters, cluster + 1);
+    }
+
+    std::vector<int64_t> best_match(n_clusters, 0);
+    for (const auto& [key, count] : table.cells) {
+      const auto cluster = ContingencyTable::cluster_a(key);
+      if (cluster > -1) {
+        best_match[cluster] = std::max(best_match[cluster], count);
+      }
+    }
+
+    std::vector<double> fractions(n_clusters, 0.);
+    for (int32_t cluster{}; cluster != n_clusters; ++cluster) {
+      const auto it = table.sizes_a.find(cluster);
+      if (it != table.sizes_a.end()) {
+        fractions[cluster] = static_cast<double>(best_match[cluster]) / it->second;
+      }
+    }
+    return fractions;
+  }
+
+  inline double adjusted_rand_index(std::span<const int> clusters_a,
+                                    std::span<const int> clusters_b,
+                                    unsigned int n_threads = 0) {
+    return adjusted_rand_index(contingency_table(clusters_a, clusters_b, n_threads));
+  }
+
+  inline double normalized_mutual_information(std::span<const int> clusters_a,
+                                              std::span<const int> clusters_b,
+                                              unsigned int n_threads = 0) {
+    return normalized_mutual_information(
+        contingency_table(clusters_a, clusters_b, n_threads));
+  }
+
+}  // namespace clue
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "tmp_path.hpp"
+
+// Cache of the results of the clustering, indexed by a hash of the points and of the
+// parameters, which allows to skip the clustering when the same inputs are processed
+// again. The results are kept in memory and, if a directory is given, also written to
+// disk, so that they can be reused by other processes.
+// The results of a clustering are the cluster indexes of the points followed by their
+// seed flags, as they are stored in the results buffer of the points.
+namespace clue {
+
+  class ResultCache {
+  public:
+    ResultCache() = default;
+    explicit ResultCache(std::filesystem::path directory)
+        : m_directory{std::move(directory)} {
+      std::filesystem::create_directories(*m_directory);
+    }
+
+    // Copies the cached results in the buffer and returns true if the key is found,
+    // otherwise leaves the buffer unchanged
+    bool find(uint64_t key, int* results, std::size_t size) {
+      std::lock_guard<std::mutex> lock{m_mutex};
+      auto it = m_results.find(key);
+      if (it == m_results.end()) {
+        auto loaded = load(key, size);
+        if (!loaded.has_value()) {
+          return false;
+        }
+        it = m_results.emplace(key, std::move(*loaded)).first;
+      }
+      if (it->second.size() != size) {
+        return false;
+      }
+      std::copy(it->second.begin(), it->second.end(), results);
+      return true;
+    }
+
+    void store(uint64_t key, const int* results, std::size_t size) {
+      std::lock_guard<std::mutex> lock{m_mutex};
+      m_results[key] = std::vector<int>(results, results + size);
+      if (m_directory.has_value()) {
+        save(key, results, size);
+      }
+    }
+
+    std::size_t size() const {
+      std::lock_guard<std::mutex> lock{m_mutex};
+      return m_results.size();
+    }
+
+    // Removes the results kept in memory, the files written to disk are kept
+    void clear() {
+      std::lock_guard<std::mutex> lock{m_mutex};
+      m_results.clear();
+    }
+
+  private:
+    std::unordered_map<uint64_t, std::vector<int>> m_results;
+    std::optional<std::filesystem::path> m_directory;
+    mutable std::mutex m_mutex;
+
+    std::filesystem::path file_path(uint64_t key) const {
+      char name[32];
+      std::snprintf(
+          name, sizeof(name), "%016llx.clue", static_cast<unsigned long long>(key));
+      return *m_directory / name;
+    }
+
+    std::optional<std::vector<int>> load(uint64_t key, std::size_t size) const {
+      if (!m_directory.has_value()) {
+        return std::nullopt;
+      }
+      std::ifstream in{file_path(key), std::ios::binary};
+      uint64_t stored_size{};
+      if (!in.read(reinterpret_cast<char*>(&stored_size), sizeof(stored_size)) or
+          stored_size != size) {
+        return std::nullopt;
+      }
+      std::vector<int> results(size);
+      // a truncated file is treated as a miss and overwritten by the next store
+      if (!in.read(reinterpret_cast<char*>(results.data()), size * sizeof(int))) {
+        return std::nullopt;
+      }
+      return results;
+    }
+
+    void save(uint64_t key, const int* results, std::size_t size) const {
+      // written to a temporary file first, so that other processes never read a
+      // partially written file, and the concurrent writers never share it
+      const auto path = file_path(key);
+      const auto tmp_path = unique_tmp_path(path);
+      {
+        std::ofstream out{tmp_path, std::ios::binary};
+        const uint64_t stored_size{size};
+        out.write(reinterpret_cast<const char*>(&stored_size), sizeof(stored_size));
+        out.write(reinterpret_cast<const char*>(results), size * sizeof(int));
+        if (!out) {
+          throw std::runtime_error("Error while writing the result cache");
+        }
+      }
+      std::filesystem::rename(tmp_path, path);
+    }
+  };
+
+}  // namespace clue
@@ -0,0 +1,51 @@
+#include "utility/hash.hpp"
+#include "utility/result_cache.hpp"
+
+#include <cstddef>
+#include <filesystem>
+#include <vector>
+
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+
+TEST_CASE("Test that the hash doesn't depend on the number of threads") {
+  // large enough to be split in several chunks, with a partial last one
+  std::vector<float> buffer((5 << 20) + 3);
+  for (std::size_t i{}; i < buffer.size(); ++i) {
+    buffer[i] = static_cast<float>(i % 1000) * 0.1f;
+  }
+  const auto size = buffer.size() * sizeof(float);
+
+  const auto hash = clue::hash_bytes(buffer.data(), size, 1);
+  CHECK(clue::hash_bytes(buffer.data(), size, 3) == hash);
+  CHECK(clue::hash_bytes(buffer.data(), size, 8) == hash);
+
+  buffer.back() += 1.f;
+  CHECK(clue::hash_bytes(buffer.data(), size, 3) != hash);
+  CHECK(clue::hash_bytes(buffer.data(), size - 1, 3) != hash);
+}
+
+TEST_CASE("Test the result cache") {
+  const auto directory = std::filesystem::temp_directory_path() / "clue_test_cache";
+  std::filesystem::remove_all(directory);
+
+  const std::vector<int> results{0, 1, -1, 1, 1, 0, 0, 1};
+  std::vector<int> found(results.size(), 0);
+  {
+    clue::ResultCache cache{directory};
+    CHECK(!cache.find(42, found.data(), found.size()));
+    cache.store(42, results.data(), results.size());
+    CHECK(cache.find(42, found.data(), found.size()));
+    CHECK(found == results);
+    // the number of points is part of the key
+    CHECK(!cache.find(42, found.data(), found.size() - 2));
+  }
+
+  // the results written to disk are found by a new cache
+  std::vector<int> loaded(results.size(), 0);
+  clue::ResultCache cache{directory};
+  CHECK(cache.find(42, loaded.data(), loaded.size()));
+  CHECK(loaded == results);
+
+  std::filesystem::remove_all(directory);
+}
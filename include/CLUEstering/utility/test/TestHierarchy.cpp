@@ -0,0 +1,25 @@
+#include "utility/hierarchy.hpp"
+
+#include <vector>
+
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+
+TEST_CASE("Test the parents of nested clusters") {
+  // the clusters 0 and 1 merge at the coarser scale, the cluster 2 is kept
+  const std::vector<int> fine{0, 0, 1, 1, -1, 2, 2};
+  const std::vector<int> coarse{1, 1, 1, 1, 1, 0, 0};
+
+  const auto parents = clue::compute_parents(fine, coarse);
+  CHECK(parents == std::vector<int>{1, 1, 0});
+}
+
+TEST_CASE("Test the parents of clusters split between coarser clusters") {
+  // the cluster 0 is split and its parent is the one with most of its points, the
+  // cluster 1 is tied and the cluster 2 only contains outliers at the coarser scale
+  const std::vector<int> fine{0, 0, 0, 1, 1, 2};
+  const std::vector<int> coarse{2, 1, 1, 2, 0, -1};
+
+  const auto parents = clue::compute_parents(fine, coarse);
+  CHECK(parents == std::vector<int>{1, 0, -1});
+}
@@ -0,0 +1,66 @@
+#include "utility/metrics.hpp"
+#include "utility/validation.hpp"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+
+TEST_CASE("Test the comparison of identical clusterings") {
+  const auto n = 1 << 18;
+  std::mt19937 gen(42);
+  std::uniform_int_distribution<int> dist(-1, 99);
+  std::vector<int> labels(n);
+  std::generate(labels.begin(), labels.end(), [&]() { return dist(gen); });
+
+  // relabel the clusters, which doesn't change the clustering
+  std::vector<int> relabelled(n);
+  std::ranges::transform(labels, relabelled.begin(), [](int label) {
+    return label == -1 ? -1 : 99 - label;
+  });
+
+  CHECK(clue::adjusted_rand_index(labels, relabelled, 4) == doctest::Approx(1.));
+  CHECK(clue::normalized_mutual_information(labels, relabelled, 4) ==
+        doctest::Approx(1.));
+  CHECK(clue::validate_results(labels, relabelled));
+
+  const auto fractions =
+      clue::cluster_match_fractions(clue::contingency_table(labels, relabelled));
+  CHECK(fractions.size() == 100);
+  CHECK(std::ranges::all_of(fractions, [](double f) { return f == 1.; }));
+}
+
+TEST_CASE("Test the comparison of different clusterings") {
+  // example with known values of the indexes
+  const std::vector<int> labels_a{0, 0, 0, 1, 1, 1};
+  const std::vector<int> labels_b{0, 0, 1, 1, 2, 2};
+
+  CHECK(clue::adjusted_rand_index(labels_a, labels_b) == doctest::Approx(0.24242424));
+  CHECK(clue::normalized_mutual_information(labels_a, labels_b) ==
+        doctest::Approx(0.51580374));
+
+  const auto fractions =
+      clue::cluster_match_fractions(clue::contingency_table(labels_a, labels_b));
+  CHECK(fractions[0] == doctest::Approx(2. / 3.));
+  CHECK(fractions[1] == doctest::Approx(2. / 3.));
+
+  std::vector<int> results(labels_b);
+  CHECK(!clue::validate_results(results, labels_a));
+}
+
+TEST_CASE("Test that the result doesn't depend on the number of threads") {
+  const auto n = 1 << 20;
+  std::mt19937 gen(0);
+  std::uniform_int_distribution<int> dist(-1, 999);
+  std::vector<int> labels_a(n);
+  std::vector<int> labels_b(n);
+  std::generate(labels_a.begin(), labels_a.end(), [&]() { return dist(gen); });
+  std::ranges::transform(labels_a, labels_b.begin(), [&](int label) {
+    return dist(gen) < 100 ? dist(gen) : label;
+  });
+
+  const auto serial = clue::adjusted_rand_index(labels_a, labels_b, 1);
+  CHECK(clue::adjusted_rand_index(labels_a, labels_b, 8) == doctest::Approx(serial));
+}
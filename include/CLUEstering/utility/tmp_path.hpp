@@ -0,0 +1,31 @@
+#pragma once
+
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <thread>
+
+#if defined(_WIN32)
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace clue {
+
+  // Returns the path of a temporary file next to path, whose name is unique to the
+  // calling process and thread, so that concurrent writers of the same file never
+  // write to the same temporary file before renaming it
+  inline std::filesystem::path unique_tmp_path(const std::filesystem::path& path) {
+#if defined(_WIN32)
+    const auto pid = _getpid();
+#else
+    const auto pid = getpid();
+#endif
+    const auto thread = std::hash<std::thread::id>{}(std::this_thread::get_id());
+    auto tmp_path = path;
+    tmp_path += "." + std::to_string(pid) + "." + std::to_string(thread) + ".tmp";
+    return tmp_path;
+  }
+
+}  // namespace clue